@@ -14,6 +14,7 @@
 
 #include <driverlib.h>
 #include "adc.h"
+#include "scan.h"
 
 void Init_GPIO_For_ADC12_B_All_AI()
 {
@@ -80,17 +81,18 @@ void Init_Enable_ADC12_B()
     // Initialize the ADC12B Module
     /*
     * Base address of ADC12B Module
-    * Use internal ADC12B bit as sample/hold signal to start conversion
+    * Use TA0.1 output as sample/hold signal, one sequence per scan slot
     * USE MODOSC 5MHZ Digital Oscillator as clock source
     * Use default clock divider/pre-divider of 1
-    * Not use internal channel
+    * Map the temperature sensor to A30 and AVcc/2 to A31 for the health
+    * suite
     */
     ADC12_B_initParam initParam = {0};
-    initParam.sampleHoldSignalSourceSelect = ADC12_B_SAMPLEHOLDSOURCE_SC;
+    initParam.sampleHoldSignalSourceSelect = ADC12_B_SAMPLEHOLDSOURCE_1;
     initParam.clockSourceSelect = ADC12_B_CLOCKSOURCE_ADC12OSC;
     initParam.clockSourceDivider = ADC12_B_CLOCKDIVIDER_1;
     initParam.clockSourcePredivider = ADC12_B_CLOCKPREDIVIDER__1;
-    initParam.internalChannelMap = ADC12_B_NOINTCH;
+    initParam.internalChannelMap = ADC12_B_TEMPSENSEMAP + ADC12_B_BATTMAP;
     ADC12_B_init(ADC12_B_BASE, &initParam);
 
     // Enable the ADC12B module
@@ -108,247 +110,289 @@ void Init_Enable_ADC12_B()
       ADC12_B_MULTIPLESAMPLESENABLE);
 }
 
-void Config_Mem_Buffers()
+static uint16_t Scan_Timer_Period(uint16_t slotHz)
 {
+    return (uint16_t)((ADC_TIMER_HZ / slotHz) - 1);
+}
 
-    // Configure Memory Buffers
+void Init_Scan_Timer(uint16_t slotHz)
+{
     /*
-    * Base address of the ADC12B Module
-    * Configure memory buffer 0
-    * Map input A0 to memory buffer 0
-    * Vref+ = AVcc
-    * Vref- = EXT Positive
-    * Memory buffer 0 is not the end of a sequence
-    */
-    ADC12_B_configureMemoryParam param0 = {0};
-    param0.memoryBufferControlIndex = ADC12_B_MEMORY_0;
-    param0.inputSourceSelect = ADC12_B_INPUT_A0;
-    param0.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param0.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE, &param0);
+     * Base address of Timer_A0
+     * SMCLK divided down to ADC_TIMER_HZ, up mode, one period per scan
+     * slot
+     * TA0.1 in reset/set mode rises at the end of each period, which
+     * is the ADC12SHS_1 trigger.
+     * ADC12_B trigger table in Reference 1.
+     */
+    uint16_t period = Scan_Timer_Period(slotHz);
 
-    /*
-    * Base address of the ADC12B Module
-    * Configure memory buffer 1
-    * Map input A1 to memory buffer 1
-    * Vref+ = AVcc
-    * Vref- = EXT Positive
-    * Memory buffer 1 is not the end of a sequence
-    */
-    ADC12_B_configureMemoryParam param1 = {0};
-    param1.memoryBufferControlIndex = ADC12_B_MEMORY_1;
-    param1.inputSourceSelect = ADC12_B_INPUT_A1;
-    param1.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param1.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE, &param1);
+    Timer_A_initCompareModeParam compareParam = {0};
+    compareParam.compareRegister = TIMER_A_CAPTURECOMPARE_REGISTER_1;
+    compareParam.compareInterruptEnable = TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE;
+    compareParam.compareOutputMode = TIMER_A_OUTPUTMODE_RESET_SET;
+    compareParam.compareValue = period / 2;
+    Timer_A_initCompareMode(TIMER_A0_BASE, &compareParam);
 
-    /*
-    * Base address of the ADC12B Module
-    * Configure memory buffer 2
-    * Map input A2 to memory buffer 2
-    * Vref+ = AVcc
-    * Vref- = EXT Positive
-    * Memory buffer 2 is not the end of a sequence
-    */
-    ADC12_B_configureMemoryParam param2 = {0};
-    param2.memoryBufferControlIndex = ADC12_B_MEMORY_2;
-    param2.inputSourceSelect = ADC12_B_INPUT_A2;
-    param2.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param2.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE, &param2);
+    Timer_A_initUpModeParam upParam = {0};
+    upParam.clockSource = TIMER_A_CLOCKSOURCE_SMCLK;
+    upParam.clockSourceDivider = CLOCK_TIMER_A_TICK;
+    upParam.timerPeriod = period;
+    upParam.timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_DISABLE;
+    upParam.captureCompareInterruptEnable_CCR0_CCIE =
+        TIMER_A_CCIE_CCR0_INTERRUPT_DISABLE;
+    upParam.timerClear = TIMER_A_DO_CLEAR;
+    upParam.startTimer = true;
+    Timer_A_initUpMode(TIMER_A0_BASE, &upParam);
+}
 
+void Retime_Scan_Timer(uint16_t slotHz)
+{
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 3
-     * Map input A3 to memory buffer 3
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 3 is not the end of a sequence
+     * Changes the slot rate of the running timer from ADC12ISR, right
+     * after a slot's results are in. Rather than race the count against
+     * the new period, the timer restarts from zero, so the first new
+     * period runs from here: one slot comes out long, none is lost.
+     * TA0.1 resets at the new CCR1 if it hasn't already, so its next
+     * rising edge, the next trigger, is at the new CCR0.
      */
-    ADC12_B_configureMemoryParam param3 = {0};
-    param3.memoryBufferControlIndex = ADC12_B_MEMORY_3;
-    param3.inputSourceSelect = ADC12_B_INPUT_A3;
-    param3.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param3.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param3);
+    uint16_t period = Scan_Timer_Period(slotHz);
 
-    /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 4
-     * Map input A4 to memory buffer 4
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 4 is not the end of a sequence
-     */
-    ADC12_B_configureMemoryParam param4 = {0};
-    param4.memoryBufferControlIndex = ADC12_B_MEMORY_4;
-    param4.inputSourceSelect = ADC12_B_INPUT_A4;
-    param4.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param4.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param4);
+    HWREG16(TIMER_A0_BASE + OFS_TAxCCR0) = period;
+    HWREG16(TIMER_A0_BASE + OFS_TAxCCR1) = period / 2;
+    HWREG16(TIMER_A0_BASE + OFS_TAxCTL) |= TACLR;
+}
 
+void Config_Sample_Hold(uint8_t sampleHoldLow, uint8_t sampleHoldHigh)
+{
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 5
-     * Map input A5 to memory buffer 5
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 5 is not the end of a sequence
+     * ADC12SHT0x (memory buffers 0-7) and ADC12SHT1x (8-15), written
+     * directly as they are set from ADC12ISR. Like ADC12MCTLx they can
+     * only change with ADC12ENC clear.
+     * ADC12CTL0 register description in Reference 3.
      */
-    ADC12_B_configureMemoryParam param5 = {0};
-    param5.memoryBufferControlIndex = ADC12_B_MEMORY_5;
-    param5.inputSourceSelect = ADC12_B_INPUT_A5;
-    param5.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param5.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param5);
+    uint8_t enabled = HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) & ADC12ENC;
 
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) &= ~ADC12ENC;
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_H) =
+        (uint8_t)((sampleHoldLow & 0x0F) | ((sampleHoldHigh & 0x0F) << 4));
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) |= enabled;
+}
+
+uint16_t Config_Mem_Buffers_For_Slot(uint16_t mask)
+{
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 6
-     * Map input A6 to memory buffer 6
+     * Map the channels in mask, lowest first, to memory buffers 0..n-1
+     * and end the sequence on the last one. Called from ADC12ISR
+     * between slots, so this writes ADC12MCTLx directly; a driverlib
+     * ADC12_B_configureMemory() call per buffer costs too much there.
      * Vr+ = AVcc
      * Vr- = AVss
-     * Memory buffer 6 is not the end of a sequence
+     *
+     * ADC12MCTLx can only be written with ADC12ENC clear, so conversions
+     * are held off meanwhile, which also re-arms the sequence for the
+     * next trigger. The timer keeps running; the next trigger edge must
+     * not arrive until this returns.
+     *
+     * An empty slot still needs one conversion to keep the slots
+     * ticking, so it converts A0 as filler and ADC12ISR ignores it.
      */
-    ADC12_B_configureMemoryParam param6 = {0};
-    param6.memoryBufferControlIndex = ADC12_B_MEMORY_6;
-    param6.inputSourceSelect = ADC12_B_INPUT_A6;
-    param6.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param6.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param6);
+    uint8_t enabled = HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) & ADC12ENC;
+    uint16_t memory = 0;
+    uint16_t channel;
+
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) &= ~ADC12ENC;
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        if (mask & ((uint16_t)1 << channel))
+        {
+            HWREG16(ADC12_B_BASE + OFS_ADC12MCTL0 + (2 * memory)) =
+                ADC12_B_INPUT_A0 + channel +
+                ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
+            memory++;
+        }
+    }
+
+    if (memory == 0)
+    {
+        HWREG16(ADC12_B_BASE + OFS_ADC12MCTL0) =
+            ADC12_B_INPUT_A0 + ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
+        memory = 1;
+    }
 
+    // Memory buffer n-1 IS the end of a sequence
+    HWREG16(ADC12_B_BASE + OFS_ADC12MCTL0 + (2 * (memory - 1))) |=
+        ADC12_B_ENDOFSEQUENCE;
+
+    // Interrupt on the last buffer only
+    HWREG16(ADC12_B_BASE + OFS_ADC12IFGR0) = 0;
+    HWREG16(ADC12_B_BASE + OFS_ADC12IER0) = (uint16_t)1 << (memory - 1);
+
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) |= enabled;
+
+    return memory;
+}
+
+void Rearm_Scan_Sequence()
+{
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 7
-     * Map input A7 to memory buffer 7
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 7 is not the end of a sequence
+     * In single sequence-of-channels mode with a trigger other than
+     * ADC12SC, ADC12_B ignores further triggers after a sequence until
+     * ADC12ENC is cleared and set again. Called from ADC12ISR at the end
+     * of every slot Config_Mem_Buffers_For_Slot() doesn't already do it.
+     * Sequence-of-Channels Mode in Reference 3.
      */
-    ADC12_B_configureMemoryParam param7 = {0};
-    param7.memoryBufferControlIndex = ADC12_B_MEMORY_7;
-    param7.inputSourceSelect = ADC12_B_INPUT_A7;
-    param7.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param7.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param7);
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) &= ~ADC12ENC;
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) |= ADC12ENC;
+}
 
+uint16_t Scan_Ticks_To_Trigger()
+{
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 8
-     * Map input A8 to memory buffer 8
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 8 is not the end of a sequence
+     * Timer_A0 ticks left before TA0.1 rises at CCR0 and triggers the
+     * next slot, or 0 if the ADC is already converting, or TAIFG has
+     * set since Control_Run() cleared it, which both mean that trigger
+     * is late and has already happened.
      */
-    ADC12_B_configureMemoryParam param8 = {0};
-    param8.memoryBufferControlIndex = ADC12_B_MEMORY_8;
-    param8.inputSourceSelect = ADC12_B_INPUT_A8;
-    param8.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param8.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param8);
+    if ((HWREG16(ADC12_B_BASE + OFS_ADC12CTL1) & ADC12BUSY) ||
+        (HWREG16(TIMER_A0_BASE + OFS_TAxCTL) & TAIFG))
+    {
+        return 0;
+    }
 
+    return HWREG16(TIMER_A0_BASE + OFS_TAxCCR0) -
+           HWREG16(TIMER_A0_BASE + OFS_TAxR);
+}
+
+void Start_Internal_Sequence(uint8_t sampleHold)
+{
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 9
-     * Map input A9 to memory buffer 9
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 9 is not the end of a sequence
+     * Converts the temperature sensor and AVcc/2 into memory buffers
+     * 30 and 31 against the 2.0 V reference, started in software from
+     * ADC12ISR in the idle tail of a scan slot. ADC12IFG31 interrupts
+     * when both are in. The sample/hold time is shared with buffers
+     * 0-7, and like the trigger source can only change with ADC12ENC
+     * clear; End_Internal_Sequence() puts the scan's back.
+     * ADC12CTL1, ADC12CTL3 and ADC12MCTLx register descriptions in
+     * Reference 3.
      */
-    ADC12_B_configureMemoryParam param9 = {0};
-    param9.memoryBufferControlIndex = ADC12_B_MEMORY_9;
-    param9.inputSourceSelect = ADC12_B_INPUT_A9;
-    param9.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param9.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param9);
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) &= ~ADC12ENC;
+
+    HWREG16(ADC12_B_BASE + OFS_ADC12CTL1) &= ~ADC12SHS_7;
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_H) =
+        (uint8_t)((HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_H) & 0xF0) |
+                  (sampleHold & 0x0F));
+    HWREG16(ADC12_B_BASE + OFS_ADC12CTL3) =
+        (HWREG16(ADC12_B_BASE + OFS_ADC12CTL3) & ~ADC12CSTARTADD_31) |
+        ADC_HEALTH_MEMORY;
+
+    HWREG16(ADC12_B_BASE + OFS_ADC12MCTL0 + (2 * ADC_HEALTH_MEMORY)) =
+        ADC12_B_INPUT_TCMAP + ADC12_B_VREFPOS_INTBUF_VREFNEG_VSS;
+    HWREG16(ADC12_B_BASE + OFS_ADC12MCTL0 + (2 * (ADC_HEALTH_MEMORY + 1))) =
+        ADC12_B_INPUT_BATMAP + ADC12_B_VREFPOS_INTBUF_VREFNEG_VSS +
+        ADC12_B_ENDOFSEQUENCE;
+
+    HWREG16(ADC12_B_BASE + OFS_ADC12IFGR1) = 0;
+    HWREG16(ADC12_B_BASE + OFS_ADC12IER1) = ADC12IE31;
 
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) |= ADC12ENC + ADC12SC;
+}
+
+void End_Internal_Sequence(uint8_t sampleHoldLow)
+{
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 10
-     * Map input A10 to memory buffer 10
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 10 is not the end of a sequence
+     * Back to the scan: TA0.1 triggers, sequences from buffer 0 and
+     * the scan's sample/hold time for buffers 0-7.
      */
-    ADC12_B_configureMemoryParam param10 = {0};
-    param10.memoryBufferControlIndex = ADC12_B_MEMORY_10;
-    param10.inputSourceSelect = ADC12_B_INPUT_A10;
-    param10.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param10.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param10);
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) &= ~ADC12ENC;
 
+    HWREG16(ADC12_B_BASE + OFS_ADC12IER1) = 0;
+    HWREG16(ADC12_B_BASE + OFS_ADC12IFGR1) = 0;
+    HWREG16(ADC12_B_BASE + OFS_ADC12CTL3) &= ~ADC12CSTARTADD_31;
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_H) =
+        (uint8_t)((HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_H) & 0xF0) |
+                  (sampleHoldLow & 0x0F));
+    HWREG16(ADC12_B_BASE + OFS_ADC12CTL1) |= ADC12SHS_1;
+
+    HWREG8(ADC12_B_BASE + OFS_ADC12CTL0_L) |= ADC12ENC;
+}
+
+void Stop_Scan()
+{
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 11
-     * Map input A11 to memory buffer 11
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 11 is not the end of a sequence
+     * Stop the slot triggers, then abort whatever the ADC is in the
+     * middle of. Init_Enable_ADC12_B() and a new sequence start the
+     * scan again.
      */
-    ADC12_B_configureMemoryParam param11 = {0};
-    param11.memoryBufferControlIndex = ADC12_B_MEMORY_11;
-    param11.inputSourceSelect = ADC12_B_INPUT_A11;
-    param11.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param11.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param11);
+    Timer_A_stop(TIMER_A0_BASE);
+    ADC12_B_disableConversions(ADC12_B_BASE, ADC12_B_PREEMPTCONVERSION);
+    HWREG16(ADC12_B_BASE + OFS_ADC12IER0) = 0;
+    HWREG16(ADC12_B_BASE + OFS_ADC12IFGR0) = 0;
+    HWREG16(ADC12_B_BASE + OFS_ADC12IER1) = 0;
+    HWREG16(ADC12_B_BASE + OFS_ADC12IFGR1) = 0;
+}
 
+void Config_ADC12_B_For_Burst(uint8_t channel, uint16_t sampleHold)
+{
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 12
-     * Map input A12 to memory buffer 12
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 12 is not the end of a sequence
+     * Base address of ADC12B Module
+     * Software start, free running from then on
+     * Same clock as the scan, MODOSC undivided
      */
-    ADC12_B_configureMemoryParam param12 = {0};
-    param12.memoryBufferControlIndex = ADC12_B_MEMORY_12;
-    param12.inputSourceSelect = ADC12_B_INPUT_A12;
-    param12.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param12.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param12);
+    ADC12_B_initParam initParam = {0};
+    initParam.sampleHoldSignalSourceSelect = ADC12_B_SAMPLEHOLDSOURCE_SC;
+    initParam.clockSourceSelect = ADC12_B_CLOCKSOURCE_ADC12OSC;
+    initParam.clockSourceDivider = ADC12_B_CLOCKDIVIDER_1;
+    initParam.clockSourcePredivider = ADC12_B_CLOCKPREDIVIDER__1;
+    initParam.internalChannelMap = ADC12_B_NOINTCH;
+    ADC12_B_init(ADC12_B_BASE, &initParam);
+
+    // The init leaves the module off, enable it again
+    ADC12_B_enable(ADC12_B_BASE);
 
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 13
-     * Map input A13 to memory buffer 13
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 13 is not the end of a sequence
+     * Base address of ADC12B Module
+     * Only memory buffer 0 is used, at sampleHold
+     * Enable Multiple Sampling, each conversion starts as soon as the
+     * last one finishes
      */
-    ADC12_B_configureMemoryParam param13 = {0};
-    param13.memoryBufferControlIndex = ADC12_B_MEMORY_13;
-    param13.inputSourceSelect = ADC12_B_INPUT_A13;
-    param13.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param13.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param13);
+    ADC12_B_setupSamplingTimer(ADC12_B_BASE,
+      sampleHold,
+      sampleHold,
+      ADC12_B_MULTIPLESAMPLESENABLE);
 
     /*
      * Base address of the ADC12B Module
-     * Configure memory buffer 14
-     * Map input A14 to memory buffer 14
+     * Configure memory buffer 0
+     * Map input channel to memory buffer 0
      * Vr+ = AVcc
      * Vr- = AVss
-     * Memory buffer 14 is not the end of a sequence
+     * Memory buffer 0 IS the end of a sequence
      */
-    ADC12_B_configureMemoryParam param14 = {0};
-    param14.memoryBufferControlIndex = ADC12_B_MEMORY_14;
-    param14.inputSourceSelect = ADC12_B_INPUT_A14;
-    param14.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param14.endOfSequence = ADC12_B_NOTENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param14);
+    ADC12_B_configureMemoryParam configureMemoryParam = {0};
+    configureMemoryParam.memoryBufferControlIndex = ADC12_B_MEMORY_0;
+    configureMemoryParam.inputSourceSelect = ADC12_B_INPUT_A0 + channel;
+    configureMemoryParam.refVoltageSourceSelect =
+        ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
+    configureMemoryParam.endOfSequence = ADC12_B_ENDOFSEQUENCE;
+    configureMemoryParam.windowComparatorSelect =
+        ADC12_B_WINDOW_COMPARATOR_DISABLE;
+    configureMemoryParam.differentialModeSelect =
+        ADC12_B_DIFFERENTIAL_MODE_DISABLE;
+    ADC12_B_configureMemory(ADC12_B_BASE, &configureMemoryParam);
+
+    // Results go by DMA, no per-conversion interrupt
+    HWREG16(ADC12_B_BASE + OFS_ADC12IFGR0) = 0;
+    HWREG16(ADC12_B_BASE + OFS_ADC12IER0) = 0;
 
     /*
-     * Base address of the ADC12B Module
-     * Configure memory buffer 15
-     * Map input A15 to memory buffer 15
-     * Vr+ = AVcc
-     * Vr- = AVss
-     * Memory buffer 15 IS the end of a sequence
+     * The init cleared these too. An overflow is a result the DMA
+     * missed, counted in burstOverflows by ADC12ISR.
      */
-    ADC12_B_configureMemoryParam param15 = {0};
-    param15.memoryBufferControlIndex = ADC12_B_MEMORY_15;
-    param15.inputSourceSelect = ADC12_B_INPUT_A15;
-    param15.refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS;
-    param15.endOfSequence = ADC12_B_ENDOFSEQUENCE;
-    ADC12_B_configureMemory(ADC12_B_BASE ,&param15);
+    ADC12_B_clearInterrupt(ADC12_B_BASE, 2, ADC12_B_OVIFG + ADC12_B_TOVIFG);
+    ADC12_B_enableInterrupt(ADC12_B_BASE,
+      0,
+      0,
+      ADC12_B_OVIE + ADC12_B_TOVIE);
 }
@@ -15,10 +15,34 @@
 #ifndef AI_SCANNER_ADC_H_
 #define AI_SCANNER_ADC_H_
 
+#include <stdint.h>
+#include "clock.h"
+
+/*
+ * Timer_A0 paces the scan slots from SMCLK, divided down to the same
+ * 1 MHz tick in every clock profile.
+ */
+#define ADC_TIMER_HZ    CLOCK_TICK_HZ
+
+/*
+ * The health suite's internal channels convert into memory buffers 30
+ * and 31, clear of the scan's 0-15.
+ */
+#define ADC_HEALTH_MEMORY   30
+
 extern volatile unsigned char conf;
 
 void Init_GPIO_For_ADC12_B_All_AI(void);
 void Init_Enable_ADC12_B(void);
-void Config_Mem_Buffers(void);
+void Init_Scan_Timer(uint16_t slotHz);
+void Retime_Scan_Timer(uint16_t slotHz);
+void Config_Sample_Hold(uint8_t sampleHoldLow, uint8_t sampleHoldHigh);
+uint16_t Config_Mem_Buffers_For_Slot(uint16_t mask);
+void Rearm_Scan_Sequence(void);
+uint16_t Scan_Ticks_To_Trigger(void);
+void Start_Internal_Sequence(uint8_t sampleHold);
+void End_Internal_Sequence(uint8_t sampleHoldLow);
+void Stop_Scan(void);
+void Config_ADC12_B_For_Burst(uint8_t channel, uint16_t sampleHold);
 
 #endif /* AI_SCANNER_ADC_H_ */
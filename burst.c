@@ -0,0 +1,235 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Single-channel burst capture at the ADC12_B's full rate.
+ *
+ * For inrush and switching transients. Pressing S2 (P1.2) on the
+ * LaunchPad, or Burst_Arm(), stops the timer-paced scan and switches
+ * ADC12_B to repeat-single-channel, free running with the shortest
+ * usable sample/hold. No ISR could keep up with a result every ~5 us,
+ * so DMA channel 0, triggered by each ADC12 result (trigger 26, see
+ * the DMA trigger assignments in Reference 1), moves them straight into
+ * a FRAM buffer. When the buffer is full the DMA interrupt stops the
+ * ADC, main() puts the normal scan back and streams the burst out over
+ * the link as WIRE_TYPE_BURST_* records.
+ *
+ * The achieved rate comes from the timestamp clock over the whole
+ * burst. ADC12 overflows during the burst mean the DMA missed a result,
+ * so a burst with none has no gaps.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#include <driverlib.h>
+#include "burst.h"
+#include "adc.h"
+#include "scan.h"
+#include "link.h"
+#include "wire.h"
+#include "memory.h"
+#include "timestamp.h"
+
+/*
+ * Shortest sample/hold that settles a 12-bit sample from a low
+ * impedance source, per the sample timing formula for ADC12_B in
+ * Reference 3. Use a longer one for high impedance sources.
+ */
+#define BURST_SAMPLE_HOLD   ADC12_B_CYCLEHOLD_8_CYCLES
+
+MEM_FRAM(burstBuffer)
+volatile uint16_t burstBuffer[BURST_SAMPLES] = {0};
+
+volatile unsigned char burstState = BURST_IDLE;
+volatile uint16_t burstOverflows = 0;
+Burst_Result burstResult;
+
+static uint8_t burstChannel = BURST_DEFAULT_CHANNEL;
+static uint16_t sendIndex = 0;
+static unsigned char startSent = 0;
+
+void Init_Burst_Button()
+{
+    /*
+     * S2 on P1.2, active low with pull-up, interrupt on press.
+     */
+    GPIO_setAsInputPinWithPullUpResistor(GPIO_PORT_P1, GPIO_PIN2);
+    GPIO_selectInterruptEdge(GPIO_PORT_P1, GPIO_PIN2,
+        GPIO_HIGH_TO_LOW_TRANSITION);
+    GPIO_clearInterrupt(GPIO_PORT_P1, GPIO_PIN2);
+    GPIO_enableInterrupt(GPIO_PORT_P1, GPIO_PIN2);
+}
+
+/*
+ * Requests a burst on channel, A0..A15. main() starts it the next time
+ * it wakes, so wake it after calling this from an ISR.
+ */
+void Burst_Arm(uint8_t channel)
+{
+    if ((burstState == BURST_IDLE) && (channel < SCAN_CHANNELS))
+    {
+        burstChannel = channel;
+        burstState = BURST_ARMED;
+    }
+}
+
+static void Burst_Start(void)
+{
+    /*
+     * Farmed out to adc suite.
+     */
+    Stop_Scan();
+    Config_ADC12_B_For_Burst(burstChannel, BURST_SAMPLE_HOLD);
+
+    /*
+     * DMA channel 0
+     * One word per ADC12 result, from ADC12MEM0 to the next word of
+     * burstBuffer, BURST_SAMPLES of them, then interrupt
+     */
+    DMA_initParam dmaParam = {0};
+    dmaParam.channelSelect = DMA_CHANNEL_0;
+    dmaParam.transferModeSelect = DMA_TRANSFER_SINGLE;
+    dmaParam.transferSize = BURST_SAMPLES;
+    dmaParam.triggerSourceSelect = DMA_TRIGGERSOURCE_26;
+    dmaParam.transferUnitSelect = DMA_SIZE_SRCWORD_DSTWORD;
+    dmaParam.triggerTypeSelect = DMA_TRIGGER_RISINGEDGE;
+    DMA_init(&dmaParam);
+
+    DMA_setSrcAddress(DMA_CHANNEL_0,
+        ADC12_B_getMemoryAddressForDMA(ADC12_B_BASE, ADC12_B_MEMORY_0),
+        DMA_DIRECTION_UNCHANGED);
+    DMA_setDstAddress(DMA_CHANNEL_0,
+        (uint32_t)(uintptr_t)burstBuffer,
+        DMA_DIRECTION_INCREMENT);
+    DMA_clearInterrupt(DMA_CHANNEL_0);
+    DMA_enableInterrupt(DMA_CHANNEL_0);
+    DMA_enableTransfers(DMA_CHANNEL_0);
+
+    burstOverflows = 0;
+    burstResult.channel = burstChannel;
+    burstResult.samples = 0;
+    burstState = BURST_RUNNING;
+
+    /*
+     * Base address of ADC12B Module
+     * Free running conversions of memory buffer 0 until the DMA
+     * interrupt stops them
+     */
+    burstResult.startTicks = Timestamp_Now();
+    ADC12_B_startConversion(ADC12_B_BASE,
+        ADC12_B_MEMORY_0,
+        ADC12_B_REPEATED_SINGLECHANNEL);
+}
+
+/*
+ * Streams the burst out over the link, as far as the TX ring allows.
+ */
+static void Burst_Send(void)
+{
+    uint8_t payload[2 + (2 * BURST_RECORD_SAMPLES)];
+
+    if (!startSent)
+    {
+        payload[0] = burstResult.channel;
+        Wire_Put_U16(&payload[1], burstResult.samples);
+        Wire_Put_U16(&payload[3], burstResult.overflows);
+        Wire_Put_U32(&payload[5], burstResult.startTicks);
+        Wire_Put_U32(&payload[9], burstResult.elapsedTicks);
+        Wire_Put_U32(&payload[13], burstResult.rateHz);
+        if (!Link_Send(WIRE_TYPE_BURST_START, payload, 17))
+        {
+            Link_Wake_On_Drain();
+            return;
+        }
+        startSent = 1;
+    }
+
+    while (sendIndex < burstResult.samples)
+    {
+        uint16_t count = burstResult.samples - sendIndex;
+        uint16_t i;
+
+        if (count > BURST_RECORD_SAMPLES)
+        {
+            count = BURST_RECORD_SAMPLES;
+        }
+        Wire_Put_U16(&payload[0], sendIndex);
+        for (i = 0; i < count; i++)
+        {
+            Wire_Put_U16(&payload[2 + (2 * i)], burstBuffer[sendIndex + i]);
+        }
+        if (!Link_Send(WIRE_TYPE_BURST_DATA, payload, (uint8_t)(2 + (2 * count))))
+        {
+            Link_Wake_On_Drain();
+            return;
+        }
+        sendIndex += count;
+    }
+
+    Wire_Put_U16(&payload[0], sendIndex);
+    if (!Link_Send(WIRE_TYPE_BURST_END, payload, 2))
+    {
+        Link_Wake_On_Drain();
+        return;
+    }
+
+    burstState = BURST_IDLE;
+}
+
+/*
+ * Called from main() whenever it wakes. Returns 1 once a burst has
+ * finished with the ADC, when main() has to put the scan back.
+ */
+unsigned char Burst_Service()
+{
+    switch (burstState)
+    {
+        case BURST_ARMED:
+            Burst_Start();
+            break;
+        case BURST_DONE:
+            burstResult.samples = BURST_SAMPLES;
+            burstResult.overflows = burstOverflows;
+            burstResult.rateHz = 0;
+            if (burstResult.elapsedTicks != 0)
+            {
+                burstResult.rateHz = (uint32_t)(((uint64_t)BURST_SAMPLES * TIMESTAMP_HZ) /
+                                                burstResult.elapsedTicks);
+            }
+            sendIndex = 0;
+            startSent = 0;
+            burstState = BURST_SENDING;
+            Burst_Send();
+            return 1;
+        case BURST_SENDING:
+            Burst_Send();
+            break;
+        default: break;
+    }
+
+    return 0;
+}
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=DMA_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(DMA_VECTOR)))
+#endif
+void DMA_ISR (void)
+{
+    switch (__even_in_range(DMAIV, DMAIV__DMA2IFG)){
+        case DMAIV__DMA0IFG:
+            // Buffer full, stop converting before anything else
+            ADC12_B_disableConversions(ADC12_B_BASE, ADC12_B_PREEMPTCONVERSION);
+            burstResult.elapsedTicks = Timestamp_Now() - burstResult.startTicks;
+            burstState = BURST_DONE;
+            __bic_SR_register_on_exit(LPM0_bits);
+            break;
+        default: break;
+    }
+}
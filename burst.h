@@ -0,0 +1,76 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Single-channel burst capture at the ADC12_B's full rate.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#ifndef AI_SCANNER_BURST_H_
+#define AI_SCANNER_BURST_H_
+
+#include <stdint.h>
+
+/*
+ * 8192 samples, 16 KB of FRAM, about 40 ms at full rate.
+ */
+#define BURST_SAMPLES       8192
+
+// Channel S2 bursts on, A0..A15
+#define BURST_DEFAULT_CHANNEL   3
+
+/*
+ * 8 ADC12CLK cycles of sample/hold plus 14 of conversion, ADC12OSC / 22,
+ * ~218 ksps at the typical 4.8 MHz. See burst.c.
+ */
+#define BURST_CLOCKS_PER_SAMPLE 22
+#define BURST_NOMINAL_HZ        (4800000UL / BURST_CLOCKS_PER_SAMPLE)
+
+#define BURST_IDLE      0
+#define BURST_ARMED     1
+#define BURST_RUNNING   2
+#define BURST_DONE      3
+#define BURST_SENDING   4
+
+// Samples per WIRE_TYPE_BURST_DATA record
+#define BURST_RECORD_SAMPLES    28
+
+/*
+ * Elapsed time is in TIMESTAMP_HZ ticks, from just before the first
+ * conversion starts to the DMA completing the last transfer. Every
+ * ADC12 overflow during the burst is a result overwritten before the
+ * DMA moved it, i.e. a gap.
+ */
+typedef struct
+{
+    uint8_t channel;
+    uint16_t samples;
+    uint16_t overflows;
+    uint32_t startTicks;
+    uint32_t elapsedTicks;
+    uint32_t rateHz;
+} Burst_Result;
+
+// State and result, in SRAM
+#define BURST_SRAM_BYTES    (sizeof(Burst_Result) + 8)
+
+extern volatile unsigned char burstState;
+extern volatile uint16_t burstOverflows;
+extern Burst_Result burstResult;
+
+/*
+ * The burst, one contiguous block in FRAM. Valid from sample 0 to
+ * burstResult.samples - 1 once burstState leaves BURST_RUNNING.
+ */
+extern volatile uint16_t burstBuffer[BURST_SAMPLES];
+
+void Init_Burst_Button(void);
+void Burst_Arm(uint8_t channel);
+unsigned char Burst_Service(void);
+
+#endif /* AI_SCANNER_BURST_H_ */
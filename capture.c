@@ -0,0 +1,162 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Raw scan frame capture into FRAM for host replay.
+ *
+ * Pressing S1 (P1.1) on the LaunchPad arms a capture. ADC12ISR then
+ * copies the next CAPTURE_FRAMES raw frames, before any processing,
+ * into a FRAM buffer. The link is far too slow to keep up with the
+ * scan rate, so the frames are recorded back to back first and only
+ * streamed out afterwards, from main(), as WIRE_TYPE_RAW_SCAN records
+ * between a CAPTURE_START and a CAPTURE_END record.
+ *
+ * Saving the COM port output to a file gives a capture that
+ * host/replay.c can push back through the processing pipeline.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#include <driverlib.h>
+#include "capture.h"
+#include "link.h"
+#include "wire.h"
+#include "memory.h"
+#include "burst.h"
+
+/*
+ * 128 frames of 39 bytes, far too big for SRAM.
+ */
+MEM_FRAM(captureBuffer)
+uint8_t captureBuffer[CAPTURE_FRAMES][CAPTURE_RECORD_SIZE] = {{0}};
+
+static volatile unsigned char captureState = CAPTURE_IDLE;
+static volatile uint16_t captureCount = 0;
+static uint16_t sendIndex = 0;
+static unsigned char startSent = 0;
+
+void Init_Capture_Button()
+{
+    /*
+     * S1 on P1.1, active low with pull-up, interrupt on press.
+     */
+    GPIO_setAsInputPinWithPullUpResistor(GPIO_PORT_P1, GPIO_PIN1);
+    GPIO_selectInterruptEdge(GPIO_PORT_P1, GPIO_PIN1,
+        GPIO_HIGH_TO_LOW_TRANSITION);
+    GPIO_clearInterrupt(GPIO_PORT_P1, GPIO_PIN1);
+    GPIO_enableInterrupt(GPIO_PORT_P1, GPIO_PIN1);
+}
+
+void Capture_Arm()
+{
+    if (captureState == CAPTURE_IDLE)
+    {
+        captureCount = 0;
+        sendIndex = 0;
+        startSent = 0;
+        captureState = CAPTURE_ARMED;
+    }
+}
+
+/*
+ * Called from ADC12ISR with every raw frame. Returns 1 when the buffer
+ * just filled up and main() should be woken to stream it out.
+ */
+unsigned char Capture_Raw_Frame(const Scan_Frame *frame)
+{
+    uint8_t *record;
+    uint16_t channel;
+
+    if (captureState != CAPTURE_ARMED)
+    {
+        return 0;
+    }
+
+    record = captureBuffer[captureCount];
+    Wire_Put_U32(&record[0], frame->sequence);
+    Wire_Put_U16(&record[4], frame->channelMask);
+    record[6] = frame->classMask;
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        Wire_Put_U16(&record[7 + (2 * channel)], frame->sample[channel]);
+    }
+
+    captureCount++;
+    if (captureCount == CAPTURE_FRAMES)
+    {
+        captureState = CAPTURE_FULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Streams a full capture out over the link, as far as the TX ring
+ * allows. Called from main() whenever it wakes.
+ */
+void Capture_Service()
+{
+    uint8_t payload[4];
+
+    if (captureState != CAPTURE_FULL)
+    {
+        return;
+    }
+
+    if (!startSent)
+    {
+        Wire_Put_U16(&payload[0], CAPTURE_FRAMES);
+        payload[2] = SCAN_CHANNELS;
+        if (!Link_Send(WIRE_TYPE_CAPTURE_START, payload, 3))
+        {
+            Link_Wake_On_Drain();
+            return;
+        }
+        startSent = 1;
+    }
+
+    while (sendIndex < captureCount)
+    {
+        if (!Link_Send(WIRE_TYPE_RAW_SCAN, captureBuffer[sendIndex],
+                       CAPTURE_RECORD_SIZE))
+        {
+            Link_Wake_On_Drain();
+            return;
+        }
+        sendIndex++;
+    }
+
+    Wire_Put_U16(&payload[0], sendIndex);
+    if (!Link_Send(WIRE_TYPE_CAPTURE_END, payload, 2))
+    {
+        Link_Wake_On_Drain();
+        return;
+    }
+
+    captureState = CAPTURE_IDLE;
+}
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=PORT1_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(PORT1_VECTOR)))
+#endif
+void PORT1_ISR (void)
+{
+    switch (__even_in_range(P1IV, P1IV_P1IFG7)){
+        case P1IV_P1IFG1:
+            Capture_Arm();
+            break;
+        case P1IV_P1IFG2:
+            // main() stops the scan and runs the burst, from LPM3 too
+            Burst_Arm(BURST_DEFAULT_CHANNEL);
+            __bic_SR_register_on_exit(LPM3_bits);
+            break;
+        default: break;
+    }
+}
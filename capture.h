@@ -0,0 +1,30 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Raw scan frame capture into FRAM for host replay.
+ *
+ */
+
+#ifndef AI_SCANNER_CAPTURE_H_
+#define AI_SCANNER_CAPTURE_H_
+
+#include <stdint.h>
+#include "scan.h"
+
+#define CAPTURE_FRAMES  128
+#define CAPTURE_SRAM_BYTES  8
+
+#define CAPTURE_IDLE    0
+#define CAPTURE_ARMED   1
+#define CAPTURE_FULL    2
+
+// u32 sequence, u16 channel mask, u8 class mask, u16 sample[SCAN_CHANNELS]
+#define CAPTURE_RECORD_SIZE (7 + (2 * SCAN_CHANNELS))
+
+void Init_Capture_Button(void);
+void Capture_Arm(void);
+unsigned char Capture_Raw_Frame(const Scan_Frame *frame);
+void Capture_Service(void);
+
+#endif /* AI_SCANNER_CAPTURE_H_ */
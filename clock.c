@@ -0,0 +1,44 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Clock system profiles for the MSP430FR6989, see clock.h.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#include <driverlib.h>
+#include "clock.h"
+
+void Init_Clock()
+{
+    /*
+     * FRAM wait states go in before MCLK rises above 8 MHz.
+     * Recommended operating conditions in Reference 1, FRAM controller
+     * chapter in Reference 3.
+     */
+    FRAMCtl_configureWaitStateControl((CLOCK_FRAM_WAIT_STATES == 0) ?
+                                      FRAMCTL_ACCESS_TIME_CYCLES_0 :
+                                      FRAMCTL_ACCESS_TIME_CYCLES_1);
+
+    /*
+     * DCO range and frequency select for the profile. driverlib drops
+     * the dividers to /4 around the change, which covers erratum CS12
+     * on the way up to 16 MHz.
+     * DCO frequency table in Reference 1.
+     */
+    CS_setDCOFreq(CLOCK_DCO_RANGE, CLOCK_DCO_FREQ);
+
+    /*
+     * MCLK and SMCLK from the DCO at the profile's divider
+     * ACLK from the VLO whatever the profile; the LCD and the duty
+     * suite's wake timer run from it, through LPM3
+     */
+    CS_initClockSignal(CS_MCLK, CS_DCOCLK_SELECT, CLOCK_CS_DIVIDER);
+    CS_initClockSignal(CS_SMCLK, CS_DCOCLK_SELECT, CLOCK_CS_DIVIDER);
+    CS_initClockSignal(CS_ACLK, CS_VLOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+}
@@ -0,0 +1,152 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Clock system profiles for the MSP430FR6989.
+ *
+ * A profile sets the DCO, MCLK, SMCLK and ACLK and everything that
+ * hangs off them: FRAM wait states, the Timer_A0/Timer_B0 tick, the
+ * timestamp rate and the UART baud rate generator. Pick one with
+ * CLOCK_PROFILE here or on the compiler command line
+ * (-DCLOCK_PROFILE=CLOCK_PROFILE_1MHZ), which is how host/clockbench.c
+ * is built for each profile.
+ *
+ * The scan and control timers tick at CLOCK_TICK_HZ in every profile,
+ * so slot periods, PWM periods and deadlines mean the same thing
+ * whatever the CPU runs at. ADC12_B stays on MODOSC, and ACLK on
+ * the VLO for the LCD and the duty suite's wake timer, neither of
+ * which depends on the DCO.
+ *
+ * Portable, shared with the host tools. Only clock.c and hal_LCD.c
+ * use the driverlib names below.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#ifndef AI_SCANNER_CLOCK_H_
+#define AI_SCANNER_CLOCK_H_
+
+#include "memory.h"
+
+#define CLOCK_PROFILE_1MHZ      0   /* reset default, 8 MHz DCO / 8   */
+#define CLOCK_PROFILE_8MHZ      1   /* 8 MHz DCO, no wait states      */
+#define CLOCK_PROFILE_16MHZ     2   /* 16 MHz DCO, 1 FRAM wait state  */
+
+#ifndef CLOCK_PROFILE
+#define CLOCK_PROFILE           CLOCK_PROFILE_16MHZ
+#endif
+
+/*
+ * Per profile: DCO range and frequency select, MCLK = SMCLK divider,
+ * Timer_A/Timer_B input dividers down to CLOCK_TICK_HZ and to the
+ * timestamp, and eUSCI_A UART settings for 115200 baud from the baud
+ * rate settings table in the eUSCI UART chapter of Reference 3.
+ */
+#if CLOCK_PROFILE == CLOCK_PROFILE_1MHZ
+#define CLOCK_NAME              "1 MHz"
+#define CLOCK_DCO_HZ            8000000UL
+#define CLOCK_DCO_RANGE         CS_DCORSEL_0
+#define CLOCK_DCO_FREQ          CS_DCOFSEL_6
+#define CLOCK_DIVIDER           8
+#define CLOCK_CS_DIVIDER        CS_CLOCK_DIVIDER_8
+#define CLOCK_TICK_DIVIDER      1
+#define CLOCK_TIMER_A_TICK      TIMER_A_CLOCKSOURCE_DIVIDER_1
+#define CLOCK_TIMER_B_TICK      TIMER_B_CLOCKSOURCE_DIVIDER_1
+#define CLOCK_TIMESTAMP_DIVIDER 8
+#define CLOCK_TIMER_A_TIMESTAMP TIMER_A_CLOCKSOURCE_DIVIDER_8
+#define CLOCK_UART_PRESCALER    8
+#define CLOCK_UART_FIRST_MOD    0
+#define CLOCK_UART_SECOND_MOD   0xD6
+#define CLOCK_UART_OVERSAMPLING 0
+#elif CLOCK_PROFILE == CLOCK_PROFILE_8MHZ
+#define CLOCK_NAME              "8 MHz"
+#define CLOCK_DCO_HZ            8000000UL
+#define CLOCK_DCO_RANGE         CS_DCORSEL_0
+#define CLOCK_DCO_FREQ          CS_DCOFSEL_6
+#define CLOCK_DIVIDER           1
+#define CLOCK_CS_DIVIDER        CS_CLOCK_DIVIDER_1
+#define CLOCK_TICK_DIVIDER      8
+#define CLOCK_TIMER_A_TICK      TIMER_A_CLOCKSOURCE_DIVIDER_8
+#define CLOCK_TIMER_B_TICK      TIMER_B_CLOCKSOURCE_DIVIDER_8
+#define CLOCK_TIMESTAMP_DIVIDER 64
+#define CLOCK_TIMER_A_TIMESTAMP TIMER_A_CLOCKSOURCE_DIVIDER_64
+#define CLOCK_UART_PRESCALER    4
+#define CLOCK_UART_FIRST_MOD    5
+#define CLOCK_UART_SECOND_MOD   0x55
+#define CLOCK_UART_OVERSAMPLING 1
+#elif CLOCK_PROFILE == CLOCK_PROFILE_16MHZ
+#define CLOCK_NAME              "16 MHz"
+#define CLOCK_DCO_HZ            16000000UL
+#define CLOCK_DCO_RANGE         CS_DCORSEL_1
+#define CLOCK_DCO_FREQ          CS_DCOFSEL_4
+#define CLOCK_DIVIDER           1
+#define CLOCK_CS_DIVIDER        CS_CLOCK_DIVIDER_1
+#define CLOCK_TICK_DIVIDER      16
+#define CLOCK_TIMER_A_TICK      TIMER_A_CLOCKSOURCE_DIVIDER_16
+#define CLOCK_TIMER_B_TICK      TIMER_B_CLOCKSOURCE_DIVIDER_16
+#define CLOCK_TIMESTAMP_DIVIDER 64
+#define CLOCK_TIMER_A_TIMESTAMP TIMER_A_CLOCKSOURCE_DIVIDER_64
+#define CLOCK_UART_PRESCALER    8
+#define CLOCK_UART_FIRST_MOD    10
+#define CLOCK_UART_SECOND_MOD   0xF7
+#define CLOCK_UART_OVERSAMPLING 1
+#else
+#error "Unknown CLOCK_PROFILE"
+#endif
+
+#define CLOCK_MCLK_HZ           (CLOCK_DCO_HZ / CLOCK_DIVIDER)
+#define CLOCK_SMCLK_HZ          CLOCK_MCLK_HZ
+
+/*
+ * The VLO, typical figure. It runs on in LPM3 for well under a uA,
+ * where LFMODCLK would keep MODOSC up, but is only good to about 20%
+ * with part, temperature and supply. See the VLO in Reference 1.
+ * Anything timed off ACLK has to hold across that whole range.
+ */
+#define CLOCK_ACLK_HZ           9400UL
+#define CLOCK_ACLK_TOLERANCE    20
+
+/*
+ * LCD_C runs 4-mux off ACLK / CLOCK_LCD_DIVIDE, see Init_LCD(). Its
+ * frame rate is f_LCD / (2 x mux), in the LCD_C chapter of Reference 3,
+ * and has to stay within 30 to 100 Hz at either end of the VLO's
+ * range: flicker below, and above the LCD_C frame frequency limit in
+ * Reference 1. ACLK / 16 gives 73 Hz, 59 to 88 Hz over the VLO.
+ */
+#define CLOCK_LCD_PRESCALER     LCD_C_CLOCKPRESCALAR_16
+#define CLOCK_LCD_DIVIDE        16UL
+#define CLOCK_LCD_MUX           4UL
+#define CLOCK_LCD_FRAME_MIN_HZ  30UL
+#define CLOCK_LCD_FRAME_MAX_HZ  100UL
+
+#define CLOCK_LCD_FRAME_HZ(aclk) ((aclk) / (CLOCK_LCD_DIVIDE * 2 * CLOCK_LCD_MUX))
+
+#if (CLOCK_LCD_FRAME_HZ((CLOCK_ACLK_HZ * (100 - CLOCK_ACLK_TOLERANCE)) / 100) < \
+     CLOCK_LCD_FRAME_MIN_HZ) || \
+    (CLOCK_LCD_FRAME_HZ((CLOCK_ACLK_HZ * (100 + CLOCK_ACLK_TOLERANCE)) / 100) > \
+     CLOCK_LCD_FRAME_MAX_HZ)
+#error "CLOCK_LCD_PRESCALER puts the LCD frame rate out of range over the VLO tolerance"
+#endif
+
+// What Timer_A0 and Timer_B0 count at, 1 MHz in every profile
+#define CLOCK_TICK_HZ           (CLOCK_SMCLK_HZ / CLOCK_TICK_DIVIDER)
+#define CLOCK_TIMESTAMP_HZ      (CLOCK_SMCLK_HZ / CLOCK_TIMESTAMP_DIVIDER)
+
+#define CLOCK_FRAM_WAIT_STATES  MEM_FRAM_WAIT_STATES(CLOCK_MCLK_HZ)
+
+/*
+ * Rough instruction rate once FRAM wait states are paid for. The
+ * read cache hides most of them; code that misses it every fourth
+ * fetch runs at about 80% of MCLK with one wait state.
+ */
+#define CLOCK_CPU_HZ            ((CLOCK_MCLK_HZ / (4 + CLOCK_FRAM_WAIT_STATES)) * 4)
+
+#define CLOCK_UART_BAUD         115200UL
+
+void Init_Clock(void);
+
+#endif /* AI_SCANNER_CLOCK_H_ */
@@ -0,0 +1,318 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Run time reconfiguration of the scan over the data link.
+ *
+ * The host batches changes into a transaction:
+ *
+ *   BEGIN n | SET n key value key value ... | SET n ... | COMMIT n flags
+ *
+ * BEGIN stages a copy of the active config, each SET changes the copy
+ * and COMMIT builds it into the spare schedule table, checks that the
+ * busiest slot still fits the slot period, and queues the table for
+ * ADC12ISR to switch to between two slots. Nothing touches the running
+ * scan until then, and an error anywhere in the transaction fails the
+ * COMMIT. Every command is answered with a WIRE_TYPE_COMMAND_ACK; once
+ * the new table has taken over, a WIRE_TYPE_SCHED_CONFIG reports it
+ * along with its achievable rates. ABORT drops a transaction and QUERY
+ * reports the active config.
+ *
+ * The switch itself loses at most one slot, see Scan_Slot_Complete()
+ * in main.c, which host/schedsim.c checks by streaming a transaction
+ * through this code in the middle of a simulated run.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#include <string.h>
+#include "command.h"
+
+Command_State commandState;
+
+static uint8_t Command_Ack(uint8_t *ack, uint8_t transaction, uint8_t type,
+                           uint8_t status, uint8_t detail, uint16_t maxSlotHz)
+{
+    ack[0] = transaction;
+    ack[1] = type;
+    ack[2] = status;
+    ack[3] = detail;
+    Wire_Put_U16(&ack[4], maxSlotHz);
+
+    return COMMAND_ACK_BYTES;
+}
+
+/*
+ * Applies one setting to config, or returns why not.
+ */
+static uint8_t Command_Apply(Sched_Config *config, uint8_t key, uint16_t value)
+{
+    uint8_t index = key & 0x0F;
+
+    switch (key & 0xF0)
+    {
+        case (COMMAND_KEY_SLOT_HZ & 0xF0):
+            if (key != COMMAND_KEY_SLOT_HZ)
+            {
+                return COMMAND_BAD_KEY;
+            }
+            if (value < COMMAND_MIN_SLOT_HZ)
+            {
+                return COMMAND_BAD_VALUE;
+            }
+            config->slotHz = value;
+            break;
+        case COMMAND_KEY_DIVIDER:
+            if (index >= SCHED_CLASSES)
+            {
+                return COMMAND_BAD_KEY;
+            }
+            if ((value == 0) || (value > SCHED_MAX_SLOTS) ||
+                (value & (value - 1)))
+            {
+                return COMMAND_BAD_VALUE;
+            }
+            config->divider[index] = value;
+            break;
+        case COMMAND_KEY_CLASS:
+            if ((value >= SCHED_CLASSES) && (value != SCHED_CLASS_OFF))
+            {
+                return COMMAND_BAD_VALUE;
+            }
+            config->channelClass[index] = (uint8_t)value;
+            break;
+        case COMMAND_KEY_SAMPLE_HOLD:
+            if (index >= 2)
+            {
+                return COMMAND_BAD_KEY;
+            }
+            if (value > SCHED_MAX_SAMPLE)
+            {
+                return COMMAND_BAD_VALUE;
+            }
+            config->sampleHold[index] = (uint8_t)value;
+            break;
+        default:
+            return COMMAND_BAD_KEY;
+    }
+
+    return COMMAND_OK;
+}
+
+/*
+ * A SET record is applied whole or not at all.
+ */
+static uint8_t Command_Set(const uint8_t *settings, uint8_t length,
+                           uint8_t *detail)
+{
+    Sched_Config config = commandState.staged;
+    uint8_t index;
+
+    if ((length % COMMAND_SET_BYTES) != 0)
+    {
+        return COMMAND_BAD_LENGTH;
+    }
+
+    for (index = 0; index < (length / COMMAND_SET_BYTES); index++)
+    {
+        const uint8_t *setting = &settings[index * COMMAND_SET_BYTES];
+        uint8_t status = Command_Apply(&config, setting[0],
+                                       Wire_Get_U16(&setting[1]));
+
+        if (status != COMMAND_OK)
+        {
+            *detail = index;
+            return status;
+        }
+    }
+
+    commandState.staged = config;
+    return COMMAND_OK;
+}
+
+static uint8_t Command_Commit(uint8_t flags, uint8_t *detail,
+                              uint16_t *maxSlotHz)
+{
+    Sched_Table *spare;
+    uint16_t status;
+
+    if (schedPending != 0)
+    {
+        return COMMAND_BUSY;
+    }
+
+    spare = Sched_Spare();
+    status = Sched_Build(&commandState.staged, spare);
+    if (status != SCHED_OK)
+    {
+        *detail = (uint8_t)status;
+        return COMMAND_BAD_SCHEDULE;
+    }
+
+    *maxSlotHz = Sched_Max_Slot_Hz(spare, SCHED_MCLK_HZ);
+    if (commandState.staged.slotHz > *maxSlotHz)
+    {
+        return COMMAND_TOO_FAST;
+    }
+
+    commandState.applying = 1;
+    commandState.applyingTransaction = commandState.transaction;
+    commandState.save = flags & COMMAND_COMMIT_SAVE;
+    Sched_Queue(spare);
+
+    return COMMAND_OK;
+}
+
+/*
+ * Handles one received record. Returns the length of the
+ * WIRE_TYPE_COMMAND_ACK payload written to ack, or 0 if the record
+ * isn't a command. Call from main() only.
+ */
+uint8_t Command_Handle(const Wire_Decoder *record, uint8_t *ack)
+{
+    const uint8_t *payload = record->payload;
+    uint8_t type = record->type;
+    uint8_t status = COMMAND_OK;
+    uint8_t detail = 0;
+    uint8_t transaction = (record->length > 0) ? payload[0] : 0;
+    uint16_t maxSlotHz = 0;
+
+    if ((type & 0xF0) != WIRE_TYPE_CMD_BEGIN)
+    {
+        return 0;
+    }
+
+    if (type == WIRE_TYPE_CMD_QUERY)
+    {
+        commandState.query = 1;
+        return Command_Ack(ack, 0, type, COMMAND_OK, 0,
+                           Sched_Max_Slot_Hz(schedActive, SCHED_MCLK_HZ));
+    }
+
+    if ((type > WIRE_TYPE_CMD_QUERY) || (record->length == 0))
+    {
+        status = (type > WIRE_TYPE_CMD_QUERY) ? COMMAND_UNKNOWN : COMMAND_BAD_LENGTH;
+        return Command_Ack(ack, transaction, type, status, 0, 0);
+    }
+
+    if (type == WIRE_TYPE_CMD_BEGIN)
+    {
+        // Stage on top of the last commit, not the table it replaces
+        if (schedPending != 0)
+        {
+            return Command_Ack(ack, transaction, type, COMMAND_BUSY, 0, 0);
+        }
+
+        // A new BEGIN throws away whatever was open
+        commandState.staged = schedActive->config;
+        commandState.transaction = transaction;
+        commandState.status = COMMAND_OK;
+        commandState.detail = 0;
+        commandState.open = 1;
+        return Command_Ack(ack, transaction, type, COMMAND_OK, 0, 0);
+    }
+
+    if (!commandState.open || (transaction != commandState.transaction))
+    {
+        return Command_Ack(ack, transaction, type, COMMAND_NO_TRANSACTION, 0, 0);
+    }
+
+    switch (type)
+    {
+        case WIRE_TYPE_CMD_SET:
+            if (commandState.status == COMMAND_OK)
+            {
+                commandState.status = Command_Set(&payload[1],
+                                                  (uint8_t)(record->length - 1),
+                                                  &commandState.detail);
+            }
+            status = commandState.status;
+            detail = commandState.detail;
+            break;
+        case WIRE_TYPE_CMD_COMMIT:
+            status = commandState.status;
+            detail = commandState.detail;
+            if (status == COMMAND_OK)
+            {
+                status = Command_Commit((record->length > 1) ? payload[1] : 0,
+                                        &detail, &maxSlotHz);
+            }
+            // Busy leaves the transaction open to COMMIT again
+            if (status != COMMAND_BUSY)
+            {
+                commandState.open = 0;
+            }
+            break;
+        case WIRE_TYPE_CMD_ABORT:
+            commandState.open = 0;
+            break;
+        default:
+            break;
+    }
+
+    return Command_Ack(ack, transaction, type, status, detail, maxSlotHz);
+}
+
+/*
+ * Returns the length of a WIRE_TYPE_SCHED_CONFIG payload written to
+ * report once a committed config has taken over, or for a QUERY, and
+ * 0 otherwise. save is set when the commit asked for the config to be
+ * kept in FRAM; the caller does that before sending the report. Call
+ * from main() only.
+ */
+uint8_t Command_Report(uint8_t *report, unsigned char *save)
+{
+    const Sched_Table *table = schedActive;
+    uint8_t flags = 0;
+    uint8_t transaction = 0;
+    uint16_t rateClass;
+
+    *save = 0;
+
+    if (commandState.applying && (schedPending == 0))
+    {
+        commandState.applying = 0;
+        transaction = commandState.applyingTransaction;
+        if (commandState.save)
+        {
+            *save = 1;
+            flags |= COMMAND_REPORT_SAVED;
+        }
+    }
+    else if (commandState.query)
+    {
+        commandState.query = 0;
+        flags |= COMMAND_REPORT_QUERY;
+    }
+    else
+    {
+        return 0;
+    }
+
+    report[0] = transaction;
+    report[1] = flags;
+    Wire_Put_U16(&report[2], table->config.slotHz);
+    for (rateClass = 0; rateClass < SCHED_CLASSES; rateClass++)
+    {
+        Wire_Put_U16(&report[4 + (2 * rateClass)], table->config.divider[rateClass]);
+    }
+    report[12] = table->config.sampleHold[0];
+    report[13] = table->config.sampleHold[1];
+    memcpy(&report[14], table->config.channelClass, SCAN_CHANNELS);
+    Wire_Put_U16(&report[30], table->slots);
+    Wire_Put_U16(&report[32], table->maxPerSlot);
+    Wire_Put_U32(&report[34], Sched_Worst_Slot_Ns(table, SCHED_MCLK_HZ));
+    Wire_Put_U16(&report[38], Sched_Max_Slot_Hz(table, SCHED_MCLK_HZ));
+    for (rateClass = 0; rateClass < SCHED_CLASSES; rateClass++)
+    {
+        Wire_Put_U32(&report[40 + (4 * rateClass)],
+                     ((uint32_t)table->config.slotHz * 1000UL) /
+                     table->config.divider[rateClass]);
+    }
+    Wire_Put_U32(&report[56], schedIsrMeasured.worst);
+    Wire_Put_U16(&report[60], schedIsrMeasured.worstChannels);
+    Wire_Put_U16(&report[62], schedIsrMeasured.excess);
+
+    return COMMAND_REPORT_BYTES;
+}
@@ -0,0 +1,85 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Run time reconfiguration of the scan over the data link.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#ifndef AI_SCANNER_COMMAND_H_
+#define AI_SCANNER_COMMAND_H_
+
+#include <stdint.h>
+#include "adc.h"
+#include "sched.h"
+#include "wire.h"
+
+/*
+ * Settings carried by WIRE_TYPE_CMD_SET, as key and u16 value.
+ */
+#define COMMAND_KEY_SLOT_HZ     0x01    /* slotHz                            */
+#define COMMAND_KEY_DIVIDER     0x10    /* + rate class, divider             */
+#define COMMAND_KEY_CLASS       0x20    /* + channel, rate class or 0xFF off */
+#define COMMAND_KEY_SAMPLE_HOLD 0x30    /* + 0 for buffers 0-7, 1 for 8-15,
+                                           ADC12SHTx code                    */
+
+#define COMMAND_SET_BYTES       3
+
+// WIRE_TYPE_CMD_COMMIT flags
+#define COMMAND_COMMIT_SAVE     0x01
+
+// WIRE_TYPE_SCHED_CONFIG flags
+#define COMMAND_REPORT_SAVED    0x01
+#define COMMAND_REPORT_QUERY    0x02
+
+/*
+ * Status in WIRE_TYPE_COMMAND_ACK. detail is the index of the offending
+ * setting for BAD_KEY and BAD_VALUE and the SCHED_ error for
+ * BAD_SCHEDULE.
+ */
+#define COMMAND_OK              0
+#define COMMAND_NO_TRANSACTION  1
+#define COMMAND_BAD_LENGTH      2
+#define COMMAND_BAD_KEY         3
+#define COMMAND_BAD_VALUE       4
+#define COMMAND_BAD_SCHEDULE    5
+#define COMMAND_TOO_FAST        6
+#define COMMAND_BUSY            7
+#define COMMAND_UNKNOWN         8
+
+#define COMMAND_ACK_BYTES       6
+#define COMMAND_REPORT_BYTES    64
+
+/*
+ * Timer_A0's period register is 16 bits, which sets the slowest slot.
+ */
+#define COMMAND_MIN_SLOT_HZ     ((uint16_t)((ADC_TIMER_HZ + 0xFFFFUL) / 0x10000UL))
+
+/*
+ * One open transaction, staged on a copy of the active config. A
+ * failed command poisons it, so a COMMIT only ever applies every
+ * setting sent or none.
+ */
+typedef struct
+{
+    Sched_Config staged;
+    uint8_t open;
+    uint8_t transaction;
+    uint8_t status;
+    uint8_t detail;
+    uint8_t applying;
+    uint8_t applyingTransaction;
+    uint8_t save;
+    uint8_t query;
+} Command_State;
+
+#define COMMAND_SRAM_BYTES      (sizeof(Command_State))
+
+extern Command_State commandState;
+
+uint8_t Command_Handle(const Wire_Decoder *record, uint8_t *ack);
+uint8_t Command_Report(uint8_t *report, unsigned char *save);
+
+#endif /* AI_SCANNER_COMMAND_H_ */
@@ -0,0 +1,151 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Temperature and supply compensation, a stage of the scan pipeline.
+ *
+ * The health suite reads the on-chip temperature sensor and AVcc/2
+ * in the background and calls Comp_Update() with the results. That
+ * works out, once per reading, one offset and one gain per channel
+ * from the channel's drift model in compConfig, so the stage itself
+ * costs one multiply per compensated sample. The coefficients are
+ * double buffered and swapped whole, so a frame never sees half an
+ * update.
+ *
+ * Until the first health reading, and for channels with no flags,
+ * samples pass through untouched.
+ *
+ * host/compsim.c checks the result against simulated drift.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#include "comp.h"
+#include "memory.h"
+
+/*
+ * Off for every channel until characterized. Lives in FRAM so the
+ * figures survive resets.
+ */
+MEM_FRAM(compConfig)
+Comp_Channel_Config compConfig[SCAN_CHANNELS] = {{0}};
+
+static Comp_Set compSets[2];
+static volatile uint8_t compActive = 0;
+
+/*
+ * Largest gain correction taken, in ppm. Keeps the arithmetic in 32
+ * bits; a channel drifting more than this needs fixing, not
+ * compensating.
+ */
+#define COMP_MAX_PPM        100000L
+
+static int32_t Comp_Clamp(int32_t value, int32_t low, int32_t high)
+{
+    if (value < low)
+    {
+        return low;
+    }
+    return (value > high) ? high : value;
+}
+
+/*
+ * Recomputes every channel's correction for a new temperature, in
+ * 0.01 degC, and AVcc, in mV. Call from main() only.
+ */
+void Comp_Update(int16_t temperature, uint16_t supplyMv)
+{
+    Comp_Set *set = &compSets[compActive ^ 1];
+    int32_t delta = (int32_t)temperature - COMP_REF_CENTI;
+    uint16_t channel;
+
+    set->mask = 0;
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        const Comp_Channel_Config *config = &compConfig[channel];
+        int32_t gain = 1L << COMP_GAIN_SHIFT;
+        int32_t offset = 0;
+
+        if (config->flags & COMP_TEMPERATURE)
+        {
+            int32_t ppm = Comp_Clamp(((int32_t)config->gainTc * delta) / 100,
+                                     -COMP_MAX_PPM, COMP_MAX_PPM);
+
+            // 1 / (1 + ppm / 1e6) without a 64-bit divide
+            gain -= ((gain * ppm) + ((1000000L + ppm) / 2)) / (1000000L + ppm);
+            offset = ((int32_t)config->offsetTc * delta) / 100;
+        }
+        if ((config->flags & COMP_SUPPLY) && (supplyMv != 0))
+        {
+            gain = ((gain * supplyMv) + (COMP_NOMINAL_MV / 2)) / COMP_NOMINAL_MV;
+        }
+
+        set->coeff[channel].gain = (uint16_t)Comp_Clamp(gain, 0, 0x7FFF);
+        set->coeff[channel].offset = (int16_t)Comp_Clamp(offset, -0x8000L, 0x7FFFL);
+        if (config->flags & (COMP_TEMPERATURE | COMP_SUPPLY))
+        {
+            set->mask |= (uint16_t)1 << channel;
+        }
+    }
+
+    compActive ^= 1;
+}
+
+/*
+ * Channels currently being compensated.
+ */
+uint16_t Comp_Mask(void)
+{
+    return compSets[compActive].mask;
+}
+
+void Comp_Stage(Scan_Frame *frame)
+{
+    const Comp_Set *set = &compSets[compActive];
+    uint16_t pending = frame->channelMask & set->mask;
+    uint16_t channel;
+
+    for (channel = 0; pending != 0; channel++, pending >>= 1)
+    {
+        int32_t value;
+
+        if (!(pending & 1))
+        {
+            continue;
+        }
+
+        value = ((int32_t)frame->sample[channel] << COMP_OFFSET_SHIFT) -
+                set->coeff[channel].offset;
+        value = ((value * set->coeff[channel].gain) +
+                 (1L << (COMP_OFFSET_SHIFT + COMP_GAIN_SHIFT - 1))) >>
+                (COMP_OFFSET_SHIFT + COMP_GAIN_SHIFT);
+
+        frame->sample[channel] = (uint16_t)Comp_Clamp(value, 0, 0x0FFF);
+    }
+}
+
+/*
+ * Temperature sensor reading to 0.01 degC, by the line through the
+ * device's factory calibration points at 30 and 85 degC.
+ */
+int16_t Comp_Temperature(uint16_t raw, uint16_t cal30, uint16_t cal85)
+{
+    int32_t span = (int32_t)cal85 - cal30;
+
+    if (span <= 0)
+    {
+        return COMP_REF_CENTI;
+    }
+
+    return (int16_t)(((((int32_t)raw - cal30) * 5500L) + (span / 2)) / span + 3000);
+}
+
+/*
+ * AVcc/2 reading against the 2.0 V reference to AVcc in mV.
+ */
+uint16_t Comp_Supply_Mv(uint16_t raw)
+{
+    return (uint16_t)((((uint32_t)raw * 4000UL) + 2048UL) >> 12);
+}
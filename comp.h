@@ -0,0 +1,75 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Temperature and supply compensation, a stage of the scan pipeline.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#ifndef AI_SCANNER_COMP_H_
+#define AI_SCANNER_COMP_H_
+
+#include <stdint.h>
+#include "scan.h"
+
+/*
+ * Per-channel flags. COMP_TEMPERATURE takes out the channel's
+ * characterized drift with board temperature. COMP_SUPPLY is for
+ * inputs that are absolute voltages rather than ratiometric to AVcc:
+ * readings are rescaled to what they would be at COMP_NOMINAL_MV.
+ */
+#define COMP_TEMPERATURE    0x01
+#define COMP_SUPPLY         0x02
+
+// Conditions the channels are characterized at
+#define COMP_REF_CENTI      2500    /* 0.01 degC */
+#define COMP_NOMINAL_MV     3300
+
+#define COMP_GAIN_SHIFT     14
+#define COMP_OFFSET_SHIFT   4
+
+/*
+ * Drift model of a channel, relative to COMP_REF_CENTI:
+ *
+ *   raw = ideal * (1 + gainTc * dT / 1e6) + offsetTc * dT / 16
+ *
+ * with dT in degC, gainTc in ppm/degC and offsetTc in 1/16 LSB/degC.
+ */
+typedef struct
+{
+    uint8_t flags;
+    int16_t offsetTc;
+    int16_t gainTc;
+} Comp_Channel_Config;
+
+/*
+ * Correction for the last health reading:
+ *   out = ((raw << COMP_OFFSET_SHIFT) - offset) * gain
+ *         >> (COMP_OFFSET_SHIFT + COMP_GAIN_SHIFT)
+ */
+typedef struct
+{
+    int16_t offset;
+    uint16_t gain;
+} Comp_Coeff;
+
+typedef struct
+{
+    uint16_t mask;
+    Comp_Coeff coeff[SCAN_CHANNELS];
+} Comp_Set;
+
+// Two sets in SRAM, ADC12ISR reads one while the other is rewritten
+#define COMP_SRAM_BYTES     ((2 * sizeof(Comp_Set)) + 2)
+
+extern Comp_Channel_Config compConfig[SCAN_CHANNELS];
+
+void Comp_Update(int16_t temperature, uint16_t supplyMv);
+void Comp_Stage(Scan_Frame *frame);
+uint16_t Comp_Mask(void);
+int16_t Comp_Temperature(uint16_t raw, uint16_t cal30, uint16_t cal85);
+uint16_t Comp_Supply_Mv(uint16_t raw);
+
+#endif /* AI_SCANNER_COMP_H_ */
@@ -0,0 +1,404 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Closed-loop control locked to ADC scan completion.
+ *
+ * Each loop reads one analog input and drives one output through a
+ * PID (pid.c). ADC12ISR calls Control_Run() as soon as a slot's results
+ * are out of the ADC, before reprogramming the sequence and before the
+ * frame goes down the scan pipeline, so nothing of variable length sits
+ * between a sample and its output. A loop runs whenever its channel is
+ * in the slot, i.e. at its channel's scan rate.
+ *
+ * Timer_A0 restarts from 0 on the edge that triggers each scan, so
+ * its counter read after a loop's output write is that loop's input to
+ * output latency, give or take whole slot periods. TAIFG only says a
+ * period went by since it was cleared at the start of ADC12ISR. The
+ * ones before that, when ADC12ISR itself started after the next
+ * trigger, come from the timestamp: it tells which trigger the slot
+ * is on against where the last one was, see Control_Track(). A latency
+ * of a period or more is an overrun, as is missing
+ * CONTROL_DEADLINE_TICKS.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#include <driverlib.h>
+#include "control.h"
+#include "link.h"
+#include "wire.h"
+#include "memory.h"
+#include "clock.h"
+#include "timestamp.h"
+#include "adc.h"
+
+typedef struct
+{
+    uint8_t port;
+    uint16_t pin;
+    uint16_t compareRegister;
+} Control_Output_Pin;
+
+/*
+ * outputIndex picks from these. PWM pins are Timer_B0 outputs, see the
+ * pin function tables in Reference 1. The DO pins are the LaunchPad
+ * LEDs; on a custom PCB (MSP6989_CONF 0) P1.0 and P9.7 are analog
+ * inputs, so pick other pins there.
+ */
+static const Control_Output_Pin controlPwmPins[] =
+{
+    { GPIO_PORT_P3, GPIO_PIN6, TIMER_B_CAPTURECOMPARE_REGISTER_2 },
+    { GPIO_PORT_P3, GPIO_PIN7, TIMER_B_CAPTURECOMPARE_REGISTER_3 },
+};
+
+static const Control_Output_Pin controlDoPins[] =
+{
+    { GPIO_PORT_P1, GPIO_PIN0, 0 },
+    { GPIO_PORT_P9, GPIO_PIN7, 0 },
+};
+
+/*
+ * Loops are off until configured. Setpoints are in ADC LSB, PWM
+ * outputs range over 0 to CONTROL_PWM_PERIOD counts, DO outputs over
+ * 0 to 1. Lives in FRAM so a warm boot keeps any retuning.
+ */
+MEM_FRAM(controlConfig)
+Control_Loop_Config controlConfig[CONTROL_LOOPS] =
+{
+    { 0, 3, CONTROL_OUT_PWM, 0, { 2048, 256, 16, 0, 0, CONTROL_PWM_PERIOD } },
+    { 0, 4, CONTROL_OUT_DO, 0, { 2048, 256, 16, 0, 0, 1 } },
+};
+
+Control_Loop controlLoops[CONTROL_LOOPS];
+
+// Timer_A0 ticks per timestamp tick, 4 or 8 depending on the profile
+#define CONTROL_STAMP_TICKS     (ADC_TIMER_HZ / TIMESTAMP_HZ)
+
+/*
+ * Where the next slot's trigger is due, in Timer_A0 ticks on the
+ * timestamp's time line. Not known after a restart until the first
+ * slot.
+ */
+static uint32_t controlTrigger;
+static uint16_t controlSince;
+static unsigned char controlTracking = 0;
+
+void Init_Control()
+{
+    uint16_t loop;
+
+    /*
+     * Base address of Timer_B0
+     * SMCLK divided down to CLOCK_TICK_HZ, up mode, one PWM period
+     * every CONTROL_PWM_PERIOD counts
+     * No interrupts, outputs are only ever written from ADC12ISR
+     */
+    Timer_B_initUpModeParam upParam = {0};
+    upParam.clockSource = TIMER_B_CLOCKSOURCE_SMCLK;
+    upParam.clockSourceDivider = CLOCK_TIMER_B_TICK;
+    upParam.timerPeriod = CONTROL_PWM_PERIOD - 1;
+    upParam.timerInterruptEnable_TBIE = TIMER_B_TBIE_INTERRUPT_DISABLE;
+    upParam.captureCompareInterruptEnable_CCR0_CCIE =
+        TIMER_B_CCIE_CCR0_INTERRUPT_DISABLE;
+    upParam.timerClear = TIMER_B_DO_CLEAR;
+    upParam.startTimer = false;
+    Timer_B_initUpMode(TIMER_B0_BASE, &upParam);
+
+    for (loop = 0; loop < CONTROL_LOOPS; loop++)
+    {
+        const Control_Loop_Config *config = &controlConfig[loop];
+        Control_Loop *state = &controlLoops[loop];
+
+        state->latencyMin = 0xFFFF;
+        state->latencyMax = 0;
+        state->latencySum = 0;
+        state->reportRuns = 0;
+        state->overruns = 0;
+        state->runs = 0;
+
+        // Start in manual at the low limit, automatic from the first input
+        Pid_Set_Manual(&state->pid, config->pid.outMin);
+        state->autoPending = 1;
+
+        if (!config->enabled)
+        {
+            continue;
+        }
+
+        if (config->output == CONTROL_OUT_PWM)
+        {
+            const Control_Output_Pin *pin = &controlPwmPins[config->outputIndex];
+
+            /*
+             * Base address of Timer_B0
+             * Reset/set: high from the start of each period until the
+             * compare value, so the compare value is the on time
+             */
+            Timer_B_initCompareModeParam compareParam = {0};
+            compareParam.compareRegister = pin->compareRegister;
+            compareParam.compareInterruptEnable =
+                TIMER_B_CAPTURECOMPARE_INTERRUPT_DISABLE;
+            compareParam.compareOutputMode = TIMER_B_OUTPUTMODE_RESET_SET;
+            compareParam.compareValue = config->pid.outMin;
+            Timer_B_initCompareMode(TIMER_B0_BASE, &compareParam);
+
+            GPIO_setAsPeripheralModuleFunctionOutputPin(pin->port, pin->pin,
+                GPIO_PRIMARY_MODULE_FUNCTION);
+        }
+        else
+        {
+            const Control_Output_Pin *pin = &controlDoPins[config->outputIndex];
+
+            GPIO_setOutputLowOnPin(pin->port, pin->pin);
+            GPIO_setAsOutputPin(pin->port, pin->pin);
+        }
+    }
+
+    Timer_B_startCounter(TIMER_B0_BASE, TIMER_B_UP_MODE);
+}
+
+static void Control_Write_Output(const Control_Loop_Config *config, uint16_t output)
+{
+    if (config->output == CONTROL_OUT_PWM)
+    {
+        // Straight to TB0CCRn, driverlib's setter is a call too many here
+        HWREG16(TIMER_B0_BASE + OFS_TBxR +
+                controlPwmPins[config->outputIndex].compareRegister) = output;
+    }
+    else
+    {
+        const Control_Output_Pin *pin = &controlDoPins[config->outputIndex];
+
+        if ((output << 1) >= (config->pid.outMin + config->pid.outMax))
+        {
+            GPIO_setOutputHighOnPin(pin->port, pin->pin);
+        }
+        else
+        {
+            GPIO_setOutputLowOnPin(pin->port, pin->pin);
+        }
+    }
+}
+
+/*
+ * Sends a WIRE_TYPE_CONTROL stats record for the loop and starts a new
+ * latency window.
+ */
+static void Control_Report(uint16_t loop)
+{
+    Control_Loop *state = &controlLoops[loop];
+    uint8_t payload[18];
+
+    payload[0] = (uint8_t)loop;
+    payload[1] = (uint8_t)(state->pid.mode | (state->pid.saturated << 1));
+    Wire_Put_U16(&payload[2], state->pid.output);
+    Wire_Put_U16(&payload[4], state->latencyMin);
+    Wire_Put_U16(&payload[6], state->latencyMax);
+    Wire_Put_U16(&payload[8],
+        (uint16_t)(state->latencySum / state->reportRuns));
+    Wire_Put_U16(&payload[10], state->overruns);
+    Wire_Put_U32(&payload[12], state->runs);
+    Wire_Put_U16(&payload[16], state->pid.lastInput);
+
+    // Best effort, the window restarts either way
+    Link_Send(WIRE_TYPE_CONTROL, payload, sizeof(payload));
+
+    state->latencyMin = 0xFFFF;
+    state->latencyMax = 0;
+    state->latencySum = 0;
+    state->reportRuns = 0;
+}
+
+/*
+ * Whenever Timer_A0 restarts, from the scan start and a retime. The
+ * next slot is taken to be on time.
+ */
+void Control_Restart()
+{
+    controlTracking = 0;
+}
+
+/*
+ * Ticks of whole periods between this slot's trigger and the start of
+ * ADC12ISR, 0 unless it started late. Reads the timer again along
+ * with the timestamp, after the loops, so the time taken is off their
+ * latency path.
+ */
+static uint32_t Control_Track(void)
+{
+    uint16_t period = HWREG16(TIMER_A0_BASE + OFS_TAxCCR0) + 1;
+    uint32_t now = Timestamp_Now() * CONTROL_STAMP_TICKS;
+    uint32_t periods = 0;
+    unsigned char wrapped;
+    uint16_t since;
+    int32_t offset;
+
+    // TAIFG, a trigger since the loops started, as of this timer read
+    do
+    {
+        wrapped = (HWREG16(TIMER_A0_BASE + OFS_TAxCTL) & TAIFG) != 0;
+        since = HWREG16(TIMER_A0_BASE + OFS_TAxR) + 1;
+    } while (wrapped != ((HWREG16(TIMER_A0_BASE + OFS_TAxCTL) & TAIFG) != 0));
+
+    /*
+     * now - since is the last trigger. Every period it is past the one
+     * this slot was due on is a trigger that came before the ADC was
+     * armed again. The timestamp is coarser than the timer, so it is
+     * rounded to the nearest period.
+     */
+    offset = (int32_t)(now - since - controlTrigger);
+    if (controlTracking && (offset > (int32_t)(period / 2)))
+    {
+        periods = ((uint32_t)offset + (period / 2)) / period;
+    }
+
+    // Those are lost, the ADC only takes the one after
+    controlTrigger = now - since + period;
+    controlSince = since;
+    controlTracking = 1;
+
+    if (wrapped)
+    {
+        return (periods > 0) ? (periods - 1) * period : 0;
+    }
+    return periods * period;
+}
+
+/*
+ * From ADC12ISR right after it re-arms the ADC for the next slot. The
+ * timer back below where Control_Track() read it means a trigger came
+ * in between, too early to be taken, so the next slot is on the one
+ * after.
+ */
+void Control_Slot_Armed()
+{
+    if ((HWREG16(TIMER_A0_BASE + OFS_TAxR) + 1) < controlSince)
+    {
+        controlTrigger += HWREG16(TIMER_A0_BASE + OFS_TAxCCR0) + 1;
+    }
+}
+
+/*
+ * Called from ADC12ISR with the slot's raw samples, first thing, in
+ * every slot, empty ones included, so trigger tracking sees them all.
+ */
+void Control_Run(const Scan_Frame *frame)
+{
+    uint16_t period = HWREG16(TIMER_A0_BASE + OFS_TAxCCR0) + 1;
+    uint16_t ran = 0;
+    uint32_t late;
+    uint16_t loop;
+
+    /*
+     * This slot's trigger set TAIFG, and so did the next one if
+     * ADC12ISR started late, which Control_Track() sorts out. From
+     * here it sets again if a trigger comes while the loops run.
+     */
+    HWREG16(TIMER_A0_BASE + OFS_TAxCTL) &= ~TAIFG;
+
+    for (loop = 0; loop < CONTROL_LOOPS; loop++)
+    {
+        const Control_Loop_Config *config = &controlConfig[loop];
+        Control_Loop *state = &controlLoops[loop];
+        uint16_t input;
+        uint16_t latency;
+
+        if (!config->enabled ||
+            !(frame->channelMask & ((uint16_t)1 << config->channel)))
+        {
+            continue;
+        }
+
+        input = frame->sample[config->channel];
+        if (state->autoPending)
+        {
+            state->autoPending = 0;
+            Pid_Set_Auto(&config->pid, &state->pid, input);
+        }
+        Control_Write_Output(config, Pid_Update(&config->pid, &state->pid, input));
+
+        // The trigger edge is TA0R reaching TA0CCR0, one tick before 0
+        latency = HWREG16(TIMER_A0_BASE + OFS_TAxR) + 1;
+        if (HWREG16(TIMER_A0_BASE + OFS_TAxCTL) & TAIFG)
+        {
+            latency += period;
+        }
+        state->latency = latency;
+        ran |= (uint16_t)1 << loop;
+    }
+
+    // Off the latency path from here
+    late = Control_Track();
+
+    for (loop = 0; loop < CONTROL_LOOPS; loop++)
+    {
+        Control_Loop *state = &controlLoops[loop];
+        uint32_t total;
+        uint16_t latency;
+
+        if (!(ran & ((uint16_t)1 << loop)))
+        {
+            continue;
+        }
+
+        total = state->latency + late;
+        latency = (total > 0xFFFF) ? 0xFFFF : (uint16_t)total;
+        if ((latency >= period) || (latency > CONTROL_DEADLINE_TICKS))
+        {
+            state->overruns++;
+        }
+
+        state->latency = latency;
+        if (latency < state->latencyMin)
+        {
+            state->latencyMin = latency;
+        }
+        if (latency > state->latencyMax)
+        {
+            state->latencyMax = latency;
+        }
+        state->latencySum += latency;
+        state->reportRuns++;
+        state->runs++;
+    }
+
+    // Reporting is off the latency path, after every output is written
+    for (loop = 0; loop < CONTROL_LOOPS; loop++)
+    {
+        if (controlLoops[loop].reportRuns >= CONTROL_REPORT_RUNS)
+        {
+            Control_Report(loop);
+        }
+    }
+}
+
+/*
+ * Holds the loop's output at output until Control_Set_Auto().
+ */
+void Control_Set_Manual(uint16_t loop, uint16_t output)
+{
+    uint16_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    Pid_Set_Manual(&controlLoops[loop].pid, output);
+    controlLoops[loop].autoPending = 0;
+    __set_interrupt_state(state);
+}
+
+/*
+ * Back to automatic, bumpless from the current output, on the loop's
+ * next input.
+ */
+void Control_Set_Auto(uint16_t loop)
+{
+    uint16_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    controlLoops[loop].autoPending = 1;
+    __set_interrupt_state(state);
+}
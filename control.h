@@ -0,0 +1,83 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Closed-loop control locked to ADC scan completion.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#ifndef AI_SCANNER_CONTROL_H_
+#define AI_SCANNER_CONTROL_H_
+
+#include <stdint.h>
+#include "pid.h"
+#include "scan.h"
+
+#define CONTROL_LOOPS           2
+
+/*
+ * Output kinds. A PWM output is a Timer_B0 channel, 0 to
+ * CONTROL_PWM_PERIOD counts of on time. A DO output is a GPIO driven
+ * high while the loop output is in the upper half of its range.
+ */
+#define CONTROL_OUT_PWM         0
+#define CONTROL_OUT_DO          1
+
+// Timer_B0 at CLOCK_TICK_HZ, 1 kHz PWM
+#define CONTROL_PWM_PERIOD      1000
+
+/*
+ * A loop whose output is written later than this after the scan
+ * trigger, in Timer_A0 ticks (1 us), counts as an overrun.
+ */
+#define CONTROL_DEADLINE_TICKS  500
+
+// Latency stats go out on the link every this many runs of a loop
+#define CONTROL_REPORT_RUNS     100
+
+typedef struct
+{
+    uint8_t enabled;
+    uint8_t channel;
+    uint8_t output;
+    uint8_t outputIndex;
+    Pid_Config pid;
+} Control_Loop_Config;
+
+/*
+ * Latency is from the TA0.1 edge that triggered the scan to the loop's
+ * output register write, in Timer_A0 ticks. Min, max and sum cover the
+ * runs since the last stats report; max - min is the jitter.
+ */
+typedef struct
+{
+    Pid_State pid;
+    uint16_t latency;
+    uint16_t latencyMin;
+    uint16_t latencyMax;
+    uint32_t latencySum;
+    uint16_t reportRuns;
+    uint16_t overruns;
+    uint32_t runs;
+    uint8_t autoPending;
+} Control_Loop;
+
+// Loop state, in SRAM
+#define CONTROL_SRAM_BYTES      (CONTROL_LOOPS * sizeof(Control_Loop))
+
+extern Control_Loop_Config controlConfig[CONTROL_LOOPS];
+extern Control_Loop controlLoops[CONTROL_LOOPS];
+
+void Init_Control(void);
+void Control_Restart(void);
+void Control_Run(const Scan_Frame *frame);
+void Control_Slot_Armed(void);
+void Control_Set_Manual(uint16_t loop, uint16_t output);
+void Control_Set_Auto(uint16_t loop);
+
+#endif /* AI_SCANNER_CONTROL_H_ */
@@ -0,0 +1,366 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Duty cycled acquisition: a burst of scans every interval, LPM3 in
+ * between.
+ *
+ * Timer_A1 runs from ACLK, the VLO, which keeps going in LPM3. Every
+ * dutyConfig.intervalMs it wakes main(), which powers the reference
+ * up and starts the scan. ADC12ISR counts the burst's slots, stops
+ * the timer-paced scan after the last one and takes a health reading.
+ * main() then powers the ADC and the reference down, and once the
+ * link has sent everything queued, stops the timestamp and goes to
+ * LPM3 rather than LPM0: the DCO, SMCLK and everything clocked from
+ * them stop until the next wake.
+ *
+ * Each cycle is accounted: time awake, time the CPU was executing
+ * and time the ADC was converting, MODOSC only running while it does.
+ * main() and ADC12ISR are measured on the timestamp. The link's TX
+ * interrupt (LINK_TX_ISR_CYCLES a byte) and the ADC (the schedule's
+ * conversion clocks at MODOSC's minimum) are model figures, not
+ * measurements. energy.c turns that into energy per cycle and per
+ * scan, sent in a WIRE_TYPE_DUTY record at the start of the next
+ * cycle, when its sleep is known.
+ *
+ * The timestamp only counts awake time in this mode, and the
+ * interval is only as accurate as the VLO. The UART doesn't receive
+ * in LPM3, so commands are only taken while the board is awake.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#include <driverlib.h>
+#include "duty.h"
+#include "adc.h"
+#include "burst.h"
+#include "health.h"
+#include "link.h"
+#include "memory.h"
+#include "sched.h"
+#include "timestamp.h"
+#include "wire.h"
+
+/*
+ * Off, scanning continuously, until set up for a site. Lives in FRAM
+ * so the setting survives resets.
+ */
+MEM_FRAM(dutyConfig)
+Duty_Config dutyConfig = { 0, 10000, 1 };
+
+volatile unsigned char dutyState = DUTY_IDLE;
+
+static volatile unsigned char dutyDue = 0;
+static unsigned char dutyAsleep = 0;
+static uint16_t dutyPeriods = 1;
+static volatile uint16_t dutyCountdown = 1;
+static volatile uint16_t dutyRemaining = 0;
+static volatile uint32_t dutyIsrCycles = 0;
+static volatile uint32_t dutyAdcClocks = 0;
+static uint16_t dutyHealthSamples = 0;
+static uint32_t dutyCycleTicks = 0;
+static uint32_t dutyWokeTicks = 0;
+static uint32_t dutyCpuTicks = 0;
+static uint32_t dutyTxCount = 0;
+static Energy_Cycle dutyCycle;
+
+static uint32_t Duty_Ticks_To_Us(uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * 1000000UL) / TIMESTAMP_HZ);
+}
+
+/*
+ * Starts a cycle with the reference up. main() starts the scan itself.
+ */
+static void Duty_Begin(uint32_t wokeTicks)
+{
+    dutyCycleTicks = wokeTicks;
+    dutyCpuTicks = 0;
+    dutyIsrCycles = 0;
+    dutyAdcClocks = 0;
+    dutyTxCount = Link_Tx_Count();
+    dutyCycle.scans = dutyConfig.scans ? dutyConfig.scans : 1;
+    dutyRemaining = dutyCycle.scans;
+
+    /*
+     * Farmed out to health suite.
+     */
+    Health_Power(1);
+
+    dutyState = DUTY_SCANNING;
+}
+
+/*
+ * Last cycle's accounts, now its sleep is known.
+ */
+static void Duty_Report(void)
+{
+    uint8_t payload[DUTY_RECORD_BYTES];
+    uint32_t intervalUs = dutyConfig.intervalMs * 1000UL;
+    uint16_t supplyMv = healthStatus.supplyMv ? healthStatus.supplyMv :
+                                                ENERGY_NOMINAL_MV;
+    uint32_t cycleNj;
+
+    dutyCycle.sleepUs = (intervalUs > dutyCycle.awakeUs) ?
+                        (intervalUs - dutyCycle.awakeUs) : 0;
+
+    /*
+     * Farmed out to energy suite.
+     */
+    cycleNj = Energy_Cycle_Nj(&dutyCycle, supplyMv, CLOCK_MCLK_HZ);
+
+    Wire_Put_U16(&payload[0], dutyCycle.scans);
+    Wire_Put_U32(&payload[2], dutyCycle.awakeUs);
+    Wire_Put_U32(&payload[6], dutyCycle.cpuUs);
+    Wire_Put_U32(&payload[10], dutyCycle.adcUs);
+    Wire_Put_U32(&payload[14], dutyCycle.sleepUs);
+    Wire_Put_U32(&payload[18], cycleNj);
+    Wire_Put_U32(&payload[22], cycleNj / dutyCycle.scans);
+    Wire_Put_U32(&payload[26], Energy_Average_Na(cycleNj, intervalUs, supplyMv));
+    Link_Send(WIRE_TYPE_DUTY, payload, DUTY_RECORD_BYTES);
+}
+
+/*
+ * ADC off between bursts, once the closing health reading is in.
+ */
+static void Duty_Power_Down(void)
+{
+    ADC12_B_disableConversions(ADC12_B_BASE, ADC12_B_COMPLETECONVERSION);
+    ADC12_B_disable(ADC12_B_BASE);
+
+    dutyCycle.adcUs = (uint32_t)(((uint64_t)(dutyAdcClocks + HEALTH_ADC_CLOCKS) *
+                                  1000000UL) / SCHED_ADC_CLOCK_HZ);
+    dutyState = DUTY_DONE;
+}
+
+void Init_Duty()
+{
+    uint32_t ticks;
+
+    if (!dutyConfig.enabled)
+    {
+        return;
+    }
+
+    // In two steps, a day of ms times the timer rate overflows 32 bits
+    ticks = ((dutyConfig.intervalMs / 1000UL) * DUTY_TIMER_HZ) +
+            (((dutyConfig.intervalMs % 1000UL) * DUTY_TIMER_HZ) / 1000UL);
+    if (ticks < 2)
+    {
+        ticks = 2;
+    }
+
+    // Intervals past the 16-bit timer take several equal periods
+    dutyPeriods = (uint16_t)((ticks + 0xFFFFUL) / 0x10000UL);
+    dutyCountdown = dutyPeriods;
+
+    /*
+     * Base address of Timer_A1
+     * ACLK divided by 64, up mode, CCR0 interrupt every period
+     * ACLK keeps running in LPM3, see the operating modes in
+     * Reference 3.
+     */
+    Timer_A_initUpModeParam upParam = {0};
+    upParam.clockSource = TIMER_A_CLOCKSOURCE_ACLK;
+    upParam.clockSourceDivider = TIMER_A_CLOCKSOURCE_DIVIDER_64;
+    upParam.timerPeriod = (uint16_t)((ticks / dutyPeriods) - 1);
+    upParam.timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_DISABLE;
+    upParam.captureCompareInterruptEnable_CCR0_CCIE =
+        TIMER_A_CCIE_CCR0_INTERRUPT_ENABLE;
+    upParam.timerClear = TIMER_A_DO_CLEAR;
+    upParam.startTimer = true;
+    Timer_A_initUpMode(TIMER_A1_BASE, &upParam);
+
+    // The boot scan is the first burst
+    Duty_Begin(0);
+}
+
+/*
+ * End of a scan slot, from ADC12ISR, with the cycles the ISR measured
+ * and the ADC's clocks for it. After the burst's last slot, stops the
+ * scan and takes a health reading in its place. Returns 1 then, to
+ * wake main(), and 0 while the scan carries on.
+ */
+unsigned char Duty_Slot_Done(uint32_t isrCycles, uint32_t adcClocks)
+{
+    if (dutyState != DUTY_SCANNING)
+    {
+        return 0;
+    }
+
+    dutyIsrCycles += isrCycles;
+    dutyAdcClocks += adcClocks;
+    if (--dutyRemaining != 0)
+    {
+        return 0;
+    }
+
+    /*
+     * Farmed out to adc suite.
+     */
+    Stop_Scan();
+
+    dutyHealthSamples = healthStatus.samples;
+    dutyState = DUTY_FINISHING;
+
+    /*
+     * Farmed out to health suite.
+     */
+    Health_Begin();
+
+    return 1;
+}
+
+/*
+ * How deep main() sleeps next: LPM3 once a burst is over and the link
+ * has drained, LPM0 while anything needs SMCLK, and not at all if a
+ * burst is due. Call with interrupts disabled, right before sleeping.
+ */
+unsigned int Duty_Sleep_Bits()
+{
+    uint32_t now;
+
+    if (!dutyConfig.enabled)
+    {
+        return LPM0_bits;
+    }
+
+    now = Timestamp_Now();
+    dutyCpuTicks += now - dutyWokeTicks;
+
+    if (((dutyState != DUTY_IDLE) && (dutyState != DUTY_DONE)) ||
+        (burstState != BURST_IDLE))
+    {
+        return LPM0_bits;
+    }
+
+    // Next burst due, Duty_Service() starts it
+    if (dutyDue)
+    {
+        return 0;
+    }
+
+    // LPM3 stops SMCLK under the UART
+    if (!Link_Tx_Idle())
+    {
+        Link_Wake_On_Drain();
+        return LPM0_bits;
+    }
+
+    if (dutyState == DUTY_DONE)
+    {
+        // Close the books on this cycle
+        dutyCycle.awakeUs = Duty_Ticks_To_Us(now - dutyCycleTicks);
+        dutyCycle.refUs = dutyCycle.awakeUs;
+        dutyIsrCycles += (Link_Tx_Count() - dutyTxCount) * LINK_TX_ISR_CYCLES;
+        dutyCycle.cpuUs = Duty_Ticks_To_Us(dutyCpuTicks) +
+            (uint32_t)(((uint64_t)dutyIsrCycles * 1000000UL) / SCHED_MCLK_HZ);
+        dutyState = DUTY_IDLE;
+
+        /*
+         * Farmed out to health suite.
+         */
+        Health_Power(0);
+    }
+
+    // A timer counting SMCLK would keep the DCO requested through LPM3
+    Timestamp_Pause();
+    dutyAsleep = 1;
+
+    return LPM3_bits;
+}
+
+/*
+ * First thing after every wake.
+ */
+void Duty_Wake()
+{
+    if (!dutyConfig.enabled)
+    {
+        return;
+    }
+
+    if (dutyAsleep)
+    {
+        dutyAsleep = 0;
+        Timestamp_Resume();
+    }
+    dutyWokeTicks = Timestamp_Now();
+}
+
+/*
+ * After a fast burst has taken the ADC over: 1 if the scan should
+ * start again. Between duty cycle bursts it stays off instead, with
+ * the ADC powered down. A health reading the fast burst cut short
+ * gets taken again after one more slot.
+ */
+unsigned char Duty_Scan_Wanted()
+{
+    if (!dutyConfig.enabled || (dutyState == DUTY_SCANNING))
+    {
+        return 1;
+    }
+
+    if (dutyState == DUTY_FINISHING)
+    {
+        dutyRemaining = 1;
+        dutyState = DUTY_SCANNING;
+        return 1;
+    }
+
+    ADC12_B_disable(ADC12_B_BASE);
+    return 0;
+}
+
+/*
+ * From main(), after Health_Service(). Powers down after a burst, and
+ * returns 1 when the next one is due, for main() to start the scan.
+ */
+unsigned char Duty_Service()
+{
+    if (!dutyConfig.enabled)
+    {
+        return 0;
+    }
+
+    if ((dutyState == DUTY_FINISHING) &&
+        (healthStatus.samples != dutyHealthSamples))
+    {
+        Duty_Power_Down();
+    }
+
+    if (dutyDue && ((dutyState == DUTY_IDLE) || (dutyState == DUTY_DONE)))
+    {
+        dutyDue = 0;
+        // A cycle still draining the link runs into this one, unreported
+        if (dutyState == DUTY_IDLE)
+        {
+            Duty_Report();
+        }
+        Duty_Begin(dutyWokeTicks);
+        return 1;
+    }
+
+    return 0;
+}
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(TIMER1_A0_VECTOR)))
+#endif
+void TIMER1_A0_ISR (void)
+{
+    // CCIFG of CCR0 clears itself on the way in
+    if (--dutyCountdown == 0)
+    {
+        dutyCountdown = dutyPeriods;
+        dutyDue = 1;
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
+}
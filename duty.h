@@ -0,0 +1,57 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Duty cycled acquisition: a burst of scans every interval, LPM3 in
+ * between.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#ifndef AI_SCANNER_DUTY_H_
+#define AI_SCANNER_DUTY_H_
+
+#include <stdint.h>
+#include "clock.h"
+#include "energy.h"
+
+/*
+ * enabled 0 scans continuously, as without the duty suite. Otherwise
+ * every intervalMs the scan runs for scans slots from the first slot
+ * of the schedule, which converts every channel, then the board goes
+ * back to sleep.
+ */
+typedef struct
+{
+    uint8_t enabled;
+    uint32_t intervalMs;
+    uint16_t scans;
+} Duty_Config;
+
+#define DUTY_IDLE           0   /* between bursts                      */
+#define DUTY_SCANNING       1
+#define DUTY_FINISHING      2   /* health reading after the last slot  */
+#define DUTY_DONE           3   /* ADC off, link draining              */
+
+// Timer_A1 counts ACLK / 64, ~147 Hz on the VLO
+#define DUTY_TIMER_HZ       (CLOCK_ACLK_HZ / 64)
+
+#define DUTY_RECORD_BYTES   30
+
+#define DUTY_SRAM_BYTES     (sizeof(Energy_Cycle) + 40)
+
+extern Duty_Config dutyConfig;
+extern volatile unsigned char dutyState;
+
+void Init_Duty(void);
+unsigned char Duty_Slot_Done(uint32_t isrCycles, uint32_t adcClocks);
+unsigned int Duty_Sleep_Bits(void);
+void Duty_Wake(void);
+unsigned char Duty_Scan_Wanted(void);
+unsigned char Duty_Service(void);
+
+#endif /* AI_SCANNER_DUTY_H_ */
@@ -0,0 +1,64 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Energy model of a duty cycle, from the time spent in each mode.
+ *
+ * The duty suite measures how long each cycle keeps the CPU, the ADC
+ * and the reference up and works out the charge drawn from the
+ * currents in energy.h. host/dutysim.c checks the estimate against a
+ * slot by slot timeline of a cycle, and uses it to size the interval
+ * and burst for a battery life.
+ *
+ * Portable, shared with the host tools.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ *
+ */
+
+#include "energy.h"
+
+uint32_t Energy_Active_Ua(uint32_t mclkHz)
+{
+    return ENERGY_ACTIVE_BASE_UA + ((ENERGY_ACTIVE_UA_PER_MHZ * mclkHz) / 1000000UL);
+}
+
+uint32_t Energy_Lpm0_Ua(uint32_t mclkHz)
+{
+    return ENERGY_LPM0_BASE_UA + ((ENERGY_LPM0_UA_PER_MHZ * mclkHz) / 1000000UL);
+}
+
+/*
+ * Energy of one cycle in nJ. uA times us is pC, times mV is 1e-6 nJ.
+ */
+uint32_t Energy_Cycle_Nj(const Energy_Cycle *cycle, uint16_t supplyMv,
+                         uint32_t mclkHz)
+{
+    uint32_t idleUs = (cycle->awakeUs > cycle->cpuUs) ?
+                      (cycle->awakeUs - cycle->cpuUs) : 0;
+    uint64_t charge;
+
+    charge = ((uint64_t)Energy_Active_Ua(mclkHz) * cycle->cpuUs) +
+             ((uint64_t)Energy_Lpm0_Ua(mclkHz) * idleUs) +
+             ((uint64_t)ENERGY_ADC_UA * cycle->adcUs) +
+             ((uint64_t)ENERGY_REF_UA * cycle->refUs) +
+             (((uint64_t)ENERGY_LPM3_NA * cycle->sleepUs) / 1000U);
+
+    return (uint32_t)(((charge * supplyMv) + 500000U) / 1000000U);
+}
+
+/*
+ * Average supply current in nA of a cycle repeated every intervalUs.
+ */
+uint32_t Energy_Average_Na(uint32_t cycleNj, uint32_t intervalUs,
+                           uint16_t supplyMv)
+{
+    if ((intervalUs == 0) || (supplyMv == 0))
+    {
+        return 0;
+    }
+
+    return (uint32_t)(((uint64_t)cycleNj * 1000000000ULL) /
+                      ((uint64_t)intervalUs * supplyMv));
+}
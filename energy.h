@@ -0,0 +1,60 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Energy model of a duty cycle, from the time spent in each mode.
+ *
+ * Portable, shared with the host tools.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ *
+ */
+
+#ifndef AI_SCANNER_ENERGY_H_
+#define AI_SCANNER_ENERGY_H_
+
+#include <stdint.h>
+
+/*
+ * Supply currents at 3 V and 25 degC, typical figures from the
+ * electrical characteristics in Reference 1 rounded to a linear fit
+ * over the clock profiles. Active mode runs from FRAM with the cache
+ * mostly hitting. LPM3 is with the VLO and no RTC; the LCD adds a few
+ * uA on top if it is left on.
+ */
+#define ENERGY_ACTIVE_BASE_UA       90
+#define ENERGY_ACTIVE_UA_PER_MHZ    105
+#define ENERGY_LPM0_BASE_UA         55
+#define ENERGY_LPM0_UA_PER_MHZ      19
+#define ENERGY_LPM3_NA              900
+#define ENERGY_ADC_UA               215     /* ADC12_B converting + MODOSC   */
+#define ENERGY_REF_UA               50      /* REF_A at 2.0 V, temp sensor   */
+
+// Supply assumed until there is a health reading
+#define ENERGY_NOMINAL_MV           3000
+
+/*
+ * One duty cycle. awakeUs runs from the wake to going back to LPM3,
+ * the CPU is executing for cpuUs of it and in LPM0 for the rest. The
+ * ADC is converting for adcUs and the reference is up for refUs.
+ * sleepUs is the rest of the interval, in LPM3.
+ */
+typedef struct
+{
+    uint32_t awakeUs;
+    uint32_t cpuUs;
+    uint32_t adcUs;
+    uint32_t refUs;
+    uint32_t sleepUs;
+    uint16_t scans;
+} Energy_Cycle;
+
+uint32_t Energy_Active_Ua(uint32_t mclkHz);
+uint32_t Energy_Lpm0_Ua(uint32_t mclkHz);
+uint32_t Energy_Cycle_Nj(const Energy_Cycle *cycle, uint16_t supplyMv,
+                         uint32_t mclkHz);
+uint32_t Energy_Average_Na(uint32_t cycleNj, uint32_t intervalUs,
+                           uint16_t supplyMv);
+
+#endif /* AI_SCANNER_ENERGY_H_ */
@@ -0,0 +1,246 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Per-channel filter chain, a stage of the scan pipeline.
+ *
+ * The stages picked in filter_config.h are fused into Filter_Sample(),
+ * so each converted sample goes through median, biquad, moving average
+ * and decimation in one go, with the channel's state loaded once,
+ * rather than the frame being walked once per stage.
+ *
+ * Everything is integer: samples stay 12-bit, the biquad runs in Q14
+ * with its rounding error fed back into the next output so a DC input
+ * settles exactly, and the moving average keeps a running sum.
+ *
+ * host/filterbench.c measures cost and accuracy per configuration.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#include "filter.h"
+
+// Only takes room when a stage is on, see FILTER_SRAM_BYTES
+#if FILTER_ANY
+Filter_Channel filterState[SCAN_CHANNELS];
+#endif
+
+/*
+ * Every channel restarts from its next sample, e.g. after the schedule
+ * changes its rate.
+ */
+void Filter_Reset(void)
+{
+#if FILTER_ANY
+    uint16_t channel;
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        filterState[channel].primed = 0;
+    }
+#endif
+}
+
+/*
+ * Fills the state as if the channel had always read sample, so the
+ * output doesn't ramp up from zero after a reset.
+ */
+static void Filter_Prime(Filter_Channel *state, uint16_t sample)
+{
+#if FILTER_MEDIAN || FILTER_AVERAGE_SHIFT
+    uint16_t i;
+#endif
+
+#if FILTER_MEDIAN
+    for (i = 0; i < FILTER_MEDIAN - 1; i++)
+    {
+        state->history[i] = sample;
+    }
+#endif
+#if FILTER_BIQUAD
+    state->x1 = (int16_t)sample;
+    state->x2 = (int16_t)sample;
+    state->y1 = (int16_t)sample;
+    state->y2 = (int16_t)sample;
+    state->error = 0;
+#endif
+#if FILTER_AVERAGE_SHIFT
+    for (i = 0; i < (1 << FILTER_AVERAGE_SHIFT); i++)
+    {
+        state->ring[i] = sample;
+    }
+    state->sum = (uint16_t)(sample << FILTER_AVERAGE_SHIFT);
+    state->index = 0;
+#endif
+#if FILTER_DECIMATE > 1
+    state->count = 0;
+#endif
+    (void)sample;
+    state->primed = 1;
+}
+
+#if FILTER_MEDIAN
+static uint16_t Filter_Median(Filter_Channel *state, uint16_t sample)
+{
+    uint16_t a = state->history[0];
+    uint16_t b = state->history[1];
+#if FILTER_MEDIAN == 3
+    uint16_t low;
+    uint16_t high;
+
+    state->history[0] = b;
+    state->history[1] = sample;
+
+    low = (a < b) ? a : b;
+    high = (a < b) ? b : a;
+    if (sample <= low)
+    {
+        return low;
+    }
+    return (sample < high) ? sample : high;
+#else
+    uint16_t window[5];
+    uint16_t i;
+    uint16_t j;
+
+    window[0] = a;
+    window[1] = b;
+    window[2] = state->history[2];
+    window[3] = state->history[3];
+    window[4] = sample;
+    state->history[0] = window[1];
+    state->history[1] = window[2];
+    state->history[2] = window[3];
+    state->history[3] = sample;
+
+    // Insertion sort the window, the median ends up in the middle
+    for (i = 1; i < 5; i++)
+    {
+        uint16_t value = window[i];
+
+        for (j = i; (j > 0) && (window[j - 1] > value); j--)
+        {
+            window[j] = window[j - 1];
+        }
+        window[j] = value;
+    }
+    return window[2];
+#endif
+}
+#endif
+
+#if FILTER_BIQUAD
+static uint16_t Filter_Biquad(Filter_Channel *state, uint16_t sample)
+{
+    int32_t acc;
+    int16_t y;
+
+    acc = (FILTER_BIQUAD_B0 * (int32_t)sample) +
+          (FILTER_BIQUAD_B1 * (int32_t)state->x1) +
+          (FILTER_BIQUAD_B2 * (int32_t)state->x2) -
+          (FILTER_BIQUAD_A1 * (int32_t)state->y1) -
+          (FILTER_BIQUAD_A2 * (int32_t)state->y2) +
+          state->error;
+
+    // Floor, with the remainder carried into the next sample
+    y = (int16_t)(acc >> FILTER_BIQUAD_SHIFT);
+    state->error = (int16_t)(acc - ((int32_t)y << FILTER_BIQUAD_SHIFT));
+
+    state->x2 = state->x1;
+    state->x1 = (int16_t)sample;
+    state->y2 = state->y1;
+    state->y1 = y;
+
+    if (y < 0)
+    {
+        return 0;
+    }
+    if (y > FILTER_FULL_SCALE)
+    {
+        return FILTER_FULL_SCALE;
+    }
+    return (uint16_t)y;
+}
+#endif
+
+#if FILTER_AVERAGE_SHIFT
+static uint16_t Filter_Average(Filter_Channel *state, uint16_t sample)
+{
+    uint8_t index = state->index;
+
+    state->sum = (uint16_t)(state->sum - state->ring[index] + sample);
+    state->ring[index] = sample;
+    state->index = (uint8_t)((index + 1) & ((1 << FILTER_AVERAGE_SHIFT) - 1));
+
+    return (uint16_t)((state->sum + (1 << (FILTER_AVERAGE_SHIFT - 1))) >>
+                      FILTER_AVERAGE_SHIFT);
+}
+#endif
+
+/*
+ * Runs one sample through the chain. due is cleared when decimation
+ * throws this output away.
+ */
+uint16_t Filter_Sample(Filter_Channel *state, uint16_t sample, unsigned char *due)
+{
+    if (!state->primed)
+    {
+        Filter_Prime(state, sample);
+    }
+
+#if FILTER_MEDIAN
+    sample = Filter_Median(state, sample);
+#endif
+#if FILTER_BIQUAD
+    sample = Filter_Biquad(state, sample);
+#endif
+#if FILTER_AVERAGE_SHIFT
+    sample = Filter_Average(state, sample);
+#endif
+#if FILTER_DECIMATE > 1
+    state->count++;
+    if (state->count < FILTER_DECIMATE)
+    {
+        *due = 0;
+        return sample;
+    }
+    state->count = 0;
+#endif
+    *due = 1;
+
+    return sample;
+}
+
+/*
+ * Filters every converted channel in the frame. Channels decimation
+ * holds back are taken out of channelMask, and a frame left with no
+ * channels is dropped.
+ */
+#if FILTER_ANY
+void Filter_Stage(Scan_Frame *frame)
+{
+    uint16_t pending = frame->channelMask & FILTER_CHANNEL_MASK;
+    uint16_t channel;
+    unsigned char due;
+
+    for (channel = 0; pending != 0; channel++, pending >>= 1)
+    {
+        if (!(pending & 1))
+        {
+            continue;
+        }
+        frame->sample[channel] = Filter_Sample(&filterState[channel],
+                                               frame->sample[channel], &due);
+        if (!due)
+        {
+            frame->channelMask &= (uint16_t)~((uint16_t)1 << channel);
+        }
+    }
+
+    if (frame->channelMask == 0)
+    {
+        frame->flags |= SCAN_FRAME_DROP;
+    }
+}
+#endif
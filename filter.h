@@ -0,0 +1,61 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Per-channel filter chain, a stage of the scan pipeline.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#ifndef AI_SCANNER_FILTER_H_
+#define AI_SCANNER_FILTER_H_
+
+#include <stdint.h>
+#include "scan.h"
+#include "filter_config.h"
+
+#define FILTER_FULL_SCALE   0x0FFF
+
+/*
+ * Everything one channel's chain needs, in one record, so filtering a
+ * sample only touches a few consecutive words. Stages that are
+ * configured off take no room.
+ */
+typedef struct
+{
+#if FILTER_MEDIAN
+    uint16_t history[FILTER_MEDIAN - 1];
+#endif
+#if FILTER_BIQUAD
+    int16_t x1;
+    int16_t x2;
+    int16_t y1;
+    int16_t y2;
+    int16_t error;
+#endif
+#if FILTER_AVERAGE_SHIFT
+    uint16_t ring[1 << FILTER_AVERAGE_SHIFT];
+    uint16_t sum;
+    uint8_t index;
+#endif
+#if FILTER_DECIMATE > 1
+    uint8_t count;
+#endif
+    uint8_t primed;
+} Filter_Channel;
+
+// Filter state, in SRAM
+#if FILTER_ANY
+#define FILTER_SRAM_BYTES   (SCAN_CHANNELS * sizeof(Filter_Channel))
+#else
+#define FILTER_SRAM_BYTES   0
+#endif
+
+extern Filter_Channel filterState[SCAN_CHANNELS];
+
+void Filter_Reset(void);
+uint16_t Filter_Sample(Filter_Channel *state, uint16_t sample, unsigned char *due);
+void Filter_Stage(Scan_Frame *frame);
+
+#endif /* AI_SCANNER_FILTER_H_ */
@@ -0,0 +1,96 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Compile-time configuration of the per-channel filter chain.
+ *
+ * Each stage runs in this order on every converted sample of every
+ * channel in FILTER_CHANNEL_MASK:
+ *
+ *   median -> biquad -> moving average -> decimation
+ *
+ * A stage that is switched off here is compiled out entirely, state
+ * and all. Every stage is off until set up for a site, so a plain
+ * build scans unfiltered. Every setting can also be overridden from
+ * the compiler command line (-DFILTER_MEDIAN=3 -DFILTER_BIQUAD=1 ...),
+ * which is how host/filterbench.c is built for each configuration.
+ *
+ */
+
+#ifndef AI_SCANNER_FILTER_CONFIG_H_
+#define AI_SCANNER_FILTER_CONFIG_H_
+
+/*
+ * Channels A0..A15 that are filtered, one bit each. The rest pass
+ * through untouched.
+ */
+#ifndef FILTER_CHANNEL_MASK
+#define FILTER_CHANNEL_MASK     0xFFFF
+#endif
+
+/*
+ * Median window for spike rejection: 0 (off), 3 or 5 samples.
+ */
+#ifndef FILTER_MEDIAN
+#define FILTER_MEDIAN           0
+#endif
+
+/*
+ * Second order IIR section, 0 (off) or 1 (on). Coefficients are Q14,
+ * for y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2. They must have unity
+ * gain at DC, since the filter is primed with the first sample.
+ *
+ * Default coefficients are a Butterworth low pass at 0.1 of the
+ * channel's rate, i.e. 10 Hz for a class 0 channel at the default
+ * 100 Hz slot rate. Override all five coefficients together.
+ */
+#ifndef FILTER_BIQUAD
+#define FILTER_BIQUAD           0
+#endif
+
+#ifndef FILTER_BIQUAD_B0
+#define FILTER_BIQUAD_B0        1105L
+#define FILTER_BIQUAD_B1        2210L
+#define FILTER_BIQUAD_B2        1105L
+#define FILTER_BIQUAD_A1        (-18727L)
+#define FILTER_BIQUAD_A2        6763L
+#endif
+
+#define FILTER_BIQUAD_SHIFT     14
+
+/*
+ * Moving average over 2^FILTER_AVERAGE_SHIFT samples, 0 (off) to 4.
+ */
+#ifndef FILTER_AVERAGE_SHIFT
+#define FILTER_AVERAGE_SHIFT    0
+#endif
+
+/*
+ * Keep one filtered sample in FILTER_DECIMATE per channel, 1 (off) to
+ * 255. Pair it with the moving average or the biquad as the
+ * anti-alias filter. A frame with no channel due for output is
+ * dropped before it reaches the store and emit stages.
+ */
+#ifndef FILTER_DECIMATE
+#define FILTER_DECIMATE         1
+#endif
+
+/*
+ * With every stage off the filter stage leaves the scan pipeline.
+ */
+#define FILTER_ANY  (FILTER_MEDIAN || FILTER_BIQUAD || \
+                     FILTER_AVERAGE_SHIFT || (FILTER_DECIMATE > 1))
+
+#if (FILTER_MEDIAN != 0) && (FILTER_MEDIAN != 3) && (FILTER_MEDIAN != 5)
+#error "FILTER_MEDIAN must be 0, 3 or 5"
+#endif
+
+#if (FILTER_AVERAGE_SHIFT < 0) || (FILTER_AVERAGE_SHIFT > 4)
+#error "FILTER_AVERAGE_SHIFT must be 0 to 4"
+#endif
+
+#if (FILTER_DECIMATE < 1) || (FILTER_DECIMATE > 255)
+#error "FILTER_DECIMATE must be 1 to 255"
+#endif
+
+#endif /* AI_SCANNER_FILTER_CONFIG_H_ */
@@ -43,6 +43,7 @@
 
 #include <driverlib.h>
 #include "hal_LCD.h"
+#include "clock.h"
 #include "string.h"
 
 
@@ -97,7 +98,7 @@ void Init_LCD()
     LCD_C_initParam initParams = {0};
     initParams.clockSource = LCD_C_CLOCKSOURCE_ACLK;
     initParams.clockDivider = LCD_C_CLOCKDIVIDER_1;
-    initParams.clockPrescalar = LCD_C_CLOCKPRESCALAR_16;
+    initParams.clockPrescalar = CLOCK_LCD_PRESCALER;
     initParams.muxRate = LCD_C_4_MUX;
     initParams.waveforms = LCD_C_LOW_POWER_WAVEFORMS;
     initParams.segments = LCD_C_SEGMENTS_ENABLED;
@@ -169,7 +170,8 @@ void displayScrollText(char *msg)
         showChar(buffer[4], pos5);
         showChar(buffer[5], pos6);
 
-        __delay_cycles(200000);
+        // 200 ms per step whatever the clock profile
+        __delay_cycles(CLOCK_MCLK_HZ / 5);
     }
 }
 
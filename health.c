@@ -0,0 +1,237 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Board health: on-chip temperature and AVcc, sampled in the
+ * background of the scan.
+ *
+ * Once every 1 / HEALTH_HZ seconds ADC12ISR converts the temperature
+ * sensor (A30) and AVcc/2 (A31) against the 2.0 V reference. Rather
+ * than take a place in the slot table, and stretch the slot it lands
+ * in, a reading runs in the idle time between the end of one slot and
+ * the next trigger: Health_Slot_Done() only starts it when there are
+ * HEALTH_TICKS to spare, and defers to a later slot otherwise. The scan
+ * channels keep their timing to the tick.
+ *
+ * main() turns the reading into degrees and millivolts with the
+ * device's factory calibration, updates the compensation stage and
+ * sends a WIRE_TYPE_HEALTH record along with the scan's overrun and
+ * drop counts.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#include <driverlib.h>
+#include "health.h"
+#include "comp.h"
+#include "link.h"
+#include "scan.h"
+#include "wire.h"
+
+Health_Status healthStatus;
+
+static uint16_t healthSlots = 1;
+static uint16_t healthCountdown = 1;
+static volatile unsigned char healthReady = 0;
+static unsigned char healthInSlot = 0;
+
+/*
+ * Typical figures for a part with no TLV calibration, from the
+ * temperature sensor table in Reference 1.
+ */
+static const struct s_TLV_ADC_Cal_Data healthTypicalCal =
+{
+    .adc_gain_factor = 0x8000,
+    .adc_offset = 0,
+    .adc_ref20_30_temp = 1775,
+    .adc_ref20_85_temp = 2062,
+};
+
+static const struct s_TLV_ADC_Cal_Data *healthAdcCal = &healthTypicalCal;
+static uint16_t healthRefFactor = 0x8000;
+
+void Init_Health()
+{
+    struct s_TLV_ADC_Cal_Data *adcCal;
+    struct s_TLV_REF_Cal_Data *refCal;
+    uint8_t length;
+
+    /*
+     * Factory calibration from the TLV structure in the device
+     * descriptor, see the Device Descriptor Table in Reference 1.
+     */
+    TLV_getInfo(TLV_TAG_ADC12CAL, 0, &length, (uint16_t **)&adcCal);
+    if (length != 0)
+    {
+        healthAdcCal = adcCal;
+    }
+    TLV_getInfo(TLV_TAG_REFCAL, 0, &length, (uint16_t **)&refCal);
+    if (length != 0)
+    {
+        healthRefFactor = refCal->ref_ref20;
+    }
+
+    /*
+     * Base address of the REF_A module
+     * 2.0 V, left on with the temperature sensor so a reading never
+     * waits for either to settle
+     */
+    Ref_A_setReferenceVoltage(REF_A_BASE, REF_A_VREF2_0V);
+    Ref_A_enableTempSensor(REF_A_BASE);
+    Ref_A_enableReferenceVoltage(REF_A_BASE);
+}
+
+/*
+ * Spreads readings out to HEALTH_HZ at slotHz. Called whenever the
+ * scan starts or changes rate.
+ */
+void Health_Set_Rate(uint16_t slotHz)
+{
+    healthSlots = (slotHz > HEALTH_HZ) ? (slotHz / HEALTH_HZ) : 1;
+    healthCountdown = healthSlots;
+}
+
+/*
+ * End of a scan slot, from ADC12ISR after everything else. Starts a
+ * reading if one is due and it fits before the next trigger.
+ */
+void Health_Slot_Done()
+{
+    if (healthCountdown > 1)
+    {
+        healthCountdown--;
+        return;
+    }
+
+    /*
+     * Cycles past the model come from Sched_Record_Cycles(), and are
+     * only converted to ticks once a reading is due
+     */
+    if (Scan_Ticks_To_Trigger() < HEALTH_TICKS +
+        (uint16_t)(((uint32_t)schedIsrMeasured.excess * (ADC_TIMER_HZ / 1000)) /
+                   (SCHED_MCLK_HZ / 1000)))
+    {
+        // Still due, try the next slot
+        healthStatus.deferrals++;
+        return;
+    }
+
+    healthCountdown = healthSlots;
+    healthInSlot = 1;
+    Start_Internal_Sequence(HEALTH_SAMPLE_HOLD);
+}
+
+/*
+ * Starts a reading straight away, with the scan stopped. For the duty
+ * suite, after the last slot of a burst.
+ */
+void Health_Begin()
+{
+    healthInSlot = 0;
+    Start_Internal_Sequence(HEALTH_SAMPLE_HOLD);
+}
+
+/*
+ * The reference and the temperature sensor on or off, for the duty
+ * suite between bursts. Both are settled long before the burst's
+ * closing reading, after at least one slot.
+ */
+void Health_Power(unsigned char on)
+{
+    if (on)
+    {
+        Ref_A_enableTempSensor(REF_A_BASE);
+        Ref_A_enableReferenceVoltage(REF_A_BASE);
+    }
+    else
+    {
+        Ref_A_disableReferenceVoltage(REF_A_BASE);
+        Ref_A_disableTempSensor(REF_A_BASE);
+    }
+}
+
+/*
+ * ADC12IFG31, both internal channels are in. Hands the ADC back to the
+ * scan before the next trigger. Returns 1 when main() should be woken.
+ */
+unsigned char Health_Complete()
+{
+    healthStatus.rawTemperature =
+        HWREG16(ADC12_B_BASE + OFS_ADC12MEM0 + (2 * ADC_HEALTH_MEMORY));
+    healthStatus.rawSupply =
+        HWREG16(ADC12_B_BASE + OFS_ADC12MEM0 + (2 * (ADC_HEALTH_MEMORY + 1)));
+
+    End_Internal_Sequence(schedActive->config.sampleHold[0]);
+
+    /*
+     * The reading only started with time to spare before the trigger,
+     * and TAIFG was clear. Set now, the trigger came while the ADC was
+     * on software starts, and that slot's sequence never ran.
+     */
+    if (healthInSlot && (HWREG16(TIMER_A0_BASE + OFS_TAxCTL) & TAIFG))
+    {
+        healthStatus.missed++;
+    }
+
+    healthReady = 1;
+    return 1;
+}
+
+/*
+ * AVcc/2 corrected for ADC gain and offset and the reference's error,
+ * as in the ADC12_B calibration section of Reference 3.
+ */
+static uint16_t Health_Correct_Supply(uint16_t raw)
+{
+    int32_t value = (int32_t)(((uint32_t)raw * healthRefFactor) >> 15);
+
+    value = (int32_t)(((uint32_t)value * healthAdcCal->adc_gain_factor) >> 15) +
+            healthAdcCal->adc_offset;
+
+    if (value < 0)
+    {
+        return 0;
+    }
+    return (value > 0x0FFF) ? 0x0FFF : (uint16_t)value;
+}
+
+/*
+ * From main(), once woken by Health_Complete().
+ */
+void Health_Service()
+{
+    uint8_t payload[HEALTH_RECORD_BYTES];
+
+    if (!healthReady)
+    {
+        return;
+    }
+    healthReady = 0;
+
+    healthStatus.temperature = Comp_Temperature(healthStatus.rawTemperature,
+                                                healthAdcCal->adc_ref20_30_temp,
+                                                healthAdcCal->adc_ref20_85_temp);
+    healthStatus.supplyMv =
+        Comp_Supply_Mv(Health_Correct_Supply(healthStatus.rawSupply));
+    healthStatus.samples++;
+
+    /*
+     * Farmed out to comp suite.
+     */
+    Comp_Update(healthStatus.temperature, healthStatus.supplyMv);
+
+    Wire_Put_U16(&payload[0], (uint16_t)healthStatus.temperature);
+    Wire_Put_U16(&payload[2], healthStatus.supplyMv);
+    Wire_Put_U16(&payload[4], healthStatus.rawTemperature);
+    Wire_Put_U16(&payload[6], healthStatus.rawSupply);
+    Wire_Put_U16(&payload[8], Comp_Mask());
+    Wire_Put_U16(&payload[10], healthStatus.deferrals);
+    Wire_Put_U16(&payload[12], scanOverruns);
+    Wire_Put_U16(&payload[14], scanEmitDrops);
+    Wire_Put_U16(&payload[16], healthStatus.missed);
+    Link_Send(WIRE_TYPE_HEALTH, payload, HEALTH_RECORD_BYTES);
+}
@@ -0,0 +1,79 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Board health: on-chip temperature and AVcc, sampled in the
+ * background of the scan.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#ifndef AI_SCANNER_HEALTH_H_
+#define AI_SCANNER_HEALTH_H_
+
+#include <stdint.h>
+#include "adc.h"
+#include "sched.h"
+
+// Readings per second
+#define HEALTH_HZ               1
+
+/*
+ * ADC12SHT code for the internal channels, 192 ADC12CLK cycles or
+ * 40 us on MODOSC. The temperature sensor needs at least 30 us,
+ * see the temperature sensor table in Reference 1.
+ */
+#define HEALTH_SAMPLE_HOLD      7
+#define HEALTH_SAMPLE_CLOCKS    192
+
+// ADC clocks of a reading, both conversions
+#define HEALTH_ADC_CLOCKS       (2UL * (HEALTH_SAMPLE_CLOCKS + SCHED_CONVERT_CLOCKS))
+
+/*
+ * Timer_A0 ticks a reading takes out of a slot: both conversions at
+ * MODOSC's minimum and the ADC12ISR that collects them, plus the
+ * start. A reading only starts when at least this much, plus whatever
+ * the board has measured ADC12ISR running past the model, is left
+ * before the next trigger, so the scan's own conversions never move.
+ */
+#define HEALTH_TICKS            ((uint16_t)( \
+    ((HEALTH_ADC_CLOCKS * ADC_TIMER_HZ) + \
+     SCHED_ADC_CLOCK_HZ - 1) / SCHED_ADC_CLOCK_HZ + \
+    (((uint32_t)(SCHED_ISR_BASE_CYCLES + SCHED_REPROGRAM_CYCLES) * ADC_TIMER_HZ) / \
+     SCHED_MCLK_HZ)))
+
+#define HEALTH_RECORD_BYTES     18
+
+/*
+ * temperature is in 0.01 degC and supplyMv is AVcc. deferrals counts
+ * slots a due reading had to skip for want of time, missed the
+ * triggers lost because a reading still held the ADC anyway.
+ */
+typedef struct
+{
+    int16_t temperature;
+    uint16_t supplyMv;
+    uint16_t rawTemperature;
+    uint16_t rawSupply;
+    uint16_t samples;
+    uint16_t deferrals;
+    uint16_t missed;
+} Health_Status;
+
+#define HEALTH_SRAM_BYTES       (sizeof(Health_Status) + 8)
+
+extern Health_Status healthStatus;
+
+void Init_Health(void);
+void Health_Set_Rate(uint16_t slotHz);
+void Health_Slot_Done(void);
+void Health_Begin(void);
+void Health_Power(unsigned char on);
+unsigned char Health_Complete(void);
+void Health_Service(void);
+
+#endif /* AI_SCANNER_HEALTH_H_ */
@@ -0,0 +1,463 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Host checker for burst captures.
+ *
+ * Reads the byte stream saved off the data link while the node streams
+ * a burst (see burst.c), puts the WIRE_TYPE_BURST_DATA records back
+ * together into one contiguous block of samples and checks it:
+ *
+ *  - every record arrived, in order, and the count matches the header,
+ *  - the node saw no ADC12 overflow, i.e. the DMA kept up,
+ *  - the achieved rate, against the nominal BURST_NOMINAL_HZ,
+ *  - no sample went missing in the data itself. With a sine of a few
+ *    kHz from a signal generator on the channel, a lost sample away
+ *    from the sine's peaks breaks the sine recurrence and shows up as
+ *    a spike in its residual,
+ *  - the node went back to scanning, i.e. scan records follow the
+ *    burst's start. Keep saving the stream for a few slots past the
+ *    end of the burst.
+ *
+ * The stream is the only evidence of the node's burst path from end
+ * to end: an ADC left off never fills the buffer, so no burst or scan
+ * comes out at all.
+ *
+ * Prints PASS or FAIL. The block can be written out as little endian
+ * 16-bit words, or as text, one sample per line.
+ *
+ * Build from the repo root:
+ *   gcc -O2 -I. -o burstcheck host/burstcheck.c wire.c -lm
+ *
+ * Usage:
+ *   burstcheck <stream> [-o block.bin] [-t block.txt] [-k spike factor]
+ *   burstcheck -S <stream> [drop index]   write a synthetic burst
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wire.h"
+#include "burst.h"
+#include "timestamp.h"
+
+#define CHECK_PI                3.14159265358979323846
+
+// Residuals above this many times their RMS count as gaps
+#define CHECK_DEFAULT_FACTOR    8.0
+// ...and above this many LSB, so ADC noise alone never does
+#define CHECK_FLOOR_LSB         8.0
+#define CHECK_MAX_LISTED        10
+
+typedef struct
+{
+    int started;
+    int ended;
+    uint8_t channel;
+    uint16_t samples;
+    uint16_t overflows;
+    uint32_t elapsedTicks;
+    uint32_t rateHz;
+    uint16_t endCount;
+    uint16_t received;
+    uint16_t outOfOrder;
+    unsigned long scans;
+    uint16_t *block;
+} Check_Burst;
+
+static uint8_t *Check_Read_File(const char *path, size_t *length)
+{
+    FILE *file = fopen(path, "rb");
+    uint8_t *data;
+    long size;
+
+    if (file == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc((size > 0) ? (size_t)size : 1);
+    if ((data == NULL) || (fread(data, 1, (size_t)size, file) != (size_t)size))
+    {
+        fprintf(stderr, "burstcheck: can't read %s\n", path);
+        fclose(file);
+        free(data);
+        return NULL;
+    }
+    fclose(file);
+    *length = (size_t)size;
+    return data;
+}
+
+/*
+ * Takes the last complete burst in the stream.
+ */
+static size_t Check_Parse(const uint8_t *data, size_t length, Check_Burst *burst)
+{
+    Wire_Decoder decoder;
+    size_t badRecords = 0;
+    size_t i;
+
+    Wire_Decoder_Reset(&decoder);
+    for (i = 0; i < length; i++)
+    {
+        int result = Wire_Decode_Byte(&decoder, data[i]);
+        const uint8_t *payload = decoder.payload;
+
+        if (result < 0)
+        {
+            badRecords++;
+        }
+        if (result <= 0)
+        {
+            continue;
+        }
+
+        if ((decoder.type == WIRE_TYPE_BURST_START) && (decoder.length == 17))
+        {
+            free(burst->block);
+            memset(burst, 0, sizeof(*burst));
+            burst->started = 1;
+            burst->channel = payload[0];
+            burst->samples = Wire_Get_U16(&payload[1]);
+            burst->overflows = Wire_Get_U16(&payload[3]);
+            burst->elapsedTicks = Wire_Get_U32(&payload[9]);
+            burst->rateHz = Wire_Get_U32(&payload[13]);
+            burst->block = calloc(burst->samples ? burst->samples : 1, sizeof(uint16_t));
+        }
+        else if ((decoder.type == WIRE_TYPE_BURST_DATA) && burst->started &&
+                 !burst->ended && (decoder.length >= 2) && !(decoder.length & 1))
+        {
+            uint16_t offset = Wire_Get_U16(&payload[0]);
+            uint16_t count = (uint16_t)((decoder.length - 2) / 2);
+            uint16_t n;
+
+            if (offset != burst->received)
+            {
+                burst->outOfOrder++;
+            }
+            for (n = 0; (n < count) && ((uint32_t)offset + n < burst->samples); n++)
+            {
+                burst->block[offset + n] = Wire_Get_U16(&payload[2 + (2 * n)]);
+            }
+            burst->received = (uint16_t)(offset + count);
+        }
+        else if ((decoder.type == WIRE_TYPE_BURST_END) && burst->started &&
+                 (decoder.length == 2))
+        {
+            burst->ended = 1;
+            burst->endCount = Wire_Get_U16(&payload[0]);
+        }
+        else if (((decoder.type == WIRE_TYPE_SCAN) || (decoder.type == WIRE_TYPE_SYNC_SCAN) ||
+                  (decoder.type == WIRE_TYPE_RBE_SCAN)) && burst->started)
+        {
+            // The scan is only started again once the burst is done
+            burst->scans++;
+        }
+    }
+
+    return badRecords;
+}
+
+/*
+ * Any sampled sine, less its offset, obeys x[n+1] + x[n-1] = 2 cos(w) x[n].
+ * c = cos(w) is fitted over the whole block, and the residual of that
+ * recurrence is then only noise, except where a sample is missing.
+ * Lists where it spikes and returns how many.
+ */
+static unsigned long Check_Gaps(const uint16_t *block, uint16_t samples, double factor)
+{
+    double mean = 0.0;
+    double cross = 0.0;
+    double square = 0.0;
+    double sumSquares = 0.0;
+    double threshold;
+    double c;
+    unsigned long found = 0;
+    uint16_t i;
+
+    if (samples < 3)
+    {
+        return 0;
+    }
+    for (i = 0; i < samples; i++)
+    {
+        mean += block[i];
+    }
+    mean /= samples;
+    for (i = 1; i + 1 < samples; i++)
+    {
+        double x = block[i] - mean;
+
+        cross += ((block[i + 1] - mean) + (block[i - 1] - mean)) * x;
+        square += x * x;
+    }
+    c = (square > 0.0) ? cross / (2.0 * square) : 1.0;
+
+    for (i = 1; i + 1 < samples; i++)
+    {
+        double r = (block[i + 1] - mean) + (block[i - 1] - mean) -
+                   (2.0 * c * (block[i] - mean));
+
+        sumSquares += r * r;
+    }
+    threshold = factor * sqrt(sumSquares / (samples - 2));
+    if (threshold < CHECK_FLOOR_LSB)
+    {
+        threshold = CHECK_FLOOR_LSB;
+    }
+
+    for (i = 1; i + 1 < samples; i++)
+    {
+        double r = (block[i + 1] - mean) + (block[i - 1] - mean) -
+                   (2.0 * c * (block[i] - mean));
+
+        if (fabs(r) > threshold)
+        {
+            if (found < CHECK_MAX_LISTED)
+            {
+                printf("  residual %.0f LSB at sample %u\n", r, i);
+            }
+            found++;
+            // The spike comes in a +/- pair, skip its partner
+            i++;
+        }
+    }
+    printf("gap scan: fitted tone at %.4f of the sample rate, threshold %.1f LSB, "
+           "%lu suspect sample(s)\n", acos((c > 1.0) ? 1.0 : ((c < -1.0) ? -1.0 : c)) /
+           (2.0 * CHECK_PI), threshold, found);
+    return found;
+}
+
+/*
+ * A 5 kHz sine at the nominal rate, optionally with one sample taken
+ * out, streamed as the node would, with the scan coming back after.
+ */
+static int Check_Synthesize(const char *path, long drop)
+{
+    FILE *file = fopen(path, "wb");
+    uint8_t payload[2 + (2 * BURST_RECORD_SAMPLES)];
+    uint8_t record[WIRE_MAX_PAYLOAD + WIRE_OVERHEAD];
+    uint16_t block[BURST_SAMPLES];
+    uint32_t noise = 12345;
+    uint32_t elapsed;
+    long source = 0;
+    uint16_t i;
+
+    if (file == NULL)
+    {
+        perror(path);
+        return 2;
+    }
+
+    for (i = 0; i < BURST_SAMPLES; i++, source++)
+    {
+        if (source == drop)
+        {
+            source++;
+        }
+        noise = (noise * 1103515245UL) + 12345UL;
+        block[i] = (uint16_t)lround(2048.0 + (1000.0 *
+            sin((2.0 * CHECK_PI * 5000.0 * source) / BURST_NOMINAL_HZ)) +
+            (double)((noise >> 29) & 0x3) - 1.5);
+    }
+
+    elapsed = (uint32_t)(((uint64_t)BURST_SAMPLES * TIMESTAMP_HZ) / BURST_NOMINAL_HZ);
+    payload[0] = BURST_DEFAULT_CHANNEL;
+    Wire_Put_U16(&payload[1], BURST_SAMPLES);
+    Wire_Put_U16(&payload[3], 0);
+    Wire_Put_U32(&payload[5], 0);
+    Wire_Put_U32(&payload[9], elapsed);
+    Wire_Put_U32(&payload[13],
+        (uint32_t)(((uint64_t)BURST_SAMPLES * TIMESTAMP_HZ) / elapsed));
+    fwrite(record, 1, Wire_Encode(record, WIRE_TYPE_BURST_START, payload, 17), file);
+
+    for (i = 0; i < BURST_SAMPLES; i += BURST_RECORD_SAMPLES)
+    {
+        uint16_t count = BURST_SAMPLES - i;
+        uint16_t n;
+
+        if (count > BURST_RECORD_SAMPLES)
+        {
+            count = BURST_RECORD_SAMPLES;
+        }
+        Wire_Put_U16(&payload[0], i);
+        for (n = 0; n < count; n++)
+        {
+            Wire_Put_U16(&payload[2 + (2 * n)], block[i + n]);
+        }
+        fwrite(record, 1, Wire_Encode(record, WIRE_TYPE_BURST_DATA, payload,
+                                      (uint8_t)(2 + (2 * count))), file);
+    }
+
+    Wire_Put_U16(&payload[0], BURST_SAMPLES);
+    fwrite(record, 1, Wire_Encode(record, WIRE_TYPE_BURST_END, payload, 2), file);
+
+    // A few scan frames of one channel, mid-scale
+    for (i = 0; i < 4; i++)
+    {
+        Wire_Put_U32(&payload[0], i);
+        Wire_Put_U16(&payload[4], 0x0001);
+        payload[6] = 0x01;
+        Wire_Put_U16(&payload[7], 2048);
+        fwrite(record, 1, Wire_Encode(record, WIRE_TYPE_SCAN, payload, 9), file);
+    }
+    fclose(file);
+
+    printf("wrote a synthetic burst of %u samples to %s", BURST_SAMPLES, path);
+    if (drop >= 0)
+    {
+        printf(", sample %ld dropped", drop);
+    }
+    printf("\n");
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    Check_Burst burst;
+    const char *streamPath = NULL;
+    const char *binaryPath = NULL;
+    const char *textPath = NULL;
+    double factor = CHECK_DEFAULT_FACTOR;
+    uint8_t *data;
+    size_t length;
+    size_t badRecords;
+    int failures = 0;
+    int arg;
+
+    if ((argc >= 3) && (strcmp(argv[1], "-S") == 0))
+    {
+        return Check_Synthesize(argv[2], (argc > 3) ? strtol(argv[3], NULL, 0) : -1);
+    }
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-o") == 0) && (arg + 1 < argc))
+        {
+            binaryPath = argv[++arg];
+        }
+        else if ((strcmp(argv[arg], "-t") == 0) && (arg + 1 < argc))
+        {
+            textPath = argv[++arg];
+        }
+        else if ((strcmp(argv[arg], "-k") == 0) && (arg + 1 < argc))
+        {
+            factor = strtod(argv[++arg], NULL);
+        }
+        else if (streamPath == NULL)
+        {
+            streamPath = argv[arg];
+        }
+        else
+        {
+            streamPath = NULL;
+            break;
+        }
+    }
+    if (streamPath == NULL)
+    {
+        fprintf(stderr,
+            "usage: burstcheck <stream> [-o block.bin] [-t block.txt] [-k factor]\n"
+            "       burstcheck -S <stream> [drop index]\n");
+        return 2;
+    }
+
+    data = Check_Read_File(streamPath, &length);
+    if (data == NULL)
+    {
+        return 2;
+    }
+    memset(&burst, 0, sizeof(burst));
+    badRecords = Check_Parse(data, length, &burst);
+    free(data);
+
+    if (!burst.started)
+    {
+        fprintf(stderr, "burstcheck: no burst in %s (%zu bad records)\n",
+                streamPath, badRecords);
+        return 2;
+    }
+
+    printf("burst: channel A%u, %u samples, %zu bad records\n",
+           burst.channel, burst.samples, badRecords);
+    printf("rate: %lu Hz achieved over %.3f ms, nominal %lu Hz (%+.1f%%)\n",
+           (unsigned long)burst.rateHz, (burst.elapsedTicks * 1000.0) / TIMESTAMP_HZ,
+           (unsigned long)BURST_NOMINAL_HZ,
+           ((double)burst.rateHz - BURST_NOMINAL_HZ) * 100.0 / BURST_NOMINAL_HZ);
+    printf("overflows on the node: %u\n", burst.overflows);
+    printf("records: %u samples received, %u out of order, end %s (%u)\n",
+           burst.received, burst.outOfOrder, burst.ended ? "seen" : "missing",
+           burst.endCount);
+    printf("scan: %lu scan records since the burst\n", burst.scans);
+
+    if (!burst.ended || (burst.endCount != burst.samples) ||
+        (burst.received != burst.samples) || burst.outOfOrder || badRecords)
+    {
+        printf("incomplete readout\n");
+        failures++;
+    }
+    if (burst.overflows != 0)
+    {
+        failures++;
+    }
+    if (burst.rateHz == 0)
+    {
+        failures++;
+    }
+    if (burst.scans == 0)
+    {
+        printf("scan didn't resume\n");
+        failures++;
+    }
+    if (Check_Gaps(burst.block, burst.samples, factor) != 0)
+    {
+        failures++;
+    }
+
+    if (binaryPath != NULL)
+    {
+        FILE *file = fopen(binaryPath, "wb");
+        uint16_t i;
+
+        if (file == NULL)
+        {
+            perror(binaryPath);
+            return 2;
+        }
+        for (i = 0; i < burst.samples; i++)
+        {
+            uint8_t word[2];
+
+            Wire_Put_U16(word, burst.block[i]);
+            fwrite(word, 1, 2, file);
+        }
+        fclose(file);
+    }
+    if (textPath != NULL)
+    {
+        FILE *file = fopen(textPath, "w");
+        uint16_t i;
+
+        if (file == NULL)
+        {
+            perror(textPath);
+            return 2;
+        }
+        for (i = 0; i < burst.samples; i++)
+        {
+            fprintf(file, "%u\n", burst.block[i]);
+        }
+        fclose(file);
+    }
+
+    free(burst.block);
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
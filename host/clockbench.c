@@ -0,0 +1,251 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Host benchmark for the clock profiles in clock.h.
+ *
+ * For the profile it is built with, checks what the profile derives
+ * (the 1 MHz timer tick, the timestamp rate, the UART baud rate error)
+ * and, with the same timing model ADC12ISR's schedules are checked
+ * against in sched.c, reports for a few typical schedules:
+ *
+ *  - the fastest sustainable slot rate, the busiest slot's conversions
+ *    and ADC12ISR back to back,
+ *  - ADC12ISR's share of the CPU at the schedule's own slot rate and
+ *    at that fastest rate, and the headroom left for main(),
+ *  - the link's load at the schedule's slot rate.
+ *
+ * The rate, CPU share and headroom figures are model estimates, from
+ * the cycle counts in sched.h at MODOSC's minimum, not timings. On the
+ * board ADC12ISR measures itself and the SCHED_CONFIG report says how
+ * far past the model it ran; trust that over these. The link load is
+ * counted: every slot's WIRE_TYPE_SCAN record goes through the real
+ * Wire_Encode(), and a record of a size other than the model's fails.
+ *
+ * Prints PASS, or FAIL if a derived rate is off.
+ *
+ * Build from the repo root, once per profile:
+ *   gcc -O2 -I. -DCLOCK_PROFILE=0 -o clockbench host/clockbench.c sched.c wire.c
+ *
+ * Usage:
+ *   clockbench
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "adc.h"
+#include "clock.h"
+#include "sched.h"
+#include "timestamp.h"
+#include "wire.h"
+
+// Largest baud rate error the link tolerates, in 0.01%
+#define BENCH_BAUD_LIMIT    200
+
+// Bits on the wire per byte, 8N1
+#define BENCH_BYTE_BITS     10
+
+// WIRE_TYPE_SCAN bytes per record sched.h's model charges, less samples
+#define BENCH_MODEL_FRAME_BYTES 13
+
+typedef struct
+{
+    const char *name;
+    Sched_Config config;
+} Bench_Schedule;
+
+static const Bench_Schedule benchSchedules[] =
+{
+    { "default, 16 ch",
+      { 100, { 1, 8, 64, 1024 },
+        { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }, { 2, 0 } } },
+    { "16 ch every slot",
+      { 1000, { 1, 8, 64, 1024 },
+        { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }, { 2, 0 } } },
+    { "4 fast, 12 slow",
+      { 1000, { 1, 8, 64, 1024 },
+        { 0, 0, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3 }, { 2, 0 } } },
+    { "1 ch",
+      { 5000, { 1, 8, 64, 1024 },
+        { 0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+          0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }, { 0, 0 } } },
+};
+
+#define BENCH_SCHEDULES (sizeof(benchSchedules) / sizeof(benchSchedules[0]))
+
+static Sched_Table benchTable;
+
+static unsigned Bench_Bits(unsigned value)
+{
+    unsigned bits = 0;
+
+    for (; value != 0; value >>= 1)
+    {
+        bits += value & 1;
+    }
+    return bits;
+}
+
+/*
+ * Achieved baud rate, in the eUSCI_A's clocks per bit: UCBRx (times 16
+ * plus UCBRFx when oversampling) plus the average of the UCBRSx
+ * modulation pattern.
+ */
+static double Bench_Baud(void)
+{
+    double divisor = CLOCK_UART_OVERSAMPLING ?
+        ((16.0 * CLOCK_UART_PRESCALER) + CLOCK_UART_FIRST_MOD) :
+        (double)CLOCK_UART_PRESCALER;
+
+    divisor += Bench_Bits(CLOCK_UART_SECOND_MOD) / 8.0;
+
+    return CLOCK_SMCLK_HZ / divisor;
+}
+
+/*
+ * Encodes slot's WIRE_TYPE_SCAN record the way Scan_Emit_Stage() does
+ * and returns its size on the wire, or 0 if that isn't the size the
+ * model charges for it.
+ */
+static uint16_t Bench_Slot_Bytes(const Sched_Table *table, uint16_t slot)
+{
+    uint8_t payload[7 + (2 * SCAN_CHANNELS)];
+    uint8_t out[sizeof(payload) + WIRE_OVERHEAD];
+    uint16_t mask = table->mask[slot];
+    uint8_t length = 7;
+    uint16_t bytes;
+    uint16_t channel;
+
+    Wire_Put_U32(&payload[0], slot);
+    Wire_Put_U16(&payload[4], mask);
+    payload[6] = table->classMask[slot];
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        if (mask & ((uint16_t)1 << channel))
+        {
+            Wire_Put_U16(&payload[length], (uint16_t)(channel << 8));
+            length += 2;
+        }
+    }
+
+    bytes = Wire_Encode(out, WIRE_TYPE_SCAN, payload, length);
+
+    return (bytes == BENCH_MODEL_FRAME_BYTES + (2 * Bench_Bits(mask))) ? bytes : 0;
+}
+
+/*
+ * The link's load, in 0.1%, from table's records at slotHz, or -1 if
+ * a record came out a size the model doesn't charge.
+ */
+static long Bench_Link_Load(const Sched_Table *table, uint32_t slotHz)
+{
+    uint32_t bytes = 0;
+    uint16_t slot;
+
+    for (slot = 0; slot < table->slots; slot++)
+    {
+        uint16_t record = Bench_Slot_Bytes(table, slot);
+
+        if (record == 0)
+        {
+            return -1;
+        }
+        bytes += record;
+    }
+
+    return (long)(((double)bytes * BENCH_BYTE_BITS * slotHz * 1000.0) /
+                  ((double)table->slots * CLOCK_UART_BAUD));
+}
+
+/*
+ * ADC12ISR's average share of the CPU, in 0.1%, running table at
+ * slotHz.
+ */
+static uint32_t Bench_Isr_Load(const Sched_Table *table, uint32_t slotHz)
+{
+    uint32_t cycles = 0;
+    uint16_t slot;
+
+    for (slot = 0; slot < table->slots; slot++)
+    {
+        uint16_t next = (uint16_t)((slot + 1 == table->slots) ? 0 : slot + 1);
+
+        cycles += Sched_Slot_Cycles(table->mask[slot], table->mask[next]);
+    }
+
+    return (uint32_t)(((double)cycles * slotHz * 1000.0) /
+                      ((double)table->slots * SCHED_MCLK_HZ));
+}
+
+int main(void)
+{
+    double baud = Bench_Baud();
+    double baudError = ((baud - CLOCK_UART_BAUD) * 10000.0) / CLOCK_UART_BAUD;
+    int failures = 0;
+    unsigned index;
+
+    printf("profile %s: MCLK %lu Hz, %u FRAM wait state(s), ~%lu Hz effective\n",
+           CLOCK_NAME, (unsigned long)CLOCK_MCLK_HZ, (unsigned)CLOCK_FRAM_WAIT_STATES,
+           (unsigned long)CLOCK_CPU_HZ);
+
+    printf("  timer tick      %8lu Hz   %s\n", (unsigned long)ADC_TIMER_HZ,
+           (ADC_TIMER_HZ == 1000000UL) ? "ok" : "FAIL");
+    failures += ADC_TIMER_HZ != 1000000UL;
+
+    printf("  timestamp       %8lu Hz   %s\n", (unsigned long)TIMESTAMP_HZ,
+           ((CLOCK_SMCLK_HZ % CLOCK_TIMESTAMP_DIVIDER) == 0) ? "ok" : "FAIL");
+    failures += (CLOCK_SMCLK_HZ % CLOCK_TIMESTAMP_DIVIDER) != 0;
+
+    printf("  UART            %8.0f Bd   %+.2f%%  %s\n", baud, baudError / 100.0,
+           ((baudError < BENCH_BAUD_LIMIT) && (baudError > -BENCH_BAUD_LIMIT)) ?
+           "ok" : "FAIL");
+    failures += (baudError >= BENCH_BAUD_LIMIT) || (baudError <= -BENCH_BAUD_LIMIT);
+
+    printf("\n  %-18s %7s %9s %8s %8s %8s %8s %8s\n", "schedule", "slot Hz",
+           "worst us", "max Hz", "ISR %", "headroom", "ISR max", "link %");
+    printf("  %-18s %7s %s %8s\n", "", "",
+           "------------------ model --------------------", "counted");
+
+    for (index = 0; index < BENCH_SCHEDULES; index++)
+    {
+        const Bench_Schedule *schedule = &benchSchedules[index];
+        uint32_t worst;
+        uint16_t maxHz;
+        uint32_t load;
+        long link;
+
+        memset(&benchTable, 0, sizeof(benchTable));
+        if (Sched_Build(&schedule->config, &benchTable) != SCHED_OK)
+        {
+            printf("  %-18s bad schedule\n", schedule->name);
+            failures++;
+            continue;
+        }
+
+        worst = Sched_Worst_Slot_Ns(&benchTable, SCHED_MCLK_HZ);
+        maxHz = Sched_Max_Slot_Hz(&benchTable, SCHED_MCLK_HZ);
+        load = Bench_Isr_Load(&benchTable, schedule->config.slotHz);
+        link = Bench_Link_Load(&benchTable, schedule->config.slotHz);
+
+        printf("  %-18s %7u %9.1f %8u %7.1f%% %7.1f%% %7.1f%% %7.1f%%%s%s\n",
+               schedule->name, schedule->config.slotHz, worst / 1000.0, maxHz,
+               load / 10.0, (load >= 1000) ? 0.0 : (1000 - load) / 10.0,
+               Bench_Isr_Load(&benchTable, maxHz) / 10.0,
+               (link < 0) ? 0.0 : link / 10.0,
+               (schedule->config.slotHz > maxHz) ? "  too fast" : "",
+               (link >= 1000) ? "  link full" : "");
+
+        if (link < 0)
+        {
+            printf("  %-18s record size isn't the model's\n", schedule->name);
+            failures++;
+        }
+    }
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+
+    return failures ? 1 : 0;
+}
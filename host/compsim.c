@@ -0,0 +1,259 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Host simulator for the temperature and supply compensation in comp.c.
+ *
+ * Runs a board through a slow temperature cycle with AVcc drooping on
+ * top, and reads it the way the target does: the internal temperature
+ * sensor and AVcc/2 quantized against the 2.0 V reference once a
+ * second, through the same conversions and Comp_Update() as
+ * health.c, and four scan channels at 10 Hz through Comp_Stage():
+ *
+ *  0  ratiometric to AVcc, no drift, not compensated
+ *  1  absolute 1.2 V input, COMP_SUPPLY
+ *  2  sensor with 150 ppm/degC gain and 0.75 LSB/degC offset drift,
+ *     COMP_TEMPERATURE
+ *  3  absolute 2.0 V input with -80 ppm/degC and -0.5 LSB/degC drift,
+ *     both
+ *
+ * Every reading also carries half an LSB of noise. Compares each
+ * channel with and without compensation against its reading at
+ * COMP_REF_CENTI and COMP_NOMINAL_MV, checks the temperature estimate,
+ * and prints PASS or FAIL.
+ *
+ * Build from the repo root:
+ *   gcc -O2 -I. -o compsim host/compsim.c comp.c -lm
+ *
+ * Usage:
+ *   compsim [-t swing] [-v sag] [-s seconds] [-l limit]
+ *
+ *   swing is the peak to peak temperature in degC around 25 degC, sag
+ *   how far AVcc falls from 3.3 V over the run in mV, limit the largest
+ *   compensated error allowed in LSB.
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comp.h"
+
+#define SIM_CHANNELS        4
+#define SIM_SCAN_HZ         10
+#define SIM_HEALTH_HZ       1
+#define SIM_CYCLE_S         3600.0
+#define SIM_REF_V           2.0
+
+// Temperature sensor of this simulated part, near the datasheet typical
+#define SIM_SENSOR_V0       0.793
+#define SIM_SENSOR_TC       0.00255
+
+// The temperature estimate should be good to this, in degC
+#define SIM_TEMPERATURE_LIMIT   1.0
+
+typedef struct
+{
+    const char *name;
+    double volts;           /* absolute input, or 0 for ratiometric     */
+    double ratio;           /* of full scale, for ratiometric           */
+    double gainTc;          /* ppm/degC                                 */
+    double offsetTc;        /* LSB/degC                                 */
+    uint8_t flags;
+} Sim_Channel;
+
+static const Sim_Channel simChannels[SIM_CHANNELS] =
+{
+    { "ratiometric",   0.0, 0.50,    0.0,  0.0,  0 },
+    { "absolute",      1.2, 0.0,     0.0,  0.0,  COMP_SUPPLY },
+    { "drifting",      0.0, 0.61,  150.0,  0.75, COMP_TEMPERATURE },
+    { "both",          2.0, 0.0,   -80.0, -0.5,  COMP_TEMPERATURE | COMP_SUPPLY },
+};
+
+static uint32_t simSeed = 12345;
+
+// Uniform noise of +-0.5 LSB, reproducible from run to run
+static double Sim_Noise(void)
+{
+    simSeed = (simSeed * 1103515245UL) + 12345UL;
+    return (((simSeed >> 8) & 0xFFFF) / 65536.0) - 0.5;
+}
+
+static uint16_t Sim_Quantize(double lsb)
+{
+    lsb = floor(lsb + Sim_Noise() + 0.5);
+    if (lsb < 0)
+    {
+        return 0;
+    }
+    return (lsb > 4095) ? 4095 : (uint16_t)lsb;
+}
+
+static double Sim_Sensor_Lsb(double celsius)
+{
+    return ((SIM_SENSOR_V0 + (SIM_SENSOR_TC * celsius)) / SIM_REF_V) * 4096.0;
+}
+
+/*
+ * What the channel reads at temperature and AVcc, before quantizing,
+ * and at the reference conditions.
+ */
+static double Sim_Channel_Lsb(const Sim_Channel *channel, double celsius,
+                              double avcc)
+{
+    double nominal = COMP_NOMINAL_MV / 1000.0;
+    double delta = celsius - (COMP_REF_CENTI / 100.0);
+    double ideal = (channel->volts != 0) ? ((channel->volts / nominal) * 4096.0) :
+                                           (channel->ratio * 4096.0);
+
+    // Absolute inputs read high as AVcc, the reference, falls
+    if (channel->volts != 0)
+    {
+        ideal *= nominal / avcc;
+    }
+
+    return (ideal * (1.0 + (channel->gainTc * delta / 1e6))) +
+           (channel->offsetTc * delta);
+}
+
+static double Sim_Ideal_Lsb(const Sim_Channel *channel)
+{
+    return Sim_Channel_Lsb(channel, COMP_REF_CENTI / 100.0,
+                           COMP_NOMINAL_MV / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+    double swing = 40.0;
+    double sag = 150.0;
+    double seconds = 2 * SIM_CYCLE_S;
+    double limit = 3.0;
+    double rawError[SIM_CHANNELS] = {0};
+    double compError[SIM_CHANNELS] = {0};
+    double compSquares[SIM_CHANNELS] = {0};
+    double temperatureError = 0;
+    uint16_t cal30;
+    uint16_t cal85;
+    uint32_t scans;
+    uint32_t scan;
+    uint16_t channel;
+    int failures = 0;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-t") == 0) && (arg + 1 < argc))
+        {
+            swing = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-v") == 0) && (arg + 1 < argc))
+        {
+            sag = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-s") == 0) && (arg + 1 < argc))
+        {
+            seconds = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-l") == 0) && (arg + 1 < argc))
+        {
+            limit = strtod(argv[++arg], NULL);
+        }
+        else
+        {
+            fprintf(stderr, "usage: compsim [-t swing] [-v sag] [-s seconds] [-l limit]\n");
+            return 2;
+        }
+    }
+
+    // Drift models as they would be characterized, in comp.h units
+    for (channel = 0; channel < SIM_CHANNELS; channel++)
+    {
+        compConfig[channel].flags = simChannels[channel].flags;
+        compConfig[channel].gainTc = (int16_t)lround(simChannels[channel].gainTc);
+        compConfig[channel].offsetTc =
+            (int16_t)lround(simChannels[channel].offsetTc * (1 << COMP_OFFSET_SHIFT));
+    }
+
+    // The factory's calibration points, as in the part's TLV
+    cal30 = (uint16_t)lround(Sim_Sensor_Lsb(30.0));
+    cal85 = (uint16_t)lround(Sim_Sensor_Lsb(85.0));
+
+    scans = (uint32_t)(seconds * SIM_SCAN_HZ);
+    for (scan = 0; scan < scans; scan++)
+    {
+        double t = (double)scan / SIM_SCAN_HZ;
+        double celsius = 25.0 + ((swing / 2) * sin(2 * M_PI * t / SIM_CYCLE_S));
+        double avcc = (COMP_NOMINAL_MV - (sag * t / seconds)) / 1000.0;
+        Scan_Frame frame;
+
+        if ((scan % (SIM_SCAN_HZ / SIM_HEALTH_HZ)) == 0)
+        {
+            uint16_t rawTemperature = Sim_Quantize(Sim_Sensor_Lsb(celsius));
+            uint16_t rawSupply = Sim_Quantize(((avcc / 2) / SIM_REF_V) * 4096.0);
+            int16_t temperature = Comp_Temperature(rawTemperature, cal30, cal85);
+            double error = fabs((temperature / 100.0) - celsius);
+
+            if (error > temperatureError)
+            {
+                temperatureError = error;
+            }
+            Comp_Update(temperature, Comp_Supply_Mv(rawSupply));
+        }
+
+        memset(&frame, 0, sizeof(frame));
+        frame.channelMask = (1 << SIM_CHANNELS) - 1;
+        for (channel = 0; channel < SIM_CHANNELS; channel++)
+        {
+            frame.sample[channel] =
+                Sim_Quantize(Sim_Channel_Lsb(&simChannels[channel], celsius, avcc));
+        }
+
+        for (channel = 0; channel < SIM_CHANNELS; channel++)
+        {
+            double ideal = Sim_Ideal_Lsb(&simChannels[channel]);
+            double error = fabs(frame.sample[channel] - ideal);
+
+            if (error > rawError[channel])
+            {
+                rawError[channel] = error;
+            }
+        }
+
+        Comp_Stage(&frame);
+
+        for (channel = 0; channel < SIM_CHANNELS; channel++)
+        {
+            double error = frame.sample[channel] - Sim_Ideal_Lsb(&simChannels[channel]);
+
+            compSquares[channel] += error * error;
+            if (fabs(error) > compError[channel])
+            {
+                compError[channel] = fabs(error);
+            }
+        }
+    }
+
+    printf("%.0f s, %.0f degC swing, AVcc %u to %.0f mV, %u scans\n\n",
+           seconds, swing, COMP_NOMINAL_MV, COMP_NOMINAL_MV - sag,
+           (unsigned)scans);
+    printf("  %-12s %10s %10s %10s\n", "channel", "raw max", "comp max", "comp rms");
+    for (channel = 0; channel < SIM_CHANNELS; channel++)
+    {
+        int ok = compError[channel] <= limit;
+
+        printf("  %-12s %10.2f %10.2f %10.2f  %s\n", simChannels[channel].name,
+               rawError[channel], compError[channel],
+               sqrt(compSquares[channel] / scans), ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+    printf("  %-12s %10s %10.2f %10s  %s\n", "temperature", "",
+           temperatureError, "degC",
+           (temperatureError <= SIM_TEMPERATURE_LIMIT) ? "ok" : "FAIL");
+    failures += temperatureError > SIM_TEMPERATURE_LIMIT;
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,514 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Host simulator for the duty cycled acquisition in duty.c and the
+ * energy model in energy.c.
+ *
+ * Lays one duty cycle out event by event, the way the firmware runs
+ * it: the wake from LPM3, main() starting the scan, one trigger per
+ * slot period with the slot's conversions and ADC12ISR, each SCAN
+ * record queued on the link, the closing health reading, main()
+ * powering down, and the UART draining the SCAN, HEALTH and DUTY
+ * records at 115200 with the TX interrupt per byte before the board
+ * goes back to LPM3. The charge of that timeline is the reference.
+ *
+ * Against it, the same cycle as duty.c measures it: awake time,
+ * main()'s share and ADC12ISR's on the timestamp, at its resolution
+ * and without the wake-up it can't see, the ADC from the schedule's
+ * model, the TX interrupt from the bytes sent, the interval as
+ * configured whatever the VLO does, all through Energy_Cycle_Nj().
+ * The estimate has to stay within the limit of the reference for a
+ * range of burst lengths.
+ *
+ * Then the numbers to pick settings with: energy per scan, average
+ * current and battery life at a few intervals, the shortest interval
+ * that still meets the target life, and the same board scanning
+ * continuously in LPM0 for comparison.
+ *
+ * Build from the repo root:
+ *   gcc -O2 -I. -o dutysim host/dutysim.c energy.c sched.c -lm
+ *
+ * Usage:
+ *   dutysim [-r slot Hz] [-b scans] [-c channels] [-i interval s]
+ *           [-m mAh] [-d days] [-e vlo %] [-l limit %]
+ *
+ *   scans is the burst length, channels how many are converted each
+ *   slot, mAh the battery and days the life it has to last. vlo is how
+ *   far the VLO runs fast (or slow, negative) of CLOCK_ACLK_HZ, limit
+ *   the largest estimate error allowed in percent.
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+#include "duty.h"
+#include "energy.h"
+#include "health.h"
+#include "link.h"
+#include "sched.h"
+#include "timestamp.h"
+#include "wire.h"
+
+/*
+ * What the firmware spends outside ADC12ISR's slot work, in MCLK
+ * cycles at SCHED_MCLK_HZ, rough estimates like the schedule's own.
+ */
+#define SIM_WAKE_US             10.0    /* LPM3 exit, DCO up            */
+#define SIM_BEGIN_CYCLES        2500    /* Duty_Service, report, start  */
+#define SIM_IDLE_CYCLES         300     /* a wake with nothing to do    */
+#define SIM_HEALTH_ISR_CYCLES   150     /* Health_Complete              */
+#define SIM_HEALTH_CYCLES       3000    /* Health_Service, Comp_Update  */
+#define SIM_DOWN_CYCLES         400     /* Duty_Power_Down, sleep check */
+
+// 8N1, ten bits a byte
+#define SIM_BYTE_US             (10.0e6 / CLOCK_UART_BAUD)
+
+#define SIM_SCAN_RECORD(c)      (WIRE_OVERHEAD + 7 + (2 * (c)))
+#define SIM_HEALTH_RECORD       (WIRE_OVERHEAD + HEALTH_RECORD_BYTES)
+#define SIM_DUTY_RECORD         (WIRE_OVERHEAD + DUTY_RECORD_BYTES)
+
+typedef struct
+{
+    uint16_t slotHz;
+    uint16_t scans;
+    uint16_t channels;
+    double intervalS;
+    double vloPercent;
+} Sim_Config;
+
+/*
+ * The cycle as it happened (times in us) and as duty.c measured it.
+ */
+typedef struct
+{
+    double awakeUs;
+    double activeUs;
+    double adcUs;
+    double refUs;
+    double sleepUs;
+    double nj;
+    uint32_t drops;
+    uint32_t overruns;
+    Energy_Cycle measured;
+    uint32_t measuredNj;
+} Sim_Cycle;
+
+/*
+ * The UART ring: bytes leave one every SIM_BYTE_US once queued, and a
+ * record that doesn't fit is dropped, as Link_Send() does.
+ */
+typedef struct
+{
+    double emptyAt;
+    uint32_t bytes;
+    uint32_t drops;
+} Sim_Link;
+
+static Sched_Table simTable;
+
+static double Sim_Cycles_Us(uint32_t cycles)
+{
+    return (cycles * 1.0e6) / SCHED_MCLK_HZ;
+}
+
+static double Sim_Adc_Us(uint32_t clocks)
+{
+    return (clocks * 1.0e6) / SCHED_ADC_CLOCK_HZ;
+}
+
+static uint32_t Sim_Ticks(double us)
+{
+    return (uint32_t)floor((us * TIMESTAMP_HZ) / 1.0e6);
+}
+
+static void Sim_Queue(Sim_Link *link, double at, uint32_t size)
+{
+    double queued = (link->emptyAt > at) ? ((link->emptyAt - at) / SIM_BYTE_US) : 0;
+
+    if ((queued + size) > (LINK_TX_BUFFER - 1))
+    {
+        link->drops++;
+        return;
+    }
+
+    link->emptyAt = ((link->emptyAt > at) ? link->emptyAt : at) + (size * SIM_BYTE_US);
+    link->bytes += size;
+}
+
+/*
+ * A run of main() from timestamp tick to tick, as Duty_Sleep_Bits()
+ * adds it up.
+ */
+static uint32_t Sim_Main_Ticks(double from, double to)
+{
+    return Sim_Ticks(to) - Sim_Ticks(from);
+}
+
+static int Sim_Build(const Sim_Config *config)
+{
+    Sched_Config schedule = schedDefaultConfig;
+    uint16_t channel;
+
+    schedule.slotHz = config->slotHz;
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        schedule.channelClass[channel] =
+            (channel < config->channels) ? 0 : SCHED_CLASS_OFF;
+    }
+
+    memset(&simTable, 0, sizeof(simTable));
+    return Sched_Build(&schedule, &simTable) == SCHED_OK;
+}
+
+static void Sim_Run(const Sim_Config *config, Sim_Cycle *cycle)
+{
+    double periodUs = 1.0e6 / config->slotHz;
+    double intervalUs = config->intervalS * 1.0e6;
+    double actualUs = intervalUs / (1.0 + (config->vloPercent / 100.0));
+    double t = 0;
+    double awoke;
+    double start;
+    double mainAt;
+    uint32_t mainTicks = 0;
+    uint32_t isrCycles = 0;
+    uint32_t adcClocks = 0;
+    Sim_Link link = {0};
+    uint16_t scan;
+
+    memset(cycle, 0, sizeof(*cycle));
+
+    // Out of LPM3, then the timestamp starts again in Duty_Wake()
+    t += SIM_WAKE_US;
+    cycle->activeUs += SIM_WAKE_US;
+    awoke = t;
+
+    // Last cycle's DUTY record, the reference, and the scan started
+    t += Sim_Cycles_Us(SIM_BEGIN_CYCLES);
+    cycle->activeUs += Sim_Cycles_Us(SIM_BEGIN_CYCLES);
+    Sim_Queue(&link, t, SIM_DUTY_RECORD);
+    mainTicks += Sim_Main_Ticks(awoke, t);
+    start = t;
+
+    // The first trigger is a full slot period after the timer starts
+    for (scan = 0; scan < config->scans; scan++)
+    {
+        uint16_t slot = (uint16_t)(scan % simTable.slots);
+        uint16_t next = (uint16_t)((slot + 1) % simTable.slots);
+        uint16_t mask = simTable.mask[slot];
+        uint32_t clocks = Sched_Slot_Adc_Clocks(&simTable.config, mask);
+        uint32_t cycles = Sched_Slot_Cycles(mask, simTable.mask[next]);
+        double trigger = start + ((scan + 1) * periodUs);
+
+        t = trigger + Sim_Adc_Us(clocks);
+        cycle->adcUs += Sim_Adc_Us(clocks);
+        adcClocks += clocks;
+
+        t += Sim_Cycles_Us(cycles);
+        cycle->activeUs += Sim_Cycles_Us(cycles);
+        isrCycles += ((Sim_Ticks(t) - Sim_Ticks(t - Sim_Cycles_Us(cycles))) *
+                      SCHED_CYCLES_PER_TICK_Q8) >> 8;
+
+        if ((t - trigger) > periodUs)
+        {
+            cycle->overruns++;
+        }
+
+        if (mask != 0)
+        {
+            Sim_Queue(&link, t, SIM_SCAN_RECORD(Sched_Channel_Count(mask)));
+        }
+    }
+
+    // The last slot wakes main() for nothing much yet
+    mainAt = t;
+    t += Sim_Cycles_Us(SIM_IDLE_CYCLES);
+    cycle->activeUs += Sim_Cycles_Us(SIM_IDLE_CYCLES);
+    mainTicks += Sim_Main_Ticks(mainAt, t);
+
+    // Closing health reading, started from the last slot's ISR
+    t = mainAt + Sim_Adc_Us(HEALTH_ADC_CLOCKS);
+    if (t < mainAt + Sim_Cycles_Us(SIM_IDLE_CYCLES))
+    {
+        t = mainAt + Sim_Cycles_Us(SIM_IDLE_CYCLES);
+    }
+    cycle->adcUs += Sim_Adc_Us(HEALTH_ADC_CLOCKS);
+    t += Sim_Cycles_Us(SIM_HEALTH_ISR_CYCLES);
+    cycle->activeUs += Sim_Cycles_Us(SIM_HEALTH_ISR_CYCLES);
+
+    // Health_Service(), then Duty_Service() powers down
+    mainAt = t;
+    t += Sim_Cycles_Us(SIM_HEALTH_CYCLES);
+    Sim_Queue(&link, t, SIM_HEALTH_RECORD);
+    t += Sim_Cycles_Us(SIM_DOWN_CYCLES);
+    cycle->activeUs += Sim_Cycles_Us(SIM_HEALTH_CYCLES + SIM_DOWN_CYCLES);
+
+    /*
+     * LPM0 while the link drains. The TX ISR wakes main() as the last
+     * byte goes into the shift register, and Link_Tx_Idle() waits that
+     * one out.
+     */
+    if (link.emptyAt > t)
+    {
+        mainTicks += Sim_Main_Ticks(mainAt, t);
+        mainAt = ((link.emptyAt - SIM_BYTE_US) > t) ? (link.emptyAt - SIM_BYTE_US) : t;
+        cycle->activeUs += (link.emptyAt - mainAt) + Sim_Cycles_Us(SIM_IDLE_CYCLES);
+        t = link.emptyAt + Sim_Cycles_Us(SIM_IDLE_CYCLES);
+    }
+    mainTicks += Sim_Main_Ticks(mainAt, t);
+    cycle->activeUs += Sim_Cycles_Us(link.bytes * LINK_TX_ISR_CYCLES);
+    cycle->drops = link.drops;
+
+    cycle->awakeUs = t;
+    cycle->refUs = t - awoke;
+    cycle->sleepUs = (actualUs > t) ? (actualUs - t) : 0;
+
+    cycle->nj = ((Energy_Active_Ua(CLOCK_MCLK_HZ) * cycle->activeUs) +
+                 (Energy_Lpm0_Ua(CLOCK_MCLK_HZ) * (cycle->awakeUs - cycle->activeUs)) +
+                 (ENERGY_ADC_UA * cycle->adcUs) +
+                 (ENERGY_REF_UA * cycle->refUs) +
+                 ((ENERGY_LPM3_NA * cycle->sleepUs) / 1000.0)) *
+                ENERGY_NOMINAL_MV / 1.0e6;
+
+    // What duty.c makes of the same cycle
+    cycle->measured.scans = config->scans;
+    cycle->measured.awakeUs = (uint32_t)((Sim_Ticks(t) - Sim_Ticks(awoke)) *
+                                         1000000ULL / TIMESTAMP_HZ);
+    isrCycles += link.bytes * LINK_TX_ISR_CYCLES;
+    cycle->measured.cpuUs = (uint32_t)((mainTicks * 1000000ULL) / TIMESTAMP_HZ) +
+        (uint32_t)(((uint64_t)isrCycles * 1000000UL) / SCHED_MCLK_HZ);
+    cycle->measured.adcUs = (uint32_t)(((uint64_t)(adcClocks + HEALTH_ADC_CLOCKS) *
+                                        1000000UL) / SCHED_ADC_CLOCK_HZ);
+    cycle->measured.refUs = cycle->measured.awakeUs;
+    cycle->measured.sleepUs = ((uint32_t)intervalUs > cycle->measured.awakeUs) ?
+        ((uint32_t)intervalUs - cycle->measured.awakeUs) : 0;
+    cycle->measuredNj = Energy_Cycle_Nj(&cycle->measured, ENERGY_NOMINAL_MV,
+                                        CLOCK_MCLK_HZ);
+}
+
+static double Sim_Error(const Sim_Cycle *cycle)
+{
+    return ((cycle->measuredNj - cycle->nj) * 100.0) / cycle->nj;
+}
+
+/*
+ * Over the interval the VLO actually times.
+ */
+static double Sim_Average_Ua(const Sim_Config *config, double nj)
+{
+    double intervalS = config->intervalS / (1.0 + (config->vloPercent / 100.0));
+
+    return nj / (intervalS * ENERGY_NOMINAL_MV);
+}
+
+static double Sim_Life_Days(double mah, double ua)
+{
+    return (mah * 1000.0) / ua / 24.0;
+}
+
+/*
+ * The same board scanning without a break in LPM0: ADC12ISR's share
+ * of the CPU, the ADC's share of the time, the reference always up and
+ * the link busy with every SCAN record it can take.
+ */
+static double Sim_Continuous_Ua(const Sim_Config *config)
+{
+    double slotUs = 1.0e6 / config->slotHz;
+    double isrUs = 0;
+    double adcUs = 0;
+    double txUs = 0;
+    double active;
+    uint16_t slot;
+
+    for (slot = 0; slot < simTable.slots; slot++)
+    {
+        uint16_t next = (uint16_t)((slot + 1) % simTable.slots);
+        uint16_t mask = simTable.mask[slot];
+
+        isrUs += Sim_Cycles_Us(Sched_Slot_Cycles(mask, simTable.mask[next]));
+        adcUs += Sim_Adc_Us(Sched_Slot_Adc_Clocks(&simTable.config, mask));
+        if (mask != 0)
+        {
+            txUs += SIM_SCAN_RECORD(Sched_Channel_Count(mask)) * SIM_BYTE_US;
+        }
+    }
+    isrUs /= simTable.slots;
+    adcUs /= simTable.slots;
+    txUs /= simTable.slots;
+
+    // The link tops out at one byte every SIM_BYTE_US, the rest drops
+    if (txUs > slotUs)
+    {
+        txUs = slotUs;
+    }
+    active = (isrUs + Sim_Cycles_Us((uint32_t)((txUs / SIM_BYTE_US) * LINK_TX_ISR_CYCLES))) /
+             slotUs;
+
+    return (Energy_Active_Ua(CLOCK_MCLK_HZ) * active) +
+           (Energy_Lpm0_Ua(CLOCK_MCLK_HZ) * (1.0 - active)) +
+           ((ENERGY_ADC_UA * adcUs) / slotUs) + ENERGY_REF_UA;
+}
+
+int main(int argc, char **argv)
+{
+    static const double intervals[] = { 0.1, 1, 10, 60, 600, 3600 };
+    static const uint16_t bursts[] = { 1, 4, 16, 64 };
+    Sim_Config config = { 1000, 10, 16, 10.0, 0.0 };
+    double mah = 225.0;
+    double days = 1825.0;
+    double limit = 10.0;
+    double targetUa;
+    double continuousUa;
+    double fixedPc;
+    double error;
+    Sim_Cycle cycle;
+    int failures = 0;
+    unsigned index;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-r") == 0) && (arg + 1 < argc))
+        {
+            config.slotHz = (uint16_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-b") == 0) && (arg + 1 < argc))
+        {
+            config.scans = (uint16_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-c") == 0) && (arg + 1 < argc))
+        {
+            config.channels = (uint16_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-i") == 0) && (arg + 1 < argc))
+        {
+            config.intervalS = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-m") == 0) && (arg + 1 < argc))
+        {
+            mah = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-d") == 0) && (arg + 1 < argc))
+        {
+            days = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-e") == 0) && (arg + 1 < argc))
+        {
+            config.vloPercent = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-l") == 0) && (arg + 1 < argc))
+        {
+            limit = strtod(argv[++arg], NULL);
+        }
+        else
+        {
+            fprintf(stderr, "usage: dutysim [-r slot Hz] [-b scans] [-c channels] "
+                            "[-i interval s] [-m mAh] [-d days] [-e vlo %%] [-l limit %%]\n");
+            return 2;
+        }
+    }
+
+    if ((config.scans == 0) || (config.channels == 0) ||
+        (config.channels > SCAN_CHANNELS) || (config.intervalS <= 0) ||
+        !Sim_Build(&config))
+    {
+        fprintf(stderr, "dutysim: bad configuration\n");
+        return 2;
+    }
+
+    printf("profile %s, %u channel(s) at %u Hz, bursts of %u every %.3g s, %.0f mV\n",
+           CLOCK_NAME, config.channels, config.slotHz, config.scans,
+           config.intervalS, (double)ENERGY_NOMINAL_MV);
+
+    Sim_Run(&config, &cycle);
+    error = Sim_Error(&cycle);
+
+    printf("\n  %-10s %10s %10s %10s %10s %12s\n", "", "awake us", "CPU us",
+           "ADC us", "sleep ms", "cycle uJ");
+    printf("  %-10s %10.0f %10.0f %10.0f %10.1f %12.3f\n", "timeline",
+           cycle.awakeUs, cycle.activeUs, cycle.adcUs, cycle.sleepUs / 1000.0,
+           cycle.nj / 1000.0);
+    printf("  %-10s %10lu %10lu %10lu %10.1f %12.3f   %+.1f%%\n", "measured",
+           (unsigned long)cycle.measured.awakeUs, (unsigned long)cycle.measured.cpuUs,
+           (unsigned long)cycle.measured.adcUs, cycle.measured.sleepUs / 1000.0,
+           cycle.measuredNj / 1000.0, error);
+    if (cycle.drops || cycle.overruns)
+    {
+        printf("  %lu record(s) dropped on the link, %lu slot overrun(s)\n",
+               (unsigned long)cycle.drops, (unsigned long)cycle.overruns);
+    }
+    failures += fabs(error) > limit;
+
+    printf("  %.3f uJ per scan, %.2f uA average, %.0f days on %.0f mAh\n",
+           cycle.nj / 1000.0 / config.scans,
+           Sim_Average_Ua(&config, cycle.nj),
+           Sim_Life_Days(mah, Sim_Average_Ua(&config, cycle.nj)), mah);
+
+    // The estimate across burst lengths, at this interval
+    printf("\n  %-8s %12s %12s %8s\n", "burst", "timeline uJ", "measured uJ", "error");
+    for (index = 0; index < sizeof(bursts) / sizeof(bursts[0]); index++)
+    {
+        Sim_Config burst = config;
+        Sim_Cycle run;
+
+        burst.scans = bursts[index];
+        Sim_Run(&burst, &run);
+        error = Sim_Error(&run);
+        printf("  %-8u %12.3f %12.3f %+7.1f%%%s\n", burst.scans, run.nj / 1000.0,
+               run.measuredNj / 1000.0, error, (fabs(error) > limit) ? "  FAIL" : "");
+        failures += fabs(error) > limit;
+    }
+
+    // Battery life against interval, and the interval the target needs
+    targetUa = (mah * 1000.0) / (days * 24.0);
+    printf("\n  %-10s %10s %10s %10s   target %.0f days, %.2f uA\n", "interval s",
+           "uJ/scan", "avg uA", "days", days, targetUa);
+    for (index = 0; index < sizeof(intervals) / sizeof(intervals[0]); index++)
+    {
+        Sim_Config sweep = config;
+        Sim_Cycle run;
+        double ua;
+
+        sweep.intervalS = intervals[index];
+        Sim_Run(&sweep, &run);
+        if (run.awakeUs >= sweep.intervalS * 1.0e6)
+        {
+            printf("  %-10.3g %10s\n", sweep.intervalS, "too short");
+            continue;
+        }
+        ua = Sim_Average_Ua(&sweep, run.nj);
+        printf("  %-10.3g %10.3f %10.2f %10.0f   %s\n", sweep.intervalS,
+               run.nj / 1000.0 / sweep.scans, ua, Sim_Life_Days(mah, ua),
+               (ua <= targetUa) ? "meets" : "");
+    }
+
+    /*
+     * Charge per cycle is what the cycle costs awake over LPM3, plus
+     * LPM3 for the whole interval, so the target fixes the interval
+     * directly.
+     */
+    fixedPc = (cycle.nj * 1.0e6 / ENERGY_NOMINAL_MV) -
+              ((ENERGY_LPM3_NA / 1000.0) * (cycle.sleepUs + cycle.awakeUs));
+    if (targetUa > (ENERGY_LPM3_NA / 1000.0))
+    {
+        printf("  shortest interval for %.0f days: %.3g s\n", days,
+               (fixedPc / (targetUa - (ENERGY_LPM3_NA / 1000.0)) / 1.0e6) *
+               (1.0 + (config.vloPercent / 100.0)));
+    }
+    else
+    {
+        printf("  %.0f days is out of reach, LPM3 alone draws more\n", days);
+    }
+
+    continuousUa = Sim_Continuous_Ua(&config);
+    printf("  continuous at %u Hz: %.1f uA, %.0f days\n", config.slotHz,
+           continuousUa, Sim_Life_Days(mah, continuousUa));
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,403 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Host benchmark for the per-channel filter chain.
+ *
+ * Runs filter.c, built with whatever filter_config.h settings are given
+ * on the command line, over a synthetic channel: a slow sine plus
+ * noise and the odd spike. Reports
+ *
+ *  - cost: host cycles and ns per sample and per 16-channel frame,
+ *  - accuracy: fixed-point output against a double precision model of
+ *    the same chain fed the same samples, in LSB,
+ *  - rejection: how far the output is from that model fed the clean
+ *    sine, against how far the raw input is from the clean sine.
+ *
+ * Host cycles only rank configurations against each other, they are
+ * not MSP430 cycles.
+ *
+ * Build from the repo root, once per configuration:
+ *   gcc -O2 -I. -DFILTER_MEDIAN=3 -DFILTER_BIQUAD=1 \
+ *       -o filterbench host/filterbench.c filter.c -lm
+ *   gcc -O2 -I. -DFILTER_MEDIAN=5 -DFILTER_BIQUAD=0 -DFILTER_AVERAGE_SHIFT=3 \
+ *       -DFILTER_DECIMATE=8 -o filterbench host/filterbench.c filter.c -lm
+ *
+ * Usage:
+ *   filterbench [-n samples] [-p passes]
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filter.h"
+
+// Every stage is off by default, pick the ones to measure
+#if !FILTER_ANY
+#error "filterbench needs a stage on, e.g. -DFILTER_MEDIAN=3 -DFILTER_BIQUAD=1"
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+#define BENCH_PI                3.14159265358979323846
+
+#define BENCH_DEFAULT_SAMPLES   65536
+#define BENCH_DEFAULT_PASSES    200
+
+/*
+ * Test channel, in LSB: mid-scale offset, a sine at 1/200 of the
+ * channel rate (well inside the default biquad's pass band), uniform
+ * noise and a spike every BENCH_SPIKE_EVERY samples.
+ */
+#define BENCH_OFFSET            2048.0
+#define BENCH_AMPLITUDE         1000.0
+#define BENCH_PERIOD            200.0
+#define BENCH_NOISE             24
+#define BENCH_SPIKE             1500
+#define BENCH_SPIKE_EVERY       97
+
+// Model state settles well before this, comparisons start after it
+#define BENCH_SETTLE            256
+
+typedef struct
+{
+    double history[4];
+    double x1;
+    double x2;
+    double y1;
+    double y2;
+    double ring[16];
+    double sum;
+    unsigned index;
+    unsigned count;
+    int primed;
+} Bench_Model;
+
+static uint32_t benchSeed = 1;
+
+static uint32_t Bench_Random(void)
+{
+    benchSeed = (benchSeed * 1103515245UL) + 12345UL;
+    return (benchSeed >> 8) & 0xFFFF;
+}
+
+static double Bench_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+static unsigned long long Bench_Cycles(void)
+{
+#ifdef BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+#if FILTER_MEDIAN
+static int Bench_Compare(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+#endif
+
+/*
+ * Same chain as Filter_Sample(), in double precision with the same Q14
+ * coefficients, so the difference is down to the fixed-point arithmetic.
+ */
+static double Bench_Model_Sample(Bench_Model *model, double sample, int *due)
+{
+    const double scale = (double)(1L << FILTER_BIQUAD_SHIFT);
+    unsigned i;
+
+    if (!model->primed)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            model->history[i] = sample;
+        }
+        model->x1 = model->x2 = model->y1 = model->y2 = sample;
+        for (i = 0; i < 16; i++)
+        {
+            model->ring[i] = sample;
+        }
+        model->sum = sample * (1 << FILTER_AVERAGE_SHIFT);
+        model->index = 0;
+        model->count = 0;
+        model->primed = 1;
+    }
+
+#if FILTER_MEDIAN
+    {
+        double window[5];
+
+        for (i = 0; i < FILTER_MEDIAN - 1; i++)
+        {
+            window[i] = model->history[i];
+        }
+        window[FILTER_MEDIAN - 1] = sample;
+        for (i = 0; i < FILTER_MEDIAN - 2; i++)
+        {
+            model->history[i] = model->history[i + 1];
+        }
+        model->history[FILTER_MEDIAN - 2] = sample;
+        qsort(window, FILTER_MEDIAN, sizeof(double), Bench_Compare);
+        sample = window[FILTER_MEDIAN / 2];
+    }
+#endif
+#if FILTER_BIQUAD
+    {
+        double y = ((FILTER_BIQUAD_B0 * sample) +
+                    (FILTER_BIQUAD_B1 * model->x1) +
+                    (FILTER_BIQUAD_B2 * model->x2) -
+                    (FILTER_BIQUAD_A1 * model->y1) -
+                    (FILTER_BIQUAD_A2 * model->y2)) / scale;
+
+        model->x2 = model->x1;
+        model->x1 = sample;
+        model->y2 = model->y1;
+        model->y1 = y;
+        sample = (y < 0.0) ? 0.0 : ((y > FILTER_FULL_SCALE) ? FILTER_FULL_SCALE : y);
+    }
+#endif
+#if FILTER_AVERAGE_SHIFT
+    model->sum += sample - model->ring[model->index];
+    model->ring[model->index] = sample;
+    model->index = (model->index + 1) & ((1 << FILTER_AVERAGE_SHIFT) - 1);
+    sample = model->sum / (1 << FILTER_AVERAGE_SHIFT);
+#endif
+
+    (void)scale;
+    *due = 1;
+#if FILTER_DECIMATE > 1
+    model->count++;
+    if (model->count < FILTER_DECIMATE)
+    {
+        *due = 0;
+    }
+    else
+    {
+        model->count = 0;
+    }
+#endif
+    return sample;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long samples = BENCH_DEFAULT_SAMPLES;
+    unsigned long passes = BENCH_DEFAULT_PASSES;
+    uint16_t *noisy;
+    double *clean;
+    Bench_Model exactModel;
+    Bench_Model cleanModel;
+    Filter_Channel *state = &filterState[0];
+    Scan_Frame frame;
+    unsigned long i;
+    unsigned long pass;
+    unsigned long outputs = 0;
+    unsigned long compared = 0;
+    unsigned long checksum = 0;
+    double maxError = 0.0;
+    double sumError = 0.0;
+    double sumSquareError = 0.0;
+    double sumSquareResidual = 0.0;
+    double sumSquareRaw = 0.0;
+    double start;
+    double sampleSeconds;
+    double frameSeconds;
+    unsigned long long startCycles;
+    unsigned long long sampleCycles;
+    unsigned long long frameCycles;
+    double frames;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-n") == 0) && (arg + 1 < argc))
+        {
+            samples = strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-p") == 0) && (arg + 1 < argc))
+        {
+            passes = strtoul(argv[++arg], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: filterbench [-n samples] [-p passes]\n");
+            return 2;
+        }
+    }
+    if ((samples <= BENCH_SETTLE) || (passes == 0))
+    {
+        fprintf(stderr, "filterbench: need more than %d samples and a pass\n",
+                BENCH_SETTLE);
+        return 2;
+    }
+
+    noisy = malloc(samples * sizeof(uint16_t));
+    clean = malloc(samples * sizeof(double));
+    if ((noisy == NULL) || (clean == NULL))
+    {
+        fprintf(stderr, "filterbench: out of memory\n");
+        return 2;
+    }
+
+    for (i = 0; i < samples; i++)
+    {
+        long value;
+
+        clean[i] = BENCH_OFFSET +
+                   (BENCH_AMPLITUDE * sin((2.0 * BENCH_PI * i) / BENCH_PERIOD));
+        value = lround(clean[i]) + (long)(Bench_Random() % (2 * BENCH_NOISE + 1)) -
+                BENCH_NOISE;
+        if ((i % BENCH_SPIKE_EVERY) == (BENCH_SPIKE_EVERY - 1))
+        {
+            value += (Bench_Random() & 1) ? BENCH_SPIKE : -BENCH_SPIKE;
+        }
+        if (value < 0)
+        {
+            value = 0;
+        }
+        if (value > FILTER_FULL_SCALE)
+        {
+            value = FILTER_FULL_SCALE;
+        }
+        noisy[i] = (uint16_t)value;
+        if (i >= BENCH_SETTLE)
+        {
+            sumSquareRaw += (value - clean[i]) * (value - clean[i]);
+        }
+    }
+
+    /*
+     * Accuracy, one pass.
+     */
+    memset(&exactModel, 0, sizeof(exactModel));
+    memset(&cleanModel, 0, sizeof(cleanModel));
+    Filter_Reset();
+    for (i = 0; i < samples; i++)
+    {
+        unsigned char due;
+        int modelDue;
+        int cleanDue;
+        uint16_t output = Filter_Sample(state, noisy[i], &due);
+        double exact = Bench_Model_Sample(&exactModel, noisy[i], &modelDue);
+        double ideal = Bench_Model_Sample(&cleanModel, clean[i], &cleanDue);
+
+        if (due != modelDue)
+        {
+            fprintf(stderr, "filterbench: decimation out of step at sample %lu\n", i);
+            return 1;
+        }
+        if (!due)
+        {
+            continue;
+        }
+        outputs++;
+        if (i >= BENCH_SETTLE)
+        {
+            double error = output - exact;
+
+            compared++;
+            sumError += error;
+            sumSquareError += error * error;
+            sumSquareResidual += (output - ideal) * (output - ideal);
+            if (fabs(error) > maxError)
+            {
+                maxError = fabs(error);
+            }
+        }
+    }
+
+    /*
+     * Cost per sample, one channel back to back.
+     */
+    start = Bench_Now();
+    startCycles = Bench_Cycles();
+    for (pass = 0; pass < passes; pass++)
+    {
+        unsigned char due;
+
+        Filter_Reset();
+        for (i = 0; i < samples; i++)
+        {
+            checksum += Filter_Sample(state, noisy[i], &due);
+        }
+    }
+    sampleCycles = Bench_Cycles() - startCycles;
+    sampleSeconds = Bench_Now() - start;
+
+    /*
+     * Cost per frame, all sixteen channels through Filter_Stage().
+     */
+    start = Bench_Now();
+    startCycles = Bench_Cycles();
+    for (pass = 0; pass < passes; pass++)
+    {
+        uint16_t channel;
+
+        Filter_Reset();
+        for (i = 0; i < samples; i += SCAN_CHANNELS)
+        {
+            frame.flags = 0;
+            frame.channelMask = 0xFFFF;
+            for (channel = 0; channel < SCAN_CHANNELS; channel++)
+            {
+                frame.sample[channel] = noisy[(i + channel) % samples];
+            }
+            Filter_Stage(&frame);
+            checksum += frame.sample[0] + frame.channelMask;
+        }
+    }
+    frameCycles = Bench_Cycles() - startCycles;
+    frameSeconds = Bench_Now() - start;
+
+    printf("config: median %d, biquad %s, average %d, decimate %d, channels 0x%04X\n",
+           FILTER_MEDIAN, FILTER_BIQUAD ? "on" : "off", 1 << FILTER_AVERAGE_SHIFT,
+           FILTER_DECIMATE, FILTER_CHANNEL_MASK);
+    printf("state: %u bytes per channel, %u bytes SRAM for %d channels\n\n",
+           (unsigned)sizeof(Filter_Channel), (unsigned)FILTER_SRAM_BYTES, SCAN_CHANNELS);
+
+    printf("cost\n");
+    printf("  per sample: %8.2f ns %8.1f cycles\n",
+           (sampleSeconds * 1e9) / (passes * (double)samples),
+           (double)sampleCycles / (passes * (double)samples));
+    frames = passes * (double)((samples + SCAN_CHANNELS - 1) / SCAN_CHANNELS);
+    printf("  per frame:  %8.2f ns %8.1f cycles\n\n",
+           (frameSeconds * 1e9) / frames, (double)frameCycles / frames);
+
+    printf("accuracy against the double model, %lu of %lu outputs (LSB)\n",
+           compared, outputs);
+    printf("  max %.3f  rms %.3f  mean %+.3f\n\n", maxError,
+           sqrt(sumSquareError / compared), sumError / compared);
+
+    printf("rejection, rms distance from the clean signal (LSB)\n");
+    printf("  raw input %.2f  filtered %.2f\n",
+           sqrt(sumSquareRaw / (samples - BENCH_SETTLE)),
+           sqrt(sumSquareResidual / compared));
+
+    // Keeps the timed loops from being optimised away
+    if (checksum == 1)
+    {
+        printf("\n");
+    }
+
+    free(noisy);
+    free(clean);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Host simulator for the fixed-point PID in pid.c.
+ *
+ * Closes the loop around a first-order plant sampled by a 12-bit ADC,
+ * one PID update per scan of the loop's channel with the output taking
+ * effect from the next scan, as on the target. Checks
+ *
+ *  - the step response settles on the setpoint,
+ *  - anti-windup: after a long spell with the setpoint out of reach,
+ *    the output comes off its limit within a few updates of the
+ *    setpoint coming back into reach,
+ *  - bumpless transfer: switching manual to automatic, and retuning a
+ *    running loop, moves the output by no more than one count,
+ *
+ * and prints PASS or FAIL. Latency and jitter are measured on the
+ * target, see control.c.
+ *
+ * Build from the repo root:
+ *   gcc -O2 -I. -o pidsim host/pidsim.c pid.c
+ *
+ * Usage:
+ *   pidsim [-p kp] [-i ki] [-d kd] [-t tau]
+ *
+ *   Gains are Q8 as in pid.h, tau is the plant time constant in scans.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pid.h"
+
+#define SIM_OUT_MAX         1000
+#define SIM_FULL_SCALE      4095
+
+// Plant gain, LSB per output count at steady state
+#define SIM_PLANT_GAIN      3.0
+
+#define SIM_SETTLE_LSB      2
+#define SIM_SETTLE_SCANS    400
+#define SIM_WINDUP_SCANS    2000
+#define SIM_RELEASE_SCANS   10
+
+typedef struct
+{
+    double value;
+    double tau;
+    uint16_t drive;
+} Sim_Plant;
+
+/*
+ * One scan: sample the plant with the drive set on the last scan,
+ * then let it respond for a scan period.
+ */
+static uint16_t Sim_Plant_Sample(Sim_Plant *plant)
+{
+    double sample = plant->value + 0.5;
+
+    plant->value += ((SIM_PLANT_GAIN * plant->drive) - plant->value) / plant->tau;
+    if (sample > SIM_FULL_SCALE)
+    {
+        sample = SIM_FULL_SCALE;
+    }
+    return (uint16_t)sample;
+}
+
+static int Sim_Report(const char *name, int ok)
+{
+    printf("  %-28s %s\n", name, ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    Pid_Config config = { 2048, 256, 16, 0, 0, SIM_OUT_MAX };
+    Pid_State state;
+    Sim_Plant plant;
+    uint16_t input;
+    uint16_t output;
+    uint16_t before;
+    uint16_t limit;
+    uint16_t peak = 0;
+    long settled = -1;
+    long released = -1;
+    long scan;
+    int failures = 0;
+    int arg;
+
+    memset(&plant, 0, sizeof(plant));
+    plant.tau = 20.0;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-p") == 0) && (arg + 1 < argc))
+        {
+            config.kp = (int16_t)strtol(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-i") == 0) && (arg + 1 < argc))
+        {
+            config.ki = (int16_t)strtol(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-d") == 0) && (arg + 1 < argc))
+        {
+            config.kd = (int16_t)strtol(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-t") == 0) && (arg + 1 < argc))
+        {
+            plant.tau = strtod(argv[++arg], NULL);
+        }
+        else
+        {
+            fprintf(stderr, "usage: pidsim [-p kp] [-i ki] [-d kd] [-t tau]\n");
+            return 2;
+        }
+    }
+    if (plant.tau < 1.0)
+    {
+        fprintf(stderr, "pidsim: tau must be at least one scan\n");
+        return 2;
+    }
+
+    printf("kp %d ki %d kd %d (Q%d), plant gain %.1f tau %.1f scans\n\n",
+           config.kp, config.ki, config.kd, PID_SHIFT, SIM_PLANT_GAIN, plant.tau);
+
+    /*
+     * Manual at a fixed output, then bumpless to automatic.
+     */
+    memset(&state, 0, sizeof(state));
+    Pid_Set_Manual(&state, 200);
+    plant.drive = 200;
+    for (scan = 0; scan < 200; scan++)
+    {
+        input = Sim_Plant_Sample(&plant);
+        plant.drive = Pid_Update(&config, &state, input);
+    }
+    before = state.output;
+    input = Sim_Plant_Sample(&plant);
+    Pid_Set_Auto(&config, &state, input);
+    output = Pid_Update(&config, &state, input);
+    printf("manual to auto: %u -> %u\n", before, output);
+    failures += Sim_Report("bumpless manual to auto",
+        abs((int)output - (int)before) <= 1);
+    plant.drive = output;
+
+    /*
+     * Step response from there.
+     */
+    for (scan = 0; scan < SIM_SETTLE_SCANS; scan++)
+    {
+        input = Sim_Plant_Sample(&plant);
+        plant.drive = Pid_Update(&config, &state, input);
+        if (input > peak)
+        {
+            peak = input;
+        }
+        if (abs((int)input - (int)config.setpoint) > SIM_SETTLE_LSB)
+        {
+            settled = -1;
+        }
+        else if (settled < 0)
+        {
+            settled = scan;
+        }
+    }
+    printf("step: settled after %ld scans, overshoot %d LSB\n", settled,
+           (int)peak - (int)config.setpoint);
+    failures += Sim_Report("step settles on setpoint", settled >= 0);
+
+    /*
+     * Retune while running.
+     */
+    before = state.output;
+    input = Sim_Plant_Sample(&plant);
+    config.kp = (int16_t)(config.kp * 2);
+    Pid_Set_Auto(&config, &state, input);
+    output = Pid_Update(&config, &state, input);
+    printf("retune kp x2: %u -> %u\n", before, output);
+    failures += Sim_Report("bumpless retune",
+        abs((int)output - (int)before) <= 1);
+    config.kp = (int16_t)(config.kp / 2);
+    plant.drive = output;
+
+    /*
+     * Setpoint out of reach for a long time, then back.
+     */
+    limit = config.setpoint;
+    config.setpoint = SIM_FULL_SCALE;
+    for (scan = 0; scan < SIM_WINDUP_SCANS; scan++)
+    {
+        input = Sim_Plant_Sample(&plant);
+        plant.drive = Pid_Update(&config, &state, input);
+    }
+    printf("out of reach: output %u, saturated %u\n", state.output, state.saturated);
+    failures += Sim_Report("pinned at the limit",
+        (state.output == config.outMax) && state.saturated);
+
+    config.setpoint = limit;
+    for (scan = 0; scan < SIM_SETTLE_SCANS; scan++)
+    {
+        input = Sim_Plant_Sample(&plant);
+        plant.drive = Pid_Update(&config, &state, input);
+        if ((released < 0) && (plant.drive < config.outMax))
+        {
+            released = scan;
+        }
+    }
+    printf("back in reach: off the limit after %ld updates, input %u\n",
+           released, input);
+    failures += Sim_Report("anti-windup release",
+        (released >= 0) && (released < SIM_RELEASE_SCANS));
+    failures += Sim_Report("recovers to setpoint",
+        abs((int)input - (int)config.setpoint) <= SIM_SETTLE_LSB);
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,781 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Host replay driver for captured scan frames.
+ *
+ * Reads a capture (the raw byte stream saved off the data link while
+ * the node streams a capture, see capture.c), and pushes every
+ * WIRE_TYPE_RAW_SCAN frame through the same Scan_Process_Frame()
+ * pipeline that ADC12ISR feeds on the target.
+ *
+ * The first pass over the capture produces the output stream: every
+ * processed frame plus every record the stages queued on the link,
+ * all wire framed. That stream is either written out as a golden file
+ * or compared bit-exactly against one. Further passes time each stage
+ * over the whole capture in one go, fed the same frames it saw in the
+ * pipeline, and report time per stage.
+ *
+ * -d and -h switch report by exception on for every channel, with
+ * that deadband and heartbeat. The golden pass then also rebuilds the
+ * full state from the WIRE_TYPE_RBE_SCAN records the way a host would,
+ * checks every converted sample against it, and reports the link
+ * bytes saved over sending every frame whole. -R rebuilds the state
+ * from link output captured off a board and prints it as CSV.
+ *
+ * Build from the repo root:
+ *   gcc -O2 -I. -o replay host/replay.c scan.c wire.c filter.c comp.c rbe.c
+ *
+ * Usage:
+ *   replay <capture> [-n passes] [-w golden] [-g golden]
+ *          [-d deadband] [-h heartbeat]
+ *   replay -S <capture> [frames]     write a synthetic capture
+ *   replay -R <link capture>         rebuild report by exception output
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "scan.h"
+#include "wire.h"
+#include "link.h"
+#include "persist.h"
+#include "capture.h"
+#include "rbe.h"
+#include "filter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define REPLAY_HAVE_TSC 1
+#endif
+
+// Host-only record type for a processed frame in the output stream
+#define REPLAY_TYPE_OUTPUT  0x7F
+
+#define REPLAY_DEFAULT_PASSES   200
+
+typedef struct
+{
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} Replay_Buffer;
+
+typedef struct
+{
+    double seconds;
+    unsigned long long cycles;
+    unsigned long frames;
+} Replay_Stage_Time;
+
+/*
+ * What a host knows from the WIRE_TYPE_RBE_SCAN records so far.
+ */
+typedef struct
+{
+    uint16_t value[SCAN_CHANNELS];
+    uint16_t known;
+    uint32_t sequence;
+    unsigned long records;
+    unsigned long badRecords;
+    unsigned long bytes;
+} Replay_Rebuild;
+
+/*
+ * Target-side state the pipeline expects to find.
+ */
+Acq_Cursor acqCursor;
+
+static Replay_Buffer output;
+static Replay_Rebuild rebuild;
+static int recording = 0;
+
+static void Replay_Append(Replay_Buffer *buffer, const uint8_t *data, size_t length)
+{
+    if (buffer->length + length > buffer->capacity)
+    {
+        buffer->capacity = (buffer->capacity + length) * 2;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+        if (buffer->data == NULL)
+        {
+            fprintf(stderr, "replay: out of memory\n");
+            exit(2);
+        }
+    }
+    memcpy(&buffer->data[buffer->length], data, length);
+    buffer->length += length;
+}
+
+static void Replay_Append_Record(Replay_Buffer *buffer, uint8_t type,
+                                 const uint8_t *payload, uint8_t length)
+{
+    uint8_t record[WIRE_MAX_PAYLOAD + WIRE_OVERHEAD];
+    uint16_t size = Wire_Encode(record, type, payload, length);
+
+    Replay_Append(buffer, record, size);
+}
+
+static uint16_t Replay_Bits(uint16_t mask)
+{
+    uint16_t bits = 0;
+
+    for (; mask != 0; mask &= (uint16_t)(mask - 1))
+    {
+        bits++;
+    }
+    return bits;
+}
+
+/*
+ * Applies one WIRE_TYPE_RBE_SCAN payload to the host's copy of every
+ * channel. Returns 0 if the length doesn't match the mask.
+ */
+static int Replay_Rebuild_Record(Replay_Rebuild *state, const uint8_t *payload,
+                                 uint8_t length)
+{
+    uint16_t mask;
+    uint16_t channel;
+    uint8_t offset = RBE_HEADER_BYTES;
+
+    if ((length < RBE_HEADER_BYTES) ||
+        (length != RBE_HEADER_BYTES + (2 * Replay_Bits(Wire_Get_U16(&payload[4])))))
+    {
+        state->badRecords++;
+        return 0;
+    }
+
+    state->sequence = Wire_Get_U32(&payload[0]);
+    mask = Wire_Get_U16(&payload[4]);
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        if (mask & ((uint16_t)1 << channel))
+        {
+            state->value[channel] = Wire_Get_U16(&payload[offset]);
+            offset += 2;
+        }
+    }
+    state->known |= mask;
+    state->records++;
+    state->bytes += length + WIRE_OVERHEAD;
+    return 1;
+}
+
+/*
+ * Host stand-in for the UART link: everything a stage sends during the
+ * golden pass becomes part of the output stream, and report by
+ * exception records reach the host's rebuild. The link never fills.
+ */
+unsigned char Link_Send(uint8_t type, const uint8_t *payload, uint8_t length)
+{
+    if (recording)
+    {
+        Replay_Append_Record(&output, type, payload, length);
+        if (type == WIRE_TYPE_RBE_SCAN)
+        {
+            Replay_Rebuild_Record(&rebuild, payload, length);
+        }
+    }
+    return 1;
+}
+
+void Link_Wake_On_Drain(void)
+{
+}
+
+static double Replay_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+static unsigned long long Replay_Cycles(void)
+{
+#ifdef REPLAY_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int Replay_Read_File(const char *path, Replay_Buffer *buffer)
+{
+    uint8_t chunk[4096];
+    size_t got;
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        perror(path);
+        return 0;
+    }
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        Replay_Append(buffer, chunk, got);
+    }
+    fclose(file);
+    return 1;
+}
+
+static int Replay_Write_File(const char *path, const Replay_Buffer *buffer)
+{
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL)
+    {
+        perror(path);
+        return 0;
+    }
+    fwrite(buffer->data, 1, buffer->length, file);
+    fclose(file);
+    return 1;
+}
+
+/*
+ * Pulls every raw scan frame out of a captured byte stream.
+ */
+static Scan_Frame *Replay_Parse_Capture(const Replay_Buffer *capture,
+                                        size_t *frameCount, size_t *badRecords)
+{
+    Wire_Decoder decoder;
+    Scan_Frame *frames = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    size_t i;
+    uint16_t channel;
+
+    *badRecords = 0;
+    Wire_Decoder_Reset(&decoder);
+
+    for (i = 0; i < capture->length; i++)
+    {
+        int result = Wire_Decode_Byte(&decoder, capture->data[i]);
+
+        if (result < 0)
+        {
+            (*badRecords)++;
+        }
+        if ((result <= 0) || (decoder.type != WIRE_TYPE_RAW_SCAN))
+        {
+            continue;
+        }
+        if (decoder.length != CAPTURE_RECORD_SIZE)
+        {
+            (*badRecords)++;
+            continue;
+        }
+
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 256;
+            frames = realloc(frames, capacity * sizeof(Scan_Frame));
+            if (frames == NULL)
+            {
+                fprintf(stderr, "replay: out of memory\n");
+                exit(2);
+            }
+        }
+
+        frames[count].sequence = Wire_Get_U32(&decoder.payload[0]);
+        frames[count].flags = 0;
+        frames[count].channelMask = Wire_Get_U16(&decoder.payload[4]);
+        frames[count].changedMask = 0;
+        frames[count].classMask = decoder.payload[6];
+        frames[count].sync.flags = 0;
+        for (channel = 0; channel < SCAN_CHANNELS; channel++)
+        {
+            frames[count].sample[channel] =
+                Wire_Get_U16(&decoder.payload[7 + (2 * channel)]);
+        }
+        count++;
+    }
+
+    *frameCount = count;
+    return frames;
+}
+
+static void Replay_Record_Frame(const Scan_Frame *frame)
+{
+    uint8_t payload[9 + (2 * SCAN_CHANNELS)];
+    uint16_t channel;
+
+    Wire_Put_U32(&payload[0], frame->sequence);
+    Wire_Put_U16(&payload[4], frame->flags);
+    Wire_Put_U16(&payload[6], frame->channelMask);
+    payload[8] = frame->classMask;
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        Wire_Put_U16(&payload[9 + (2 * channel)], frame->sample[channel]);
+    }
+    Replay_Append_Record(&output, REPLAY_TYPE_OUTPUT, payload, sizeof(payload));
+}
+
+/*
+ * Splits a wire stream into records. Returns the number found; offsets
+ * and lengths of each record are stored in the caller's arrays.
+ */
+static size_t Replay_Split(const Replay_Buffer *stream, size_t **offsets)
+{
+    Wire_Decoder decoder;
+    size_t count = 0;
+    size_t capacity = 0;
+    size_t start = 0;
+    size_t i;
+
+    *offsets = NULL;
+    Wire_Decoder_Reset(&decoder);
+
+    for (i = 0; i < stream->length; i++)
+    {
+        if (decoder.state == 0)
+        {
+            start = i;
+        }
+        if (Wire_Decode_Byte(&decoder, stream->data[i]) == 1)
+        {
+            if (count == capacity)
+            {
+                capacity = capacity ? capacity * 2 : 256;
+                *offsets = realloc(*offsets, capacity * 2 * sizeof(size_t));
+            }
+            (*offsets)[2 * count] = start;
+            (*offsets)[(2 * count) + 1] = i + 1 - start;
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+ * Bit-exact comparison of the output stream against a golden one.
+ * Returns the number of records that differ, counting missing and
+ * extra records.
+ */
+static size_t Replay_Diff(const Replay_Buffer *golden, const Replay_Buffer *actual)
+{
+    size_t *goldenRecords;
+    size_t *actualRecords;
+    size_t goldenCount = Replay_Split(golden, &goldenRecords);
+    size_t actualCount = Replay_Split(actual, &actualRecords);
+    size_t common = (goldenCount < actualCount) ? goldenCount : actualCount;
+    size_t differ = 0;
+    size_t reported = 0;
+    size_t i;
+
+    for (i = 0; i < common; i++)
+    {
+        const uint8_t *g = &golden->data[goldenRecords[2 * i]];
+        const uint8_t *a = &actual->data[actualRecords[2 * i]];
+        size_t gLength = goldenRecords[(2 * i) + 1];
+        size_t aLength = actualRecords[(2 * i) + 1];
+        size_t byte;
+
+        if ((gLength == aLength) && (memcmp(g, a, gLength) == 0))
+        {
+            continue;
+        }
+
+        differ++;
+        if (reported < 10)
+        {
+            for (byte = 0; (byte < gLength) && (byte < aLength) && (g[byte] == a[byte]); byte++)
+            {
+            }
+            printf("  record %zu (type 0x%02X): first difference at byte %zu, "
+                   "golden 0x%02X actual 0x%02X\n",
+                   i, g[2], byte,
+                   (byte < gLength) ? g[byte] : 0,
+                   (byte < aLength) ? a[byte] : 0);
+            reported++;
+        }
+    }
+
+    if (goldenCount != actualCount)
+    {
+        printf("  record count differs: golden %zu actual %zu\n",
+               goldenCount, actualCount);
+        differ += (goldenCount > actualCount) ? (goldenCount - actualCount)
+                                              : (actualCount - goldenCount);
+    }
+
+    free(goldenRecords);
+    free(actualRecords);
+    return differ;
+}
+
+static int Replay_Synthesize(const char *path, unsigned long frames)
+{
+    Replay_Buffer capture = {0};
+    uint8_t payload[CAPTURE_RECORD_SIZE];
+    unsigned long frame;
+    uint16_t channel;
+    uint32_t noise = 12345;
+
+    for (frame = 0; frame < frames; frame++)
+    {
+        Wire_Put_U32(&payload[0], (uint32_t)frame);
+        Wire_Put_U16(&payload[4], 0xFFFF);
+        payload[6] = 0x01;
+        for (channel = 0; channel < SCAN_CHANNELS; channel++)
+        {
+            // Ramps of different slopes plus a little LCG noise
+            uint32_t value = 2048 + (((frame * (channel + 1)) % 1024) - 512);
+
+            noise = (noise * 1103515245UL) + 12345UL;
+            value += (noise >> 28) & 0x7;
+            Wire_Put_U16(&payload[7 + (2 * channel)], (uint16_t)(value & 0x0FFF));
+        }
+        Replay_Append_Record(&capture, WIRE_TYPE_RAW_SCAN, payload, sizeof(payload));
+    }
+
+    if (!Replay_Write_File(path, &capture))
+    {
+        return 2;
+    }
+    printf("wrote %lu synthetic frames to %s\n", frames, path);
+    free(capture.data);
+    return 0;
+}
+
+/*
+ * Rebuilds the full state from a board's link output, one CSV row per
+ * WIRE_TYPE_RBE_SCAN record. Channels not yet reported are left empty.
+ */
+static int Replay_Rebuild_File(const char *path)
+{
+    Replay_Buffer capture = {0};
+    Replay_Rebuild state;
+    Wire_Decoder decoder;
+    size_t i;
+    uint16_t channel;
+
+    memset(&state, 0, sizeof(state));
+    if (!Replay_Read_File(path, &capture))
+    {
+        return 2;
+    }
+
+    printf("sequence,changed");
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        printf(",a%u", channel);
+    }
+    printf("\n");
+
+    Wire_Decoder_Reset(&decoder);
+    for (i = 0; i < capture.length; i++)
+    {
+        if ((Wire_Decode_Byte(&decoder, capture.data[i]) != 1) ||
+            (decoder.type != WIRE_TYPE_RBE_SCAN) ||
+            !Replay_Rebuild_Record(&state, decoder.payload, decoder.length))
+        {
+            continue;
+        }
+
+        printf("%lu,0x%04X", (unsigned long)state.sequence,
+               Wire_Get_U16(&decoder.payload[4]));
+        for (channel = 0; channel < SCAN_CHANNELS; channel++)
+        {
+            if (state.known & ((uint16_t)1 << channel))
+            {
+                printf(",%u", state.value[channel]);
+            }
+            else
+            {
+                printf(",");
+            }
+        }
+        printf("\n");
+    }
+
+    fprintf(stderr, "replay: %lu records, %lu bad\n", state.records, state.badRecords);
+    free(capture.data);
+    return 0;
+}
+
+static void Replay_Usage(void)
+{
+    fprintf(stderr,
+        "usage: replay <capture> [-n passes] [-w golden] [-g golden]\n"
+        "              [-d deadband] [-h heartbeat]\n"
+        "       replay -S <capture> [frames]\n"
+        "       replay -R <link capture>\n");
+}
+
+int main(int argc, char **argv)
+{
+    Replay_Buffer capture = {0};
+    Replay_Buffer golden = {0};
+    Replay_Stage_Time *times;
+    Scan_Frame *frames;
+    Scan_Frame *inputs;
+    Scan_Frame *work;
+    Scan_Frame frame;
+    const char *capturePath = NULL;
+    const char *goldenPath = NULL;
+    const char *writePath = NULL;
+    unsigned long passes = REPLAY_DEFAULT_PASSES;
+    size_t frameCount;
+    size_t badRecords;
+    size_t i;
+    unsigned long pass;
+    uint16_t stage;
+    double totalSeconds = 0.0;
+    unsigned long overDeadband = 0;
+    uint16_t worstError = 0;
+    uint16_t channel;
+    int status = 0;
+    int arg;
+
+    if ((argc >= 3) && (strcmp(argv[1], "-S") == 0))
+    {
+        return Replay_Synthesize(argv[2], (argc > 3) ? strtoul(argv[3], NULL, 0) : 4096);
+    }
+    if ((argc == 3) && (strcmp(argv[1], "-R") == 0))
+    {
+        return Replay_Rebuild_File(argv[2]);
+    }
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-n") == 0) && (arg + 1 < argc))
+        {
+            passes = strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-g") == 0) && (arg + 1 < argc))
+        {
+            goldenPath = argv[++arg];
+        }
+        else if ((strcmp(argv[arg], "-w") == 0) && (arg + 1 < argc))
+        {
+            writePath = argv[++arg];
+        }
+        else if ((strcmp(argv[arg], "-d") == 0) && (arg + 1 < argc))
+        {
+            uint16_t deadband = (uint16_t)strtoul(argv[++arg], NULL, 0);
+
+            rbeConfig.enabled = 1;
+            for (channel = 0; channel < SCAN_CHANNELS; channel++)
+            {
+                rbeConfig.channel[channel].deadband = deadband;
+            }
+        }
+        else if ((strcmp(argv[arg], "-h") == 0) && (arg + 1 < argc))
+        {
+            uint16_t heartbeat = (uint16_t)strtoul(argv[++arg], NULL, 0);
+
+            rbeConfig.enabled = 1;
+            for (channel = 0; channel < SCAN_CHANNELS; channel++)
+            {
+                rbeConfig.channel[channel].heartbeat = heartbeat;
+            }
+        }
+        else if (capturePath == NULL)
+        {
+            capturePath = argv[arg];
+        }
+        else
+        {
+            Replay_Usage();
+            return 2;
+        }
+    }
+
+    if ((capturePath == NULL) || !Replay_Read_File(capturePath, &capture))
+    {
+        Replay_Usage();
+        return 2;
+    }
+
+    frames = Replay_Parse_Capture(&capture, &frameCount, &badRecords);
+    printf("capture: %zu frames, %zu bad records\n", frameCount, badRecords);
+    if (frameCount == 0)
+    {
+        return 2;
+    }
+
+    /*
+     * Golden pass, exactly as ADC12ISR would run it.
+     */
+    recording = 1;
+    for (i = 0; i < frameCount; i++)
+    {
+        uint32_t compared = rbeState.frames;
+
+        frame = frames[i];
+        Scan_Process_Frame(&frame);
+        Replay_Record_Frame(&frame);
+
+        // Every sample the rbe stage saw, against what the host now holds
+        for (channel = 0; (rbeState.frames != compared) && (channel < SCAN_CHANNELS); channel++)
+        {
+            uint16_t error;
+
+            if (!(frame.channelMask & ((uint16_t)1 << channel)))
+            {
+                continue;
+            }
+            error = (frame.sample[channel] > rebuild.value[channel])
+                  ? (frame.sample[channel] - rebuild.value[channel])
+                  : (rebuild.value[channel] - frame.sample[channel]);
+            if (error > worstError)
+            {
+                worstError = error;
+            }
+            if (!(rebuild.known & ((uint16_t)1 << channel)) ||
+                (error > rbeConfig.channel[channel].deadband))
+            {
+                overDeadband++;
+            }
+        }
+    }
+    recording = 0;
+
+    if (rbeConfig.enabled)
+    {
+        // Every frame the stage saw, had it gone out as a WIRE_TYPE_SCAN
+        unsigned long whole = (rbeState.frames * (WIRE_OVERHEAD + 7UL)) +
+                              (2UL * rbeState.samples);
+
+        printf("rbe: deadband %u, heartbeat %u: %lu of %lu samples sent in %lu records\n",
+               rbeConfig.channel[0].deadband, rbeConfig.channel[0].heartbeat,
+               (unsigned long)rbeState.reported, (unsigned long)rbeState.samples,
+               rebuild.records);
+        printf("rbe: link %lu bytes against %lu sent whole, %.1f%% saved\n",
+               rebuild.bytes, whole,
+               whole ? 100.0 * (1.0 - ((double)rebuild.bytes / whole)) : 0.0);
+        printf("rbe: host rebuild worst error %u LSB, %lu samples outside the deadband, "
+               "%lu bad records\n", worstError, overDeadband, rebuild.badRecords);
+        if (overDeadband || rebuild.badRecords)
+        {
+            status = 1;
+        }
+    }
+
+    if (writePath != NULL)
+    {
+        if (!Replay_Write_File(writePath, &output))
+        {
+            return 2;
+        }
+        printf("golden: wrote %zu bytes to %s\n", output.length, writePath);
+    }
+
+    if (goldenPath != NULL)
+    {
+        size_t differ;
+
+        if (!Replay_Read_File(goldenPath, &golden))
+        {
+            return 2;
+        }
+        differ = Replay_Diff(&golden, &output);
+        if (differ == 0)
+        {
+            printf("golden: bit-exact match\n");
+        }
+        else
+        {
+            printf("golden: %zu records differ\n", differ);
+            status = 1;
+        }
+    }
+
+    /*
+     * Each stage's input for every frame, from one more untimed run of
+     * the pipeline. A frame dropped ahead of a stage keeps
+     * SCAN_FRAME_DROP in its copies for the rest, and is skipped there.
+     */
+    inputs = malloc(scanStageCount * frameCount * sizeof(Scan_Frame));
+    work = malloc(frameCount * sizeof(Scan_Frame));
+    times = calloc(scanStageCount, sizeof(Replay_Stage_Time));
+    if ((inputs == NULL) || (work == NULL) || (times == NULL))
+    {
+        fprintf(stderr, "replay: out of memory\n");
+        return 2;
+    }
+    Filter_Reset();
+    Rbe_Reset();
+    for (i = 0; i < frameCount; i++)
+    {
+        frame = frames[i];
+        for (stage = 0; stage < scanStageCount; stage++)
+        {
+            inputs[(stage * frameCount) + i] = frame;
+            if (!(frame.flags & SCAN_FRAME_DROP))
+            {
+                scanStages[stage].run(&frame);
+                times[stage].frames += passes;
+            }
+        }
+    }
+
+    /*
+     * Timed passes, one stage at a time over the whole capture, so a
+     * pair of clock reads covers thousands of calls rather than one.
+     * A stage's own state carries from frame to frame as in the
+     * pipeline. Only the emit stage's Rbe_Commit() lands after the rbe
+     * stage is done, which changes what it flags but not what it
+     * compares.
+     */
+    for (pass = 0; pass < passes; pass++)
+    {
+        Filter_Reset();
+        Rbe_Reset();
+        for (stage = 0; stage < scanStageCount; stage++)
+        {
+            double start;
+            unsigned long long startCycles;
+
+            memcpy(work, &inputs[stage * frameCount], frameCount * sizeof(Scan_Frame));
+            start = Replay_Now();
+            startCycles = Replay_Cycles();
+            for (i = 0; i < frameCount; i++)
+            {
+                if (!(work[i].flags & SCAN_FRAME_DROP))
+                {
+                    scanStages[stage].run(&work[i]);
+                }
+            }
+            times[stage].cycles += Replay_Cycles() - startCycles;
+            times[stage].seconds += Replay_Now() - start;
+        }
+    }
+
+    printf("\n%-12s %10s %12s %14s\n", "stage", "frames", "ns/frame", "frames/s");
+    for (stage = 0; stage < scanStageCount; stage++)
+    {
+        double perFrame = times[stage].frames ? times[stage].seconds / times[stage].frames : 0.0;
+
+        totalSeconds += times[stage].seconds;
+        printf("%-12s %10lu %12.1f %14.0f", scanStages[stage].name,
+               times[stage].frames, perFrame * 1e9,
+               (perFrame > 0.0) ? 1.0 / perFrame : 0.0);
+#ifdef REPLAY_HAVE_TSC
+        printf("   %8.1f cycles/frame",
+               times[stage].frames ? (double)times[stage].cycles / times[stage].frames : 0.0);
+#endif
+        printf("\n");
+    }
+    if (passes > 0)
+    {
+        double perFrame = totalSeconds / ((double)passes * frameCount);
+
+        printf("%-12s %10lu %12.1f %14.0f\n", "total",
+               passes * (unsigned long)frameCount, perFrame * 1e9,
+               (perFrame > 0.0) ? 1.0 / perFrame : 0.0);
+    }
+
+    free(times);
+    free(work);
+    free(inputs);
+    free(frames);
+    free(capture.data);
+    free(golden.data);
+    free(output.data);
+    return status;
+}
@@ -0,0 +1,669 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Host simulator for the multi-rate scan schedule.
+ *
+ * Builds the slot table with the same Sched_Build() the target runs,
+ * steps through it slot by slot the way ADC12ISR does, and checks
+ * that every channel is converted at exactly slotHz / divider with
+ * even spacing. The timing model in sched.h flags slots that can't
+ * finish converting, plus an ISR estimate, before the next trigger.
+ *
+ * With any of -R, -D, -C or -H the run is reconfigured half way: the
+ * transaction a host would send is framed, decoded and handed to the
+ * command suite one record per slot, and the table swap happens in
+ * Sched_Advance() like on the target. Both configs are checked on
+ * their own side of the switch, and the switch must cost at most one
+ * dropped trigger. The COMMIT asks for the config to be kept, so it is
+ * saved to the settings record as main() would and must load back
+ * exactly, and not at all once the record is corrupted.
+ *
+ * Build from the repo root:
+ *   gcc -O2 -I. -o schedsim host/schedsim.c sched.c command.c wire.c \
+ *       persist_settings.c
+ *
+ * Usage:
+ *   schedsim [-r slotHz] [-d d0,d1,d2,d3] [-c classes] [-h s0,s1]
+ *            [-n hyperperiods] [-m mclkHz]
+ *            [-R slotHz] [-D d0,d1,d2,d3] [-C classes] [-H s0,s1] [-x slot]
+ *
+ *   classes is one character per channel A0..A15: 0-3 for a rate class,
+ *   '-' for off. s0,s1 are ADC12SHTx codes for buffers 0-7 and 8-15.
+ *   Upper case options give the new config, -x the slot the host starts
+ *   sending it. E.g. -r 1000 -c 0000333333333333 -R 500 -C 00003333--------
+ *   A new config the node would refuse, e.g. too fast for its busiest
+ *   slot, ends in REJECTED.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sched.h"
+#include "command.h"
+#include "wire.h"
+#include "persist.h"
+
+#define SIM_MAX_RECORDS     8
+
+typedef struct
+{
+    const Sched_Config *config;
+    unsigned long slots;
+    unsigned long overruns;
+    unsigned long conversions;
+    unsigned long count[SCAN_CHANNELS];
+    long last[SCAN_CHANNELS];
+    long spacingMin[SCAN_CHANNELS];
+    long spacingMax[SCAN_CHANNELS];
+    double seconds;
+    uint32_t worstNs;
+} Sim_Phase;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t length;
+    uint8_t payload[WIRE_MAX_PAYLOAD];
+} Sim_Record;
+
+static int Sim_Parse_List(const char *text, uint16_t *values, int count)
+{
+    int index = 0;
+    char *end;
+
+    while ((*text != '\0') && (index < count))
+    {
+        values[index++] = (uint16_t)strtoul(text, &end, 0);
+        if (end == text)
+        {
+            return 0;
+        }
+        text = (*end == ',') ? end + 1 : end;
+    }
+    return 1;
+}
+
+static int Sim_Parse_Dividers(const char *text, Sched_Config *config)
+{
+    return Sim_Parse_List(text, config->divider, SCHED_CLASSES);
+}
+
+static int Sim_Parse_Sample_Hold(const char *text, Sched_Config *config)
+{
+    uint16_t codes[2] = { config->sampleHold[0], config->sampleHold[1] };
+
+    if (!Sim_Parse_List(text, codes, 2) ||
+        (codes[0] > SCHED_MAX_SAMPLE) || (codes[1] > SCHED_MAX_SAMPLE))
+    {
+        return 0;
+    }
+    config->sampleHold[0] = (uint8_t)codes[0];
+    config->sampleHold[1] = (uint8_t)codes[1];
+    return 1;
+}
+
+static int Sim_Parse_Classes(const char *text, Sched_Config *config)
+{
+    int channel;
+
+    if (strlen(text) != SCAN_CHANNELS)
+    {
+        return 0;
+    }
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        if (text[channel] == '-')
+        {
+            config->channelClass[channel] = SCHED_CLASS_OFF;
+        }
+        else if ((text[channel] >= '0') && (text[channel] < '0' + SCHED_CLASSES))
+        {
+            config->channelClass[channel] = (uint8_t)(text[channel] - '0');
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void Sim_Phase_Start(Sim_Phase *phase, const Sched_Config *config)
+{
+    int channel;
+
+    memset(phase, 0, sizeof(*phase));
+    phase->config = config;
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        phase->last[channel] = -1;
+        phase->spacingMin[channel] = 0x7FFFFFFF;
+    }
+}
+
+static void Sim_Phase_Slot(Sim_Phase *phase, uint16_t mask, double seconds)
+{
+    long slot = (long)phase->slots;
+    int channel;
+
+    phase->slots++;
+    phase->seconds += seconds;
+    phase->conversions += mask ? Sched_Channel_Count(mask) : 1;
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        if (!(mask & (1u << channel)))
+        {
+            continue;
+        }
+        phase->count[channel]++;
+        if (phase->last[channel] >= 0)
+        {
+            long spacing = slot - phase->last[channel];
+
+            if (spacing < phase->spacingMin[channel])
+            {
+                phase->spacingMin[channel] = spacing;
+            }
+            if (spacing > phase->spacingMax[channel])
+            {
+                phase->spacingMax[channel] = spacing;
+            }
+        }
+        phase->last[channel] = slot;
+    }
+}
+
+/*
+ * Prints the per-channel table and returns the number of failures.
+ * A channel must come up every divider slots exactly, and as many
+ * times as fit in the phase.
+ */
+static int Sim_Phase_Report(const char *title, const Sim_Phase *phase,
+                            const Sched_Table *table, unsigned long mclkHz)
+{
+    const Sched_Config *config = phase->config;
+    double slotSeconds = 1.0 / config->slotHz;
+    int failures = 0;
+    int channel;
+
+    printf("%s: slot rate %u Hz, hyperperiod %u slots, busiest slot %u channels\n",
+           title, config->slotHz, table->slots, table->maxPerSlot);
+    printf("simulated %lu slots (%.3f s)\n\n", phase->slots, phase->seconds);
+    printf("%-8s %5s %12s %12s %10s\n", "channel", "class", "expect Hz", "achieved Hz", "spacing");
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        uint8_t rateClass = config->channelClass[channel];
+        unsigned long count = phase->count[channel];
+        double achieved = count / phase->seconds;
+        int ok;
+
+        if (rateClass == SCHED_CLASS_OFF)
+        {
+            printf("A%-7d %5s %12s %12.3f %10s\n", channel, "off", "-", achieved, "-");
+            ok = (count == 0);
+        }
+        else
+        {
+            uint16_t divider = config->divider[rateClass];
+            unsigned long fit = phase->slots / divider;
+
+            ok = ((count == fit) || (count == fit + 1)) &&
+                 ((count < 2) ||
+                  ((phase->spacingMin[channel] == divider) &&
+                   (phase->spacingMax[channel] == divider)));
+            printf("A%-7d %5u %12.3f %12.3f %10ld%s\n", channel, rateClass,
+                   (double)config->slotHz / divider, achieved,
+                   (count < 2) ? 0L : phase->spacingMax[channel],
+                   ok ? "" : "  MISMATCH");
+        }
+        if (!ok)
+        {
+            failures++;
+        }
+    }
+
+    printf("\nADC conversions/s: %.0f, fixed 16-channel scan at this slot rate: %.0f\n",
+           phase->conversions / phase->seconds, 16.0 * config->slotHz);
+    printf("worst slot busy %.1f us of %.1f us, %lu overruns (at MCLK %lu Hz), "
+           "achievable slot rate %u Hz\n\n",
+           phase->worstNs / 1000.0, slotSeconds * 1e6, phase->overruns, mclkHz,
+           Sched_Max_Slot_Hz(table, mclkHz));
+
+    if (phase->overruns > 0)
+    {
+        failures++;
+    }
+    return failures;
+}
+
+static void Sim_Add_Record(Sim_Record *records, int *count, uint8_t type,
+                           const uint8_t *payload, uint8_t length)
+{
+    records[*count].type = type;
+    records[*count].length = length;
+    memcpy(records[*count].payload, payload, length);
+    (*count)++;
+}
+
+static void Sim_Add_Setting(Sim_Record *records, int *count, uint8_t *set,
+                            uint8_t *length, uint8_t key, uint16_t value)
+{
+    if (*length + COMMAND_SET_BYTES > WIRE_MAX_PAYLOAD)
+    {
+        Sim_Add_Record(records, count, WIRE_TYPE_CMD_SET, set, *length);
+        *length = 1;
+    }
+    set[(*length)++] = key;
+    Wire_Put_U16(&set[*length], value);
+    *length += 2;
+}
+
+/*
+ * The transaction a host would send to go from one config to the
+ * other: BEGIN, only the settings that differ, COMMIT.
+ */
+static int Sim_Transaction(const Sched_Config *from, const Sched_Config *to,
+                           uint8_t transaction, Sim_Record *records)
+{
+    uint8_t set[WIRE_MAX_PAYLOAD];
+    uint8_t length = 1;
+    uint8_t commit[2] = { transaction, COMMAND_COMMIT_SAVE };
+    int count = 0;
+    int i;
+
+    set[0] = transaction;
+    Sim_Add_Record(records, &count, WIRE_TYPE_CMD_BEGIN, &transaction, 1);
+
+    if (to->slotHz != from->slotHz)
+    {
+        Sim_Add_Setting(records, &count, set, &length, COMMAND_KEY_SLOT_HZ, to->slotHz);
+    }
+    for (i = 0; i < SCHED_CLASSES; i++)
+    {
+        if (to->divider[i] != from->divider[i])
+        {
+            Sim_Add_Setting(records, &count, set, &length,
+                            (uint8_t)(COMMAND_KEY_DIVIDER + i), to->divider[i]);
+        }
+    }
+    for (i = 0; i < SCAN_CHANNELS; i++)
+    {
+        if (to->channelClass[i] != from->channelClass[i])
+        {
+            Sim_Add_Setting(records, &count, set, &length,
+                            (uint8_t)(COMMAND_KEY_CLASS + i), to->channelClass[i]);
+        }
+    }
+    for (i = 0; i < 2; i++)
+    {
+        if (to->sampleHold[i] != from->sampleHold[i])
+        {
+            Sim_Add_Setting(records, &count, set, &length,
+                            (uint8_t)(COMMAND_KEY_SAMPLE_HOLD + i), to->sampleHold[i]);
+        }
+    }
+    if (length > 1)
+    {
+        Sim_Add_Record(records, &count, WIRE_TYPE_CMD_SET, set, length);
+    }
+
+    Sim_Add_Record(records, &count, WIRE_TYPE_CMD_COMMIT, commit, 2);
+    return count;
+}
+
+/*
+ * What main() does with one record off the link: decode it byte by
+ * byte and hand it to the command suite. Returns the ACK status.
+ */
+static int Sim_Send(const Sim_Record *record, unsigned long slot)
+{
+    static const char *names[] = { "BEGIN", "SET", "COMMIT", "ABORT", "QUERY" };
+    uint8_t frame[WIRE_MAX_PAYLOAD + WIRE_OVERHEAD];
+    uint8_t ack[COMMAND_ACK_BYTES];
+    Wire_Decoder decoder;
+    uint16_t size;
+    uint16_t i;
+
+    Wire_Decoder_Reset(&decoder);
+    size = Wire_Encode(frame, record->type, record->payload, record->length);
+    for (i = 0; i < size; i++)
+    {
+        if (Wire_Decode_Byte(&decoder, frame[i]) > 0)
+        {
+            break;
+        }
+    }
+    if ((i == size) || (Command_Handle(&decoder, ack) != COMMAND_ACK_BYTES))
+    {
+        printf("slot %6lu  record 0x%02X not handled\n", slot, record->type);
+        return -1;
+    }
+
+    printf("slot %6lu  %-6s %2u bytes -> status %u detail %u",
+           slot, names[record->type - WIRE_TYPE_CMD_BEGIN], record->length,
+           ack[2], ack[3]);
+    if (record->type == WIRE_TYPE_CMD_COMMIT)
+    {
+        printf(", achievable slot rate %u Hz", Wire_Get_U16(&ack[4]));
+    }
+    printf("\n");
+
+    return ack[2];
+}
+
+/*
+ * What main() does with a COMMIT that asked to keep the config, then
+ * what the next boot does with it. Returns the number of failures.
+ */
+static int Sim_Persist(const Sched_Config *config)
+{
+    const Sched_Config *loaded;
+    int failures = 0;
+
+    Persist_Save_Settings(config);
+    loaded = Persist_Load_Settings(&schedDefaultConfig);
+    if ((loaded == &schedDefaultConfig) || (memcmp(loaded, config, sizeof(*config)) != 0))
+    {
+        failures++;
+    }
+    printf("             saved to FRAM: %s", (failures == 0) ? "loads back" : "lost at boot");
+
+    // One flipped bit must send the boot back to the default
+    acqSettings.sched.slotHz ^= 1;
+    if (Persist_Load_Settings(&schedDefaultConfig) != &schedDefaultConfig)
+    {
+        printf(", corrupted copy accepted");
+        failures++;
+    }
+    acqSettings.sched.slotHz ^= 1;
+    printf("\n\n");
+
+    return failures;
+}
+
+static void Sim_Print_Report(const uint8_t *report, unsigned long slot)
+{
+    int i;
+
+    printf("slot %6lu  CONFIG transaction %u: %u Hz slots, %u slot hyperperiod, "
+           "busiest %u channels, worst %.1f us, achievable %u Hz\n",
+           slot, report[0], Wire_Get_U16(&report[2]), Wire_Get_U16(&report[30]),
+           Wire_Get_U16(&report[32]), Wire_Get_U32(&report[34]) / 1000.0,
+           Wire_Get_U16(&report[38]));
+    printf("             class rates");
+    for (i = 0; i < SCHED_CLASSES; i++)
+    {
+        printf(" %.3f", Wire_Get_U32(&report[40 + (4 * i)]) / 1000.0);
+    }
+    printf(" Hz\n");
+    printf("             measured ADC12ISR: worst %lu cycles at %u channels, "
+           "%u past the model\n", (unsigned long)Wire_Get_U32(&report[56]),
+           Wire_Get_U16(&report[60]), Wire_Get_U16(&report[62]));
+}
+
+int main(int argc, char **argv)
+{
+    Sched_Config config = schedDefaultConfig;
+    Sched_Config next;
+    Sim_Record records[SIM_MAX_RECORDS];
+    Sim_Phase phases[2];
+    Sim_Phase *phase = &phases[0];
+    const Sched_Table *tables[2];
+    unsigned long hyperperiods = 4;
+    unsigned long mclkHz = SCHED_MCLK_HZ;
+    unsigned long sendAt = 0;
+    unsigned long slot;
+    unsigned long endSlot;
+    unsigned long swapSlot = 0;
+    unsigned long dropped = 0;
+    double stretch = 0.0;
+    uint32_t swapNs = 0;
+    uint16_t status;
+    int reconfigure = 0;
+    int rejected = 0;
+    int recordCount = 0;
+    int sent = 0;
+    int failures = 0;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        int ok = 1;
+
+        if (arg + 1 >= argc)
+        {
+            ok = 0;
+        }
+        else if (strcmp(argv[arg], "-r") == 0)
+        {
+            config.slotHz = (uint16_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else if (strcmp(argv[arg], "-d") == 0)
+        {
+            ok = Sim_Parse_Dividers(argv[++arg], &config);
+        }
+        else if (strcmp(argv[arg], "-c") == 0)
+        {
+            ok = Sim_Parse_Classes(argv[++arg], &config);
+        }
+        else if (strcmp(argv[arg], "-h") == 0)
+        {
+            ok = Sim_Parse_Sample_Hold(argv[++arg], &config);
+        }
+        else if (strcmp(argv[arg], "-n") == 0)
+        {
+            hyperperiods = strtoul(argv[++arg], NULL, 0);
+        }
+        else if (strcmp(argv[arg], "-m") == 0)
+        {
+            mclkHz = strtoul(argv[++arg], NULL, 0);
+        }
+        else if (strcmp(argv[arg], "-x") == 0)
+        {
+            sendAt = strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-R") == 0) || (strcmp(argv[arg], "-D") == 0) ||
+                 (strcmp(argv[arg], "-C") == 0) || (strcmp(argv[arg], "-H") == 0))
+        {
+            // New config, applied on top of the old one once that is final
+            reconfigure = 1;
+            arg++;
+        }
+        else
+        {
+            ok = 0;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "usage: schedsim [-r slotHz] [-d d0,d1,d2,d3] [-c classes] "
+                            "[-h s0,s1] [-n hyperperiods] [-m mclkHz]\n"
+                            "                [-R slotHz] [-D d0,d1,d2,d3] [-C classes] "
+                            "[-H s0,s1] [-x slot]\n");
+            return 2;
+        }
+    }
+
+    next = config;
+    for (arg = 1; arg < argc; arg++)
+    {
+        int ok = 1;
+
+        if (strcmp(argv[arg], "-R") == 0)
+        {
+            next.slotHz = (uint16_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else if (strcmp(argv[arg], "-D") == 0)
+        {
+            ok = Sim_Parse_Dividers(argv[++arg], &next);
+        }
+        else if (strcmp(argv[arg], "-C") == 0)
+        {
+            ok = Sim_Parse_Classes(argv[++arg], &next);
+        }
+        else if (strcmp(argv[arg], "-H") == 0)
+        {
+            ok = Sim_Parse_Sample_Hold(argv[++arg], &next);
+        }
+        else if ((argv[arg][0] == '-') && (arg + 1 < argc))
+        {
+            arg++;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "schedsim: bad %s\n", argv[arg - 1]);
+            return 2;
+        }
+    }
+
+    if ((config.slotHz == 0) || (mclkHz < 1000))
+    {
+        fprintf(stderr, "schedsim: slotHz must be non-zero and MCLK at least 1 kHz\n");
+        return 2;
+    }
+
+    status = Sched_Load(&config);
+    if (status != SCHED_OK)
+    {
+        fprintf(stderr, "schedsim: Sched_Build failed (%u)\n", status);
+        return 2;
+    }
+    tables[0] = schedActive;
+    tables[1] = schedActive;
+
+    endSlot = hyperperiods * schedActive->slots;
+    if (reconfigure)
+    {
+        recordCount = Sim_Transaction(&config, &next, 1, records);
+        if (sendAt == 0)
+        {
+            sendAt = endSlot / 2;
+        }
+        // Runs on until the new config has had its hyperperiods too
+        endSlot = ~0UL;
+    }
+
+    Sim_Phase_Start(&phases[0], &schedActive->config);
+
+    /*
+     * Step through the table exactly like ADC12ISR, then do what main()
+     * would with whatever the link brought in during the slot.
+     */
+    for (slot = 0; slot < endSlot; slot++)
+    {
+        const Sched_Table *table = schedActive;
+        uint16_t mask = table->mask[schedSlot];
+        double slotSeconds = 1.0 / table->config.slotHz;
+        uint16_t nextMask;
+        uint32_t busyNs;
+        uint8_t report[COMMAND_REPORT_BYTES];
+        unsigned char save;
+
+        if (Sched_Advance())
+        {
+            /*
+             * Full reprogram for the new table. A new rate restarts the
+             * timer once reprogrammed, which stretches this slot but
+             * can't lose a trigger. At the same rate the timer runs on
+             * and the next trigger is lost if the swap isn't done.
+             */
+            nextMask = schedActive->mask[schedSlot];
+            busyNs = Sched_Slot_Ns(&table->config, mask, mask, mclkHz) +
+                     ((Sched_Channel_Count(nextMask) * SCHED_REPROGRAM_CYCLES +
+                       SCHED_SWAP_CYCLES) * 1000000UL) / (mclkHz / 1000UL);
+            swapNs = busyNs;
+            swapSlot = slot;
+            if (schedActive->config.slotHz != table->config.slotHz)
+            {
+                stretch = busyNs / 1e9;
+            }
+            else
+            {
+                while (busyNs > (dropped + 1) * slotSeconds * 1e9)
+                {
+                    dropped++;
+                }
+            }
+
+            // Swap cost is reported on its own, not as an overrun
+            Sim_Phase_Slot(phase, mask, slotSeconds + stretch +
+                           dropped * slotSeconds);
+
+            tables[1] = schedActive;
+            phase = &phases[1];
+            Sim_Phase_Start(phase, &schedActive->config);
+            endSlot = slot + 1 + hyperperiods * schedActive->slots;
+        }
+        else
+        {
+            nextMask = schedActive->mask[schedSlot];
+            busyNs = Sched_Slot_Ns(&table->config, mask, nextMask, mclkHz);
+            if (busyNs > phase->worstNs)
+            {
+                phase->worstNs = busyNs;
+            }
+            if (busyNs > slotSeconds * 1e9)
+            {
+                phase->overruns++;
+            }
+            Sim_Phase_Slot(phase, mask, slotSeconds);
+        }
+
+        if (reconfigure && (slot >= sendAt) && (sent < recordCount))
+        {
+            status = (uint16_t)Sim_Send(&records[sent++], slot);
+            if (status != COMMAND_OK)
+            {
+                printf("transaction rejected, config unchanged\n\n");
+                rejected = 1;
+                reconfigure = 0;
+                endSlot = slot + 1 + hyperperiods * schedActive->slots;
+            }
+        }
+        while (Command_Report(report, &save))
+        {
+            Sim_Print_Report(report, slot);
+            if (Wire_Get_U16(&report[38]) != Sched_Max_Slot_Hz(schedActive, mclkHz))
+            {
+                failures++;
+            }
+            if (save)
+            {
+                failures += Sim_Persist(&schedActive->config);
+            }
+            else
+            {
+                printf("\n");
+            }
+        }
+    }
+
+    failures += Sim_Phase_Report(reconfigure ? "before" : "config", &phases[0],
+                                 tables[0], mclkHz);
+    if (reconfigure)
+    {
+        failures += Sim_Phase_Report("after", &phases[1], tables[1], mclkHz);
+
+        printf("switched after slot %lu: swap slot busy %.1f us, %s, "
+               "dropped triggers %lu\n",
+               swapSlot, swapNs / 1000.0,
+               (stretch > 0.0) ? "timer restarted at the new rate" : "timer ran on",
+               dropped);
+        if (stretch > 0.0)
+        {
+            printf("one slot stretched by %.1f us\n", stretch * 1e6);
+        }
+        if (dropped > 1)
+        {
+            failures++;
+        }
+    }
+
+    printf("%s\n", failures ? "FAIL" : (rejected ? "REJECTED" : "PASS"));
+    return (failures || rejected) ? 1 : 0;
+}
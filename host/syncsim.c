@@ -0,0 +1,1046 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Host simulator for synchronized sampling across boards, sync.c and
+ * synclock.c, with several nodes on a virtual sync line.
+ *
+ * Every node runs its own Timer_A0 and timestamp off its own DCO,
+ * some ppm off nominal. Node 0 is the master: at each trigger its
+ * CCR0 interrupt raises the line and CCR2 drops it, each after a few
+ * cycles of interrupt latency. The others are slaves: each edge
+ * reaches their port interrupt after their own latency, later still
+ * if ADC12ISR is running, the timer is read then and the CCR0 write
+ * synclock.c asks for lands some cycles after. Each trigger's frame
+ * is tagged when its conversions are done, with one channel sampling
+ * a common 50 Hz signal at the trigger's true time, and sent into
+ * the node's wire stream as scan.c would.
+ *
+ * The run has the last slave join late, the master stop and restart
+ * the scan once, and a glitch on the line. Then the streams are
+ * merged by sync count into one row per master slot, the way a host
+ * merges boards, and checked against what really happened:
+ *  - a valid count always names the master slot the frame came from,
+ *  - valid frames trigger within the skew limit of the master,
+ *  - the skew a frame reports is within the error limit of the truth,
+ *  - every slave gets a valid count back within three superframes of
+ *    joining or of any upset.
+ *
+ * With -m, merges captured link output instead, one file per board,
+ * and prints the rows as CSV.
+ *
+ * Build from the repo root:
+ *   gcc -O2 -I. -o syncsim host/syncsim.c synclock.c wire.c -lm
+ *
+ * Usage:
+ *   syncsim [-n nodes] [-r slot Hz] [-p ppm] [-j cycles] [-t s]
+ *           [-s skew us] [-e error ticks]
+ *   syncsim -m board0.bin board1.bin ...
+ *
+ *   ppm is the largest clock offset of a slave, spread from -ppm to
+ *   +ppm across them, jitter the most extra cycles of interrupt
+ *   latency at each end, t the length of the run. The skew limit
+ *   defaults to 3 us plus four times the jitter, the error limit to
+ *   2 ticks plus three times it, both at the profile's MCLK.
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adc.h"
+#include "clock.h"
+#include "sched.h"
+#include "scan.h"
+#include "sync.h"
+#include "synclock.h"
+#include "timestamp.h"
+#include "wire.h"
+
+#define SIM_MAX_NODES       8
+#define SIM_MAX_EDGES       8
+
+// The common signal every node samples
+#define SIM_SIGNAL_HZ       50.0
+#define SIM_SIGNAL_MID      2048.0
+#define SIM_SIGNAL_SWING    2000.0
+
+// Three superframes and change, see synclock.h
+#define SIM_LOCK_SLOTS      ((3 * SYNCLOCK_SUPER_SLOTS) + 3)
+
+#define SIM_NEVER           1.0e30
+
+typedef struct
+{
+    uint16_t slotHz;
+    unsigned nodes;
+    double ppm;
+    unsigned jitter;
+    double seconds;
+    double joinAt;
+    double gapAt;
+    double gapLength;
+    double glitchAt;
+    double glitchLength;
+} Sim_Config;
+
+/*
+ * Truth about a frame, kept next to the stream.
+ */
+typedef struct
+{
+    double trigger;
+    Synclock_Tag tag;
+} Sim_Frame;
+
+typedef struct
+{
+    unsigned char master;
+    double ppm;
+    double tickUs;
+    double cycleUs;
+    double stampUs;
+
+    // Timer_A0, up mode
+    unsigned char running;
+    double epoch;           /* when the count was 0 this period */
+    uint16_t ccr0;
+    uint16_t lastCcr0;
+    double nextTrigger;
+
+    // Slot conversions and ADC12ISR
+    unsigned char converting;
+    double trigger;
+    double convertEnd;
+    double isrEnd;
+
+    // Slave port interrupt
+    unsigned char expectFall;
+    unsigned char readPending;
+    double readAt;
+    double readDone;
+    double lastTriggerAt;
+    unsigned char writePending;
+    double writeAt;
+    uint8_t writeRetime;
+    uint16_t writeCcr0;
+    unsigned char armed;    /* CCR0 interrupt for a retime after the trigger */
+    uint16_t armedCcr0;
+
+    Synclock_Master sync;
+    Synclock_Slave slave;
+
+    uint8_t *stream;
+    size_t length;
+    size_t capacity;
+    Sim_Frame *frames;
+    size_t frameCount;
+    size_t frameCapacity;
+    uint32_t sequence;
+
+    double settleFrom;      /* join, or the last upset          */
+    double lockedAt;
+    double worstLock;
+    unsigned badWrites;
+} Sim_Node;
+
+/*
+ * Line edges the master's interrupts have committed to.
+ */
+typedef struct
+{
+    double at;
+    unsigned char level;
+} Sim_Edge;
+
+static Sim_Node simNodes[SIM_MAX_NODES];
+static Sim_Edge simEdges[SIM_MAX_EDGES];
+static unsigned simEdgeCount = 0;
+static unsigned char simLine = 0;
+static double simConvertUs;
+static double simIsrUs;
+static uint32_t simRandom = 1;
+
+// Master trigger times by count
+static double *simMasterAt = NULL;
+static size_t simMasterCount = 0;
+
+static double Sim_Random(void)
+{
+    simRandom = (simRandom * 1103515245UL) + 12345UL;
+    return ((simRandom >> 8) & 0xFFFFUL) / 65536.0;
+}
+
+static double Sim_Latency(const Sim_Node *node, unsigned cycles, unsigned jitter)
+{
+    return (cycles + (Sim_Random() * jitter)) * node->cycleUs;
+}
+
+static void Sim_Append(uint8_t **data, size_t *length, size_t *capacity,
+                       const void *bytes, size_t size)
+{
+    if ((*length + size) > *capacity)
+    {
+        *capacity = (*capacity + size) * 2;
+        *data = realloc(*data, *capacity);
+        if (*data == NULL)
+        {
+            fprintf(stderr, "syncsim: out of memory\n");
+            exit(2);
+        }
+    }
+    memcpy(*data + *length, bytes, size);
+    *length += size;
+}
+
+static void Sim_Add_Edge(double at, unsigned char level)
+{
+    if (simEdgeCount < SIM_MAX_EDGES)
+    {
+        simEdges[simEdgeCount].at = at;
+        simEdges[simEdgeCount].level = level;
+        simEdgeCount++;
+    }
+}
+
+static uint16_t Sim_Timer(const Sim_Node *node, double at)
+{
+    double ticks;
+
+    // Between the trigger and the wrap
+    if (at < node->epoch)
+    {
+        return node->lastCcr0;
+    }
+
+    ticks = floor((at - node->epoch) / node->tickUs);
+    return (uint16_t)((ticks > node->ccr0) ? node->ccr0 : ticks);
+}
+
+static uint32_t Sim_Stamp(const Sim_Node *node, double at)
+{
+    return (uint32_t)(uint64_t)floor(at / node->stampUs);
+}
+
+static void Sim_Start_Timer(Sim_Node *node, double at, uint16_t period)
+{
+    node->running = 1;
+    node->ccr0 = period - 1;
+    node->lastCcr0 = node->ccr0;
+    node->epoch = at;
+    node->nextTrigger = at + (node->ccr0 * node->tickUs);
+}
+
+static void Sim_Init_Node(Sim_Node *node, unsigned char master, double ppm,
+                          uint16_t period)
+{
+    double rate = 1.0 + (ppm / 1.0e6);
+
+    memset(node, 0, sizeof(*node));
+    node->master = master;
+    node->ppm = ppm;
+    node->tickUs = 1.0e6 / (ADC_TIMER_HZ * rate);
+    node->cycleUs = 1.0e6 / (SCHED_MCLK_HZ * rate);
+    node->stampUs = 1.0e6 / (TIMESTAMP_HZ * rate);
+    node->readAt = SIM_NEVER;
+    node->writeAt = SIM_NEVER;
+    node->lockedAt = SIM_NEVER;
+
+    if (master)
+    {
+        Synclock_Master_Init(&node->sync, period);
+    }
+    else
+    {
+        // As Sync_Start() works it out from the nominal rates
+        Synclock_Slave_Init(&node->slave, period,
+            (((uint32_t)period * TIMESTAMP_HZ) + (ADC_TIMER_HZ / 2)) / ADC_TIMER_HZ,
+            SYNC_LATENCY_TICKS, SYNC_LEAD_TICKS, SYNC_GUARD_TICKS);
+    }
+}
+
+/*
+ * A slave's timer from when it starts, at a phase of its own.
+ */
+static void Sim_Join(Sim_Node *node, double at, uint16_t period)
+{
+    Sim_Start_Timer(node, at - (Sim_Random() * period * node->tickUs), period);
+    node->settleFrom = at;
+    node->lockedAt = SIM_NEVER;
+}
+
+static void Sim_Upset(const Sim_Config *config, double at)
+{
+    unsigned index;
+
+    for (index = 1; index < config->nodes; index++)
+    {
+        if (simNodes[index].running)
+        {
+            simNodes[index].settleFrom = at;
+            simNodes[index].lockedAt = SIM_NEVER;
+        }
+    }
+}
+
+static void Sim_Trigger(const Sim_Config *config, Sim_Node *node)
+{
+    double at = node->nextTrigger;
+    double rise;
+
+    node->lastTriggerAt = at;
+
+    // An overrun, the ADC is still busy and ignores the trigger
+    if (!node->converting)
+    {
+        node->converting = 1;
+        node->trigger = at;
+        node->convertEnd = at + simConvertUs;
+    }
+
+    node->lastCcr0 = node->ccr0;
+    node->epoch += (node->ccr0 + 1) * node->tickUs;
+    node->nextTrigger = node->epoch + (node->ccr0 * node->tickUs);
+
+    if (!node->master)
+    {
+        // TIMER0_A0_ISR on a slave
+        if (node->armed)
+        {
+            node->armed = 0;
+            node->writePending = 1;
+            node->writeAt = at + Sim_Latency(node, SYNC_SLAVE_CYCLES, config->jitter);
+            node->writeRetime = SYNCLOCK_RETIME_NOW;
+            node->writeCcr0 = node->armedCcr0;
+        }
+        return;
+    }
+
+    // TIMER0_A0_ISR, then TIMER0_A1_ISR at CCR2
+    if (node->sync.width)
+    {
+        rise = at + Sim_Latency(node, SYNC_MASTER_CYCLES, config->jitter);
+        Sim_Add_Edge(rise, 1);
+        Sim_Add_Edge(at + ((node->sync.width + 1) * node->tickUs) +
+                     Sim_Latency(node, SYNC_MASTER_CYCLES, config->jitter), 0);
+    }
+
+    Synclock_Master_Trigger(&node->sync);
+    if (node->sync.last >= simMasterCount)
+    {
+        simMasterCount = node->sync.last + 1;
+        simMasterAt = realloc(simMasterAt, simMasterCount * sizeof(double));
+    }
+    simMasterAt[node->sync.last] = at;
+}
+
+/*
+ * ADC12ISR: tags the frame and sends it as the emit stage would.
+ */
+static void Sim_Frame_Done(Sim_Node *node)
+{
+    uint8_t payload[SCAN_SYNC_BYTES + 9];
+    uint8_t record[SCAN_SYNC_BYTES + 9 + WIRE_OVERHEAD];
+    Sim_Frame frame;
+    double sample;
+
+    frame.trigger = node->trigger;
+    if (node->master)
+    {
+        Synclock_Master_Slot(&node->sync, &frame.tag);
+    }
+    else
+    {
+        Synclock_Slave_Slot(&node->slave, &frame.tag);
+    }
+    frame.tag.node = (uint8_t)(node - simNodes);
+
+    sample = SIM_SIGNAL_MID + (SIM_SIGNAL_SWING *
+             sin(2.0 * M_PI * SIM_SIGNAL_HZ * node->trigger / 1.0e6));
+
+    payload[0] = frame.tag.node;
+    payload[1] = frame.tag.flags;
+    Wire_Put_U32(&payload[2], frame.tag.count);
+    Wire_Put_U16(&payload[6], (uint16_t)frame.tag.skew);
+    Wire_Put_U32(&payload[SCAN_SYNC_BYTES], node->sequence++);
+    Wire_Put_U16(&payload[SCAN_SYNC_BYTES + 4], 0x0001);
+    payload[SCAN_SYNC_BYTES + 6] = 0x01;
+    Wire_Put_U16(&payload[SCAN_SYNC_BYTES + 7], (uint16_t)lround(sample));
+    Sim_Append(&node->stream, &node->length, &node->capacity, record,
+               Wire_Encode(record, WIRE_TYPE_SYNC_SCAN, payload, sizeof(payload)));
+
+    if (node->frameCount == node->frameCapacity)
+    {
+        node->frameCapacity = node->frameCapacity ? node->frameCapacity * 2 : 1024;
+        node->frames = realloc(node->frames, node->frameCapacity * sizeof(Sim_Frame));
+    }
+    node->frames[node->frameCount++] = frame;
+
+    if ((frame.tag.flags & SYNCLOCK_VALID) && (node->lockedAt == SIM_NEVER))
+    {
+        node->lockedAt = node->trigger;
+        if ((node->lockedAt - node->settleFrom) > node->worstLock)
+        {
+            node->worstLock = node->lockedAt - node->settleFrom;
+        }
+    }
+
+    node->converting = 0;
+    node->isrEnd = node->convertEnd + simIsrUs;
+}
+
+/*
+ * PORT2_ISR on a slave.
+ */
+static void Sim_Read(const Sim_Config *config, Sim_Node *node)
+{
+    double at = node->readAt;
+    uint16_t ticks = Sim_Timer(node, at);
+    uint16_t period = node->ccr0 + 1;
+    Synclock_Action action;
+
+    node->readPending = 0;
+    node->readAt = SIM_NEVER;
+
+    if (node->expectFall)
+    {
+        node->expectFall = 0;
+        Synclock_Fall(&node->slave, ticks, period);
+        return;
+    }
+    node->expectFall = 1;
+
+    action = Synclock_Rise(&node->slave, ticks, period, Sim_Stamp(node, at),
+                           node->converting && (node->trigger <= at));
+    if (action.retime != SYNCLOCK_RETIME_NONE)
+    {
+        node->writePending = 1;
+        node->writeAt = at + Sim_Latency(node, SYNC_RISE_CYCLES / 2, config->jitter);
+        node->writeRetime = action.retime;
+        node->writeCcr0 = action.ccr0;
+    }
+    node->readDone = at;
+}
+
+static void Sim_Write(Sim_Node *node)
+{
+    double at = node->writeAt;
+
+    node->writePending = 0;
+    node->writeAt = SIM_NEVER;
+
+    if (node->writeRetime == SYNCLOCK_RETIME_NEXT)
+    {
+        // Enabling the interrupt of a trigger that has gone since the read runs it now
+        if (node->lastTriggerAt <= node->readDone)
+        {
+            node->armed = 1;
+            node->armedCcr0 = node->writeCcr0;
+            return;
+        }
+    }
+
+    if ((at >= node->epoch) && (Sim_Timer(node, at) >= node->writeCcr0))
+    {
+        // Up mode would count on to 0xFFFF, the guard is too short
+        node->badWrites++;
+        node->epoch += 65536.0 * node->tickUs;
+    }
+    node->ccr0 = node->writeCcr0;
+    node->nextTrigger = node->epoch + (node->ccr0 * node->tickUs);
+}
+
+static void Sim_Line(const Sim_Config *config, unsigned char level, double at)
+{
+    unsigned index;
+
+    simLine = level;
+    for (index = 1; index < config->nodes; index++)
+    {
+        Sim_Node *node = &simNodes[index];
+
+        if (!node->running || node->readPending || (level != !node->expectFall))
+        {
+            continue;
+        }
+        node->readPending = 1;
+        node->readAt = at + Sim_Latency(node, SYNC_SLAVE_CYCLES, config->jitter);
+    }
+}
+
+/*
+ * Runs the whole timeline, event by event.
+ */
+static void Sim_Run(const Sim_Config *config)
+{
+    uint16_t period = (uint16_t)(ADC_TIMER_HZ / config->slotHz);
+    double endUs = config->seconds * 1.0e6;
+    double joinUs = config->joinAt * 1.0e6;
+    double gapUs = config->gapAt * 1.0e6;
+    double restartUs = gapUs + (config->gapLength * 1.0e6);
+    double glitchUs = config->glitchAt * 1.0e6;
+    unsigned char joined = 0;
+    unsigned char stopped = 0;
+    unsigned char restarted = 0;
+    unsigned char glitched = 0;
+    unsigned index;
+
+    for (index = 0; index < config->nodes; index++)
+    {
+        double ppm = 0.0;
+
+        if ((index > 0) && (config->nodes > 2))
+        {
+            ppm = config->ppm * (-1.0 + ((2.0 * (index - 1)) / (config->nodes - 2)));
+        }
+        else if (index > 0)
+        {
+            ppm = config->ppm;
+        }
+        Sim_Init_Node(&simNodes[index], index == 0, ppm, period);
+    }
+
+    Sim_Start_Timer(&simNodes[0], 0.0, period);
+    for (index = 1; index < config->nodes; index++)
+    {
+        if ((index < config->nodes - 1) || (config->nodes == 2))
+        {
+            Sim_Join(&simNodes[index], 0.0, period);
+        }
+    }
+    if (config->nodes == 2)
+    {
+        joined = 1;
+    }
+
+    while (1)
+    {
+        double next = endUs;
+        int kind = -1;
+        unsigned which = 0;
+
+        // Scripted events first, then the earliest of the rest
+        if (!joined && (joinUs < next)) { next = joinUs; kind = 0; }
+        if (!stopped && (gapUs < next)) { next = gapUs; kind = 1; }
+        if (stopped && !restarted && (restartUs < next)) { next = restartUs; kind = 2; }
+        if (!glitched && (glitchUs < next)) { next = glitchUs; kind = 3; }
+
+        for (index = 0; index < simEdgeCount; index++)
+        {
+            if (simEdges[index].at < next)
+            {
+                next = simEdges[index].at;
+                kind = 4;
+                which = index;
+            }
+        }
+
+        for (index = 0; index < config->nodes; index++)
+        {
+            Sim_Node *node = &simNodes[index];
+
+            if (node->running && (node->nextTrigger < next))
+            {
+                next = node->nextTrigger; kind = 5; which = index;
+            }
+            if (node->converting && (node->convertEnd < next))
+            {
+                next = node->convertEnd; kind = 6; which = index;
+            }
+            if (node->readPending && (node->readAt < next))
+            {
+                next = node->readAt; kind = 7; which = index;
+            }
+            if (node->writePending && (node->writeAt < next))
+            {
+                next = node->writeAt; kind = 8; which = index;
+            }
+        }
+
+        if (kind < 0)
+        {
+            break;
+        }
+
+        switch (kind)
+        {
+            case 0:
+                joined = 1;
+                Sim_Join(&simNodes[config->nodes - 1], next, period);
+                break;
+            case 1:
+                // Stop_Scan(), a stop mid pulse leaves the line where it is
+                stopped = 1;
+                simNodes[0].running = 0;
+                Sim_Upset(config, next);
+                break;
+            case 2:
+                // Start_Scan(), Sync_Start() drops the line
+                restarted = 1;
+                simEdgeCount = 0;
+                if (simLine)
+                {
+                    Sim_Line(config, 0, next);
+                }
+                Sim_Start_Timer(&simNodes[0], next, period);
+                Synclock_Master_Rate(&simNodes[0].sync, period);
+                Sim_Upset(config, next);
+                break;
+            case 3:
+                glitched = 1;
+                Sim_Add_Edge(next, 1);
+                Sim_Add_Edge(next + (config->glitchLength * 1.0e6), 0);
+                Sim_Upset(config, next);
+                break;
+            case 4:
+                Sim_Line(config, simEdges[which].level, next);
+                simEdges[which] = simEdges[--simEdgeCount];
+                break;
+            case 5:
+                Sim_Trigger(config, &simNodes[which]);
+                break;
+            case 6:
+                Sim_Frame_Done(&simNodes[which]);
+                break;
+            case 7:
+                // ADC12ISR goes first, it has the higher priority
+                if (simNodes[which].isrEnd > next)
+                {
+                    simNodes[which].readAt = simNodes[which].isrEnd;
+                    break;
+                }
+                Sim_Read(config, &simNodes[which]);
+                break;
+            default:
+                Sim_Write(&simNodes[which]);
+                break;
+        }
+    }
+}
+
+/*
+ * A board's stream, decoded to one entry per WIRE_TYPE_SYNC_SCAN
+ * record: the tag, and the samples held the way the firmware holds
+ * them between slots.
+ */
+typedef struct
+{
+    Synclock_Tag tag;
+    uint16_t sample[SCAN_CHANNELS];
+} Sim_Record;
+
+static size_t Sim_Decode(const uint8_t *data, size_t length, Sim_Record **records)
+{
+    Wire_Decoder decoder;
+    uint16_t held[SCAN_CHANNELS] = {0};
+    size_t count = 0;
+    size_t capacity = 0;
+    size_t i;
+
+    *records = NULL;
+    Wire_Decoder_Reset(&decoder);
+
+    for (i = 0; i < length; i++)
+    {
+        uint16_t mask;
+        uint8_t offset = SCAN_SYNC_BYTES + 7;
+        unsigned channel;
+
+        if ((Wire_Decode_Byte(&decoder, data[i]) != 1) ||
+            (decoder.type != WIRE_TYPE_SYNC_SCAN) ||
+            (decoder.length < SCAN_SYNC_BYTES + 7))
+        {
+            continue;
+        }
+
+        mask = Wire_Get_U16(&decoder.payload[SCAN_SYNC_BYTES + 4]);
+        for (channel = 0; channel < SCAN_CHANNELS; channel++)
+        {
+            if ((mask & (1U << channel)) && (offset + 2 <= decoder.length))
+            {
+                held[channel] = Wire_Get_U16(&decoder.payload[offset]);
+                offset += 2;
+            }
+        }
+
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            *records = realloc(*records, capacity * sizeof(Sim_Record));
+        }
+        (*records)[count].tag.node = decoder.payload[0];
+        (*records)[count].tag.flags = decoder.payload[1];
+        (*records)[count].tag.count = Wire_Get_U32(&decoder.payload[2]);
+        (*records)[count].tag.skew = (int16_t)Wire_Get_U16(&decoder.payload[6]);
+        memcpy((*records)[count].sample, held, sizeof(held));
+        count++;
+    }
+
+    return count;
+}
+
+/*
+ * Merges boards' records by count: rows[count * boards + board] is
+ * that board's valid record for the count, or NULL.
+ */
+static const Sim_Record **Sim_Merge(Sim_Record **records, const size_t *counts,
+                                    unsigned boards, uint32_t *first, uint32_t *rows)
+{
+    const Sim_Record **merged;
+    uint32_t low = 0xFFFFFFFFUL;
+    uint32_t high = 0;
+    unsigned board;
+    size_t i;
+
+    for (board = 0; board < boards; board++)
+    {
+        for (i = 0; i < counts[board]; i++)
+        {
+            if (records[board][i].tag.flags & SYNCLOCK_VALID)
+            {
+                if (records[board][i].tag.count < low) low = records[board][i].tag.count;
+                if (records[board][i].tag.count > high) high = records[board][i].tag.count;
+            }
+        }
+    }
+
+    if (low > high)
+    {
+        *first = 0;
+        *rows = 0;
+        return NULL;
+    }
+
+    *first = low;
+    *rows = high - low + 1;
+    merged = calloc((size_t)*rows * boards, sizeof(*merged));
+    for (board = 0; board < boards; board++)
+    {
+        for (i = 0; i < counts[board]; i++)
+        {
+            const Sim_Record *record = &records[board][i];
+
+            if (record->tag.flags & SYNCLOCK_VALID)
+            {
+                merged[((size_t)(record->tag.count - low) * boards) + board] = record;
+            }
+        }
+    }
+
+    return merged;
+}
+
+static int Sim_Merge_Files(int files, char **names)
+{
+    Sim_Record *records[SIM_MAX_NODES];
+    size_t counts[SIM_MAX_NODES];
+    const Sim_Record **merged;
+    uint32_t first;
+    uint32_t rows;
+    uint32_t row;
+    int board;
+
+    if ((files < 1) || (files > SIM_MAX_NODES))
+    {
+        fprintf(stderr, "syncsim: 1 to %d files to merge\n", SIM_MAX_NODES);
+        return 2;
+    }
+
+    for (board = 0; board < files; board++)
+    {
+        FILE *file = fopen(names[board], "rb");
+        uint8_t *data = NULL;
+        size_t length = 0;
+        size_t capacity = 0;
+        uint8_t chunk[4096];
+        size_t got;
+
+        if (file == NULL)
+        {
+            fprintf(stderr, "syncsim: can't open %s\n", names[board]);
+            return 2;
+        }
+        while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        {
+            Sim_Append(&data, &length, &capacity, chunk, got);
+        }
+        fclose(file);
+        counts[board] = Sim_Decode(data, length, &records[board]);
+        free(data);
+    }
+
+    merged = Sim_Merge(records, counts, (unsigned)files, &first, &rows);
+
+    printf("count");
+    for (board = 0; board < files; board++)
+    {
+        int channel;
+
+        printf(",b%d_node,b%d_skew", board, board);
+        for (channel = 0; channel < SCAN_CHANNELS; channel++)
+        {
+            printf(",b%d_ch%d", board, channel);
+        }
+    }
+    printf("\n");
+
+    for (row = 0; row < rows; row++)
+    {
+        printf("%lu", (unsigned long)(first + row));
+        for (board = 0; board < files; board++)
+        {
+            const Sim_Record *record = merged[((size_t)row * files) + board];
+            int channel;
+
+            if (record == NULL)
+            {
+                printf(",,");
+                for (channel = 0; channel < SCAN_CHANNELS; channel++)
+                {
+                    printf(",");
+                }
+                continue;
+            }
+
+            printf(",%u,", record->tag.node);
+            if (record->tag.skew != SYNCLOCK_NO_SKEW)
+            {
+                printf("%d", record->tag.skew);
+            }
+            for (channel = 0; channel < SCAN_CHANNELS; channel++)
+            {
+                printf(",%u", record->sample[channel]);
+            }
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    Sim_Config config = { 1000, 4, 20000.0, 8, 5.0, 1.0, 2.5, 0.05, 3.7, 10.0e-6 };
+    double skewLimit = -1.0;
+    double errorLimit = -1.0;
+    double jitterUs;
+    Sim_Record *records[SIM_MAX_NODES];
+    size_t counts[SIM_MAX_NODES];
+    const Sim_Record **merged;
+    uint32_t first;
+    uint32_t rows;
+    uint32_t row;
+    uint32_t complete = 0;
+    double spread = 0.0;
+    int failures = 0;
+    unsigned index;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "-m") == 0)
+        {
+            return Sim_Merge_Files(argc - arg - 1, &argv[arg + 1]);
+        }
+        else if ((strcmp(argv[arg], "-n") == 0) && (arg + 1 < argc))
+        {
+            config.nodes = (unsigned)strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-r") == 0) && (arg + 1 < argc))
+        {
+            config.slotHz = (uint16_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-p") == 0) && (arg + 1 < argc))
+        {
+            config.ppm = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-j") == 0) && (arg + 1 < argc))
+        {
+            config.jitter = (unsigned)strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-t") == 0) && (arg + 1 < argc))
+        {
+            config.seconds = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-s") == 0) && (arg + 1 < argc))
+        {
+            skewLimit = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-e") == 0) && (arg + 1 < argc))
+        {
+            errorLimit = strtod(argv[++arg], NULL);
+        }
+        else
+        {
+            fprintf(stderr, "usage: syncsim [-n nodes] [-r slot Hz] [-p ppm] [-j cycles] "
+                            "[-t s] [-s skew us] [-e error ticks]\n"
+                            "       syncsim -m board0.bin board1.bin ...\n");
+            return 2;
+        }
+    }
+
+    if ((config.nodes < 2) || (config.nodes > SIM_MAX_NODES) ||
+        (config.slotHz == 0) || (config.slotHz > (ADC_TIMER_HZ / 16)) ||
+        (fabs(config.ppm) >= 1.0e6 / 16.0) || (config.seconds < 1.0))
+    {
+        fprintf(stderr, "syncsim: bad configuration\n");
+        return 2;
+    }
+
+    /*
+     * Jitter lands on both ends of every edge, the read the retime
+     * comes from and the period estimate, so the limits grow with it
+     * in time, and more so on slower clocks.
+     */
+    jitterUs = (config.jitter * 1.0e6) / SCHED_MCLK_HZ;
+    if (skewLimit < 0.0)
+    {
+        skewLimit = 3.0 + (4.0 * jitterUs);
+    }
+    if (errorLimit < 0.0)
+    {
+        errorLimit = 2.0 + ((3.0 * jitterUs * ADC_TIMER_HZ) / 1.0e6);
+    }
+
+    // Upsets spread over the run
+    config.joinAt = config.seconds * 0.2;
+    config.gapAt = config.seconds * 0.5;
+    config.glitchAt = config.seconds * 0.74;
+
+    // All 16 channels' conversions at the default sample/hold, and ADC12ISR
+    simConvertUs = (SCAN_CHANNELS * (16.0 + SCHED_CONVERT_CLOCKS) * 1.0e6) /
+                   SCHED_ADC_CLOCK_HZ;
+    simIsrUs = (SCHED_ISR_BASE_CYCLES * 1.0e6) / SCHED_MCLK_HZ;
+
+    printf("profile %s, %u nodes at %u Hz, slaves within %+.0f ppm, %u cycles jitter, %.3g s\n",
+           CLOCK_NAME, config.nodes, config.slotHz, config.ppm, config.jitter,
+           config.seconds);
+    printf("latency %u ticks, lead %u, guard %u; node %u joins at %.3g s, "
+           "master stops %.3g s at %.3g s, glitch at %.3g s\n",
+           SYNC_LATENCY_TICKS, SYNC_LEAD_TICKS, SYNC_GUARD_TICKS, config.nodes - 1,
+           config.joinAt, config.gapLength, config.gapAt, config.glitchAt);
+    printf("limits %.3g us skew, %.3g ticks error\n", skewLimit, errorLimit);
+
+    Sim_Run(&config);
+
+    printf("\n  %-4s %9s %7s %7s %10s %9s %9s %6s %6s %6s\n", "node", "ppm", "frames",
+           "valid", "lock slots", "skew us", "error tk", "wrong", "slips", "losses");
+
+    for (index = 0; index < config.nodes; index++)
+    {
+        Sim_Node *node = &simNodes[index];
+        double slotUs = 1.0e6 / config.slotHz;
+        double worstSkew = 0.0;
+        double worstError = 0.0;
+        unsigned long valid = 0;
+        unsigned long wrong = 0;
+        size_t i;
+
+        for (i = 0; i < node->frameCount; i++)
+        {
+            const Sim_Frame *frame = &node->frames[i];
+            double skew;
+
+            if (!(frame->tag.flags & SYNCLOCK_VALID))
+            {
+                continue;
+            }
+            valid++;
+
+            if ((frame->tag.count >= simMasterCount) ||
+                (fabs(frame->trigger - simMasterAt[frame->tag.count]) > (slotUs / 2)))
+            {
+                wrong++;
+                continue;
+            }
+
+            skew = frame->trigger - simMasterAt[frame->tag.count];
+            if (fabs(skew) > worstSkew)
+            {
+                worstSkew = fabs(skew);
+            }
+            if ((frame->tag.flags & SYNCLOCK_EDGE) && !node->master)
+            {
+                double error = fabs((frame->tag.skew * node->tickUs) - skew) / node->tickUs;
+
+                if (error > worstError)
+                {
+                    worstError = error;
+                }
+            }
+        }
+
+        if (node->master)
+        {
+            printf("  %-4u %9s %7lu %7lu %10s %9s %9s %6s %6s %6s\n", index, "master",
+                   (unsigned long)node->frameCount, valid, "", "", "", "", "", "");
+            continue;
+        }
+
+        printf("  %-4u %+9.0f %7lu %7lu %10.0f %9.2f %9.2f %6lu %6u %6u",
+               index, node->ppm, (unsigned long)node->frameCount, valid,
+               ((node->lockedAt == SIM_NEVER) ? (config.seconds * 1.0e6) : node->worstLock) /
+               slotUs, worstSkew, worstError, wrong, node->slave.slips,
+               node->slave.losses);
+
+        if ((node->lockedAt == SIM_NEVER) ||
+            (node->worstLock > (SIM_LOCK_SLOTS * slotUs)) || wrong ||
+            (worstSkew > skewLimit) || (worstError > errorLimit) || node->badWrites)
+        {
+            printf("  FAIL");
+            failures++;
+        }
+        if (node->badWrites)
+        {
+            printf("  %u late CCR0 write(s)", node->badWrites);
+        }
+        printf("\n");
+    }
+
+    // What the host sees: the streams, merged by count
+    for (index = 0; index < config.nodes; index++)
+    {
+        counts[index] = Sim_Decode(simNodes[index].stream, simNodes[index].length,
+                                   &records[index]);
+    }
+    merged = Sim_Merge(records, counts, config.nodes, &first, &rows);
+
+    for (row = 0; row < rows; row++)
+    {
+        uint16_t low = 0xFFFF;
+        uint16_t high = 0;
+
+        for (index = 0; index < config.nodes; index++)
+        {
+            const Sim_Record *record = merged[((size_t)row * config.nodes) + index];
+
+            if (record == NULL)
+            {
+                break;
+            }
+            if (record->sample[0] < low) low = record->sample[0];
+            if (record->sample[0] > high) high = record->sample[0];
+        }
+        if (index == config.nodes)
+        {
+            complete++;
+            if ((high - low) > spread)
+            {
+                spread = high - low;
+            }
+        }
+    }
+
+    printf("\n  merged %lu rows from count %lu, %lu with every node, "
+           "widest spread %.0f LSB on a %.0f Hz signal\n",
+           (unsigned long)rows, (unsigned long)first, (unsigned long)complete, spread,
+           SIM_SIGNAL_HZ);
+    printf("  (%.1f LSB per us of skew at the steepest)\n",
+           SIM_SIGNAL_SWING * 2.0 * M_PI * SIM_SIGNAL_HZ / 1.0e6);
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,260 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Data link over eUSCI_A1 UART on MSP430FR6989.
+ *
+ * eUSCI_A1 is wired to the eZ-FET backchannel UART on the LaunchPad
+ * (P3.4 TXD, P3.5 RXD), so it shows up as a COM port on the host at
+ * 115200 8N1. Records are framed by the wire suite and queued in a
+ * ring buffer that the TX interrupt drains. Link_Send() never blocks;
+ * it refuses a record that doesn't fit.
+ *
+ * Received bytes are moved into a ring by DMA channel 1 rather than an
+ * RX interrupt: a byte arrives every 87 us, and on the slower clock
+ * profiles ADC12ISR holds off other interrupts for longer than that. The
+ * DMA never misses a byte while the CPU is busy. ADC12ISR wakes main()
+ * when bytes are waiting and Link_Receive() decodes them there. The
+ * host must wait for each command's reply before sending the next, so
+ * the ring never laps.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#include <driverlib.h>
+#include "link.h"
+#include "wire.h"
+#include "clock.h"
+
+static uint8_t txBuffer[LINK_TX_BUFFER];
+static volatile uint16_t txHead = 0;
+static volatile uint16_t txTail = 0;
+static volatile unsigned char wakeOnDrain = 0;
+static volatile uint32_t txCount = 0;
+static uint8_t rxBuffer[LINK_RX_BUFFER];
+static uint16_t rxTail = 0;
+static Wire_Decoder rxDecoder;
+
+void Init_Link()
+{
+    /* Backchannel UART pins - Port P3
+     * Table 6-26 in Reference 1.
+     */
+    GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_P3,
+        GPIO_PIN4 + GPIO_PIN5,
+        GPIO_PRIMARY_MODULE_FUNCTION
+        );
+
+    /*
+     * Base address of eUSCI_A1
+     * SMCLK, 115200 baud
+     * UCBRx, UCBRFx, UCBRSx and UCOS16 from the clock profile, see
+     * clock.h
+     */
+    EUSCI_A_UART_initParam param = {0};
+    param.selectClockSource = EUSCI_A_UART_CLOCKSOURCE_SMCLK;
+    param.clockPrescalar = CLOCK_UART_PRESCALER;
+    param.firstModReg = CLOCK_UART_FIRST_MOD;
+    param.secondModReg = CLOCK_UART_SECOND_MOD;
+    param.parity = EUSCI_A_UART_NO_PARITY;
+    param.msborLsbFirst = EUSCI_A_UART_LSB_FIRST;
+    param.numberofStopBits = EUSCI_A_UART_ONE_STOP_BIT;
+    param.uartMode = EUSCI_A_UART_MODE;
+    param.overSampling = CLOCK_UART_OVERSAMPLING ?
+        EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION :
+        EUSCI_A_UART_LOW_FREQUENCY_BAUDRATE_GENERATION;
+    EUSCI_A_UART_init(EUSCI_A1_BASE, &param);
+
+    EUSCI_A_UART_enable(EUSCI_A1_BASE);
+
+    /*
+     * DMA channel 1
+     * One byte per UCA1RXIFG (trigger 16, see the DMA trigger
+     * assignments in Reference 1), from UCA1RXBUF to the next byte of
+     * rxBuffer. Repeated mode reloads the size and destination at the
+     * end of the buffer, so it is a ring with DMA1SZ counting down to
+     * the write position. No interrupt.
+     */
+    DMA_initParam dmaParam = {0};
+    dmaParam.channelSelect = DMA_CHANNEL_1;
+    dmaParam.transferModeSelect = DMA_TRANSFER_REPEATED_SINGLE;
+    dmaParam.transferSize = LINK_RX_BUFFER;
+    dmaParam.triggerSourceSelect = DMA_TRIGGERSOURCE_16;
+    dmaParam.transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE;
+    dmaParam.triggerTypeSelect = DMA_TRIGGER_RISINGEDGE;
+    DMA_init(&dmaParam);
+
+    DMA_setSrcAddress(DMA_CHANNEL_1,
+        EUSCI_A_UART_getReceiveBufferAddress(EUSCI_A1_BASE),
+        DMA_DIRECTION_UNCHANGED);
+    DMA_setDstAddress(DMA_CHANNEL_1,
+        (uint32_t)(uintptr_t)rxBuffer,
+        DMA_DIRECTION_INCREMENT);
+    DMA_enableTransfers(DMA_CHANNEL_1);
+
+    rxTail = 0;
+    Wire_Decoder_Reset(&rxDecoder);
+}
+
+/*
+ * Where the DMA writes the next received byte.
+ */
+static uint16_t Link_Rx_Head(void)
+{
+    return (LINK_RX_BUFFER - DMA_getTransferSize(DMA_CHANNEL_1)) &
+           (LINK_RX_BUFFER - 1);
+}
+
+/*
+ * Queues one framed record. Returns 1 if queued, 0 if there was no
+ * room, in which case nothing was written. Safe to call from ISRs.
+ */
+unsigned char Link_Send(uint8_t type, const uint8_t *payload, uint8_t length)
+{
+    uint8_t record[WIRE_MAX_PAYLOAD + WIRE_OVERHEAD];
+    uint16_t size;
+    uint16_t used;
+    uint16_t i;
+    uint16_t state;
+
+    if (length > WIRE_MAX_PAYLOAD)
+    {
+        return 0;
+    }
+
+    size = Wire_Encode(record, type, payload, length);
+
+    state = __get_interrupt_state();
+    __disable_interrupt();
+
+    used = (txHead - txTail) & (LINK_TX_BUFFER - 1);
+    if (size > (LINK_TX_BUFFER - 1 - used))
+    {
+        __set_interrupt_state(state);
+        return 0;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        txBuffer[txHead] = record[i];
+        txHead = (txHead + 1) & (LINK_TX_BUFFER - 1);
+    }
+
+    // TX IFG is already set while idle, so this kicks off the ISR
+    EUSCI_A_UART_enableInterrupt(EUSCI_A1_BASE,
+        EUSCI_A_UART_TRANSMIT_INTERRUPT);
+
+    __set_interrupt_state(state);
+    return 1;
+}
+
+/*
+ * Ask the TX ISR to wake main() out of LPM0 once the ring is empty.
+ */
+void Link_Wake_On_Drain()
+{
+    wakeOnDrain = 1;
+}
+
+/*
+ * 1 once everything queued has left the UART, 0 while the ring still
+ * holds bytes. With the ring empty this waits out the character in
+ * the shift register, one character time at most.
+ */
+unsigned char Link_Tx_Idle()
+{
+    if (txHead != txTail)
+    {
+        return 0;
+    }
+
+    while (EUSCI_A_UART_queryStatusFlags(EUSCI_A1_BASE, EUSCI_A_UART_BUSY))
+    {
+    }
+    return 1;
+}
+
+/*
+ * Bytes handed to the UART since boot, for the duty suite to cost
+ * the TX interrupts with.
+ */
+uint32_t Link_Tx_Count()
+{
+    uint16_t state = __get_interrupt_state();
+    uint32_t count;
+
+    __disable_interrupt();
+    count = txCount;
+    __set_interrupt_state(state);
+
+    return count;
+}
+
+/*
+ * 1 when received bytes are waiting for Link_Receive(). Cheap enough
+ * for ADC12ISR to ask every slot.
+ */
+unsigned char Link_Receive_Pending()
+{
+    return Link_Rx_Head() != rxTail;
+}
+
+/*
+ * Decodes received bytes until a complete record turns up. Returns the
+ * decoder holding it, valid until the next call, or 0 once the ring is
+ * empty. Corrupt records are skipped. Call from main() only.
+ */
+const Wire_Decoder *Link_Receive()
+{
+    uint16_t head = Link_Rx_Head();
+
+    while (rxTail != head)
+    {
+        uint8_t byte = rxBuffer[rxTail];
+
+        rxTail = (rxTail + 1) & (LINK_RX_BUFFER - 1);
+        if (Wire_Decode_Byte(&rxDecoder, byte) > 0)
+        {
+            return &rxDecoder;
+        }
+    }
+
+    return 0;
+}
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=USCI_A1_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(USCI_A1_VECTOR)))
+#endif
+void USCI_A1_ISR (void)
+{
+    switch (__even_in_range(UCA1IV, USCI_UART_UCTXCPTIFG)){
+        case USCI_NONE: break;
+        case USCI_UART_UCRXIFG: break;
+        case USCI_UART_UCTXIFG:
+            if (txHead != txTail)
+            {
+                EUSCI_A_UART_transmitData(EUSCI_A1_BASE, txBuffer[txTail]);
+                txTail = (txTail + 1) & (LINK_TX_BUFFER - 1);
+                txCount++;
+            }
+            else
+            {
+                EUSCI_A_UART_disableInterrupt(EUSCI_A1_BASE,
+                    EUSCI_A_UART_TRANSMIT_INTERRUPT);
+                if (wakeOnDrain)
+                {
+                    wakeOnDrain = 0;
+                    __bic_SR_register_on_exit(LPM0_bits);
+                }
+            }
+            break;
+        default: break;
+    }
+}
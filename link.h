@@ -0,0 +1,37 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Data link over eUSCI_A1 UART on MSP430FR6989.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#ifndef AI_SCANNER_LINK_H_
+#define AI_SCANNER_LINK_H_
+
+#include <stdint.h>
+#include "wire.h"
+
+// Must be powers of 2
+#define LINK_TX_BUFFER  256
+#define LINK_RX_BUFFER  128
+#define LINK_SRAM_BYTES (LINK_TX_BUFFER + LINK_RX_BUFFER + \
+                         sizeof(Wire_Decoder) + 12)
+
+// MCLK cycles USCI_A1_ISR spends on each byte it sends, a model figure
+#define LINK_TX_ISR_CYCLES  40
+
+void Init_Link(void);
+unsigned char Link_Send(uint8_t type, const uint8_t *payload, uint8_t length);
+void Link_Wake_On_Drain(void);
+unsigned char Link_Tx_Idle(void);
+uint32_t Link_Tx_Count(void);
+unsigned char Link_Receive_Pending(void);
+const Wire_Decoder *Link_Receive(void);
+
+#endif /* AI_SCANNER_LINK_H_ */
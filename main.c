@@ -28,29 +28,37 @@
 #include <driverlib.h>
 #include "hal_LCD.h"
 #include "adc.h"
+#include "persist.h"
+#include "timestamp.h"
+#include "scan.h"
+#include "link.h"
+#include "capture.h"
+#include "sched.h"
+#include "control.h"
+#include "burst.h"
+#include "filter.h"
+#include "command.h"
+#include "health.h"
+#include "clock.h"
+#include "duty.h"
+#include "sync.h"
+#include "rbe.h"
 
-#define Num_of_Results  8
 #define STARTUP_MODE    0
 #define MSP6989_CONF    1
 
-volatile uint16_t A0results[Num_of_Results];
-volatile uint16_t A1results[Num_of_Results];
-volatile uint16_t A2results[Num_of_Results];
-volatile uint16_t A3results[Num_of_Results];
-volatile uint16_t A4results[Num_of_Results];
-volatile uint16_t A5results[Num_of_Results];
-volatile uint16_t A6results[Num_of_Results];
-volatile uint16_t A7results[Num_of_Results];
-volatile uint16_t A8results[Num_of_Results];
-volatile uint16_t A9results[Num_of_Results];
-volatile uint16_t A10results[Num_of_Results];
-volatile uint16_t A11results[Num_of_Results];
-volatile uint16_t A12results[Num_of_Results];
-volatile uint16_t A13results[Num_of_Results];
-volatile uint16_t A14results[Num_of_Results];
-volatile uint16_t A15results[Num_of_Results];
 volatile unsigned char mode = STARTUP_MODE;
 volatile unsigned char conf = MSP6989_CONF;
+volatile unsigned char firstSamplePending = 1;
+Scan_Frame scanFrame;
+volatile uint16_t scanOverruns = 0;
+
+static void Start_Scan(void);
+static void Show_Boot_Time(void);
+static void Service_Commands(void);
+static unsigned char Scan_Slot_Complete(void);
+static unsigned char Scan_Slot_Tail(unsigned char wake, uint16_t mask,
+                                    uint16_t nextMask, uint32_t start);
 
 void main (void)
 {
@@ -60,11 +68,62 @@ void main (void)
      */
     WDT_A_hold(WDT_A_BASE);
 
+    /*
+     * Farmed out to clock suite.
+     * Before anything that derives a rate from SMCLK.
+     */
+    Init_Clock();
+
+    /*
+     * Start the boot clock as early as possible so time-to-first-sample
+     * covers the whole init chain.
+     */
+    Init_Timestamp();
+
+    /*
+     * Warm boot when the FRAM-persisted state is intact, resuming the
+     * saved config and buffer position. Cold boot otherwise.
+     */
+    if (Persist_Select_Boot(Num_of_Results) == BOOT_WARM)
+    {
+        conf = acqConfig.conf;
+        mode = acqConfig.mode;
+    }
+
     /*
      * Farmed out to adc suite.
      */
     Init_GPIO_For_ADC12_B_All_AI();
 
+    /*
+     * Farmed out to link suite.
+     */
+    Init_Link();
+
+    /*
+     * Farmed out to control suite.
+     * Loops start on their first scan, see controlConfig.
+     */
+    Init_Control();
+
+    /*
+     * Farmed out to health suite.
+     */
+    Init_Health();
+
+    /*
+     * Farmed out to duty suite.
+     * Off unless dutyConfig says otherwise. The boot scan is then the
+     * first burst.
+     */
+    Init_Duty();
+
+    /*
+     * Farmed out to sync suite.
+     * Off unless syncConfig says otherwise. Sets up the sync line.
+     */
+    Init_Sync();
+
     /*
      * Disable the GPIO power-on default high-impedance mode to activate
      * previously configured port settings.
@@ -77,45 +136,215 @@ void main (void)
     Init_LCD();
     GPIO_clearInterrupt(GPIO_PORT_P1, GPIO_PIN1);
     GPIO_clearInterrupt(GPIO_PORT_P1, GPIO_PIN2);
+    // S1 arms a raw frame capture, S2 a burst, P1.1/P1.2 are only free on the LaunchPad
+    if (conf == 1)
+    {
+        Init_Capture_Button();
+        Init_Burst_Button();
+    }
     __enable_interrupt();
-    displayScrollText("WELCOME TO THE AI SCANNER");
+    if (Persist_Boot_Type() == BOOT_COLD)
+    {
+        displayScrollText("WELCOME TO THE AI SCANNER");
+    }
+
+    /*
+     * Farmed out to sched suite.
+     * A schedule saved over the link wins over the default. Only
+     * rebuilds a slot table if the config changed.
+     */
+    if (Sched_Load(Persist_Load_Settings(&schedDefaultConfig)) != SCHED_OK)
+    {
+        Sched_Load(&schedDefaultConfig);
+    }
+
+    Start_Scan();
 
+    /*
+     * Everything is running, so this config is now good to resume from.
+     */
+    Persist_Save_Config(conf, mode);
+
+    // Enter LPM0, Enable interrupts, ADC12ISR wakes us on the first sample
+    __bis_SR_register(LPM0_bits + GIE);
+    Show_Boot_Time();
+
+    while (1)
+    {
+        /*
+         * Farmed out to duty suite.
+         * LPM0, or LPM3 between duty cycle bursts. Interrupts stay off
+         * from the decision to the sleep, so no wake slips in between.
+         */
+        __disable_interrupt();
+        __bis_SR_register(Duty_Sleep_Bits() + GIE);
+        // For debugger
+        __no_operation();
+        Duty_Wake();
+
+        /*
+         * Woken by a full capture, a drained link, a burst, a command,
+         * a health reading or the duty timer
+         */
+        if (Burst_Service())
+        {
+            // Filter history is from before the gap
+            Filter_Reset();
+            if (Duty_Scan_Wanted())
+            {
+                Start_Scan();
+            }
+        }
+        Capture_Service();
+        Service_Commands();
+        Health_Service();
+        if (Duty_Service())
+        {
+            Start_Scan();
+        }
+    }
+}
+
+/*
+ * Starts the timer-paced scan from the first slot of the active
+ * schedule, at boot and again after a burst.
+ */
+static void Start_Scan()
+{
     /*
      * Farmed out to adc suite.
      */
     Init_Enable_ADC12_B();
 
+    schedSlot = 0;
+
+    /*
+     * Farmed out to rbe suite.
+     * After a burst or duty cycle gap the host's copy is stale.
+     */
+    Rbe_Reset();
+
     /*
      * Farmed out to adc suite.
      */
-    Config_Mem_Buffers();
+    Config_Sample_Hold(schedActive->config.sampleHold[0],
+                       schedActive->config.sampleHold[1]);
+    Config_Mem_Buffers_For_Slot(schedActive->mask[0]);
 
-    //Enable memory buffer 3 interrupt
-    ADC12_B_clearInterrupt(ADC12_B_BASE,
-        0,
-        ADC12_B_IFG3
-        );
+    /*
+     * Farmed out to health suite.
+     */
+    Health_Set_Rate(schedActive->config.slotHz);
 
-    //Enable memory buffer 0 interrupt
+    //Enable overflow and timing overflow interrupts to count overruns
     ADC12_B_enableInterrupt(ADC12_B_BASE,
-      ADC12_B_IE3,
       0,
-      0);
+      0,
+      ADC12_B_OVIE + ADC12_B_TOVIE);
 
     // Enable/Start first sampling and conversion cycle
     /*
      * Base address of ADC12B Module
      * Start the conversion into memory buffer 0
-     * Use the repeated sequence of channels
+     * Use a single sequence of channels, started by TA0.1 each slot and
+     * re-armed by ADC12ISR at the end of it
      */
     ADC12_B_startConversion(ADC12_B_BASE,
         ADC12_B_MEMORY_0,
-        ADC12_B_REPEATED_SEQOFCHANNELS);
+        ADC12_B_SEQOFCHANNELS);
 
-    // Enter LPM0, Enable interrupts
-    __bis_SR_register(LPM0_bits + GIE);
-    // For debugger
-    __no_operation();
+    /*
+     * Farmed out to adc suite.
+     */
+    Init_Scan_Timer(schedActive->config.slotHz);
+
+    /*
+     * Farmed out to control suite.
+     * The timer starts over, and after a gap so does the timestamp's
+     * idea of where the triggers are.
+     */
+    Control_Restart();
+
+    /*
+     * Farmed out to sync suite.
+     */
+    Sync_Start();
+}
+
+/*
+ * Runs received commands through the command suite and sends back its
+ * replies. A committed schedule is reported, and saved if asked, only
+ * once ADC12ISR has switched over to it.
+ */
+static void Service_Commands()
+{
+    const Wire_Decoder *record;
+    uint8_t reply[COMMAND_REPORT_BYTES];
+    unsigned char save;
+    uint8_t length;
+
+    while ((record = Link_Receive()) != 0)
+    {
+        length = Command_Handle(record, reply);
+        if (length)
+        {
+            Link_Send(WIRE_TYPE_COMMAND_ACK, reply, length);
+        }
+    }
+
+    while ((length = Command_Report(reply, &save)) != 0)
+    {
+        if (save)
+        {
+            Persist_Save_Settings(&schedActive->config);
+        }
+        Link_Send(WIRE_TYPE_SCHED_CONFIG, reply, length);
+    }
+}
+
+/*
+ * Shows time-to-first-sample on the LCD as "C" or "W" for cold or warm
+ * boot followed by milliseconds, e.g. "W   42". The same numbers are
+ * kept in bootStats for the debugger.
+ */
+static void Show_Boot_Time()
+{
+    uint32_t ticks;
+    uint32_t ms;
+    char text[6];
+    int i;
+
+    if (Persist_Boot_Type() == BOOT_WARM)
+    {
+        ticks = bootStats.lastWarmBootTicks;
+        text[0] = 'W';
+    }
+    else
+    {
+        ticks = bootStats.lastColdBootTicks;
+        text[0] = 'C';
+    }
+
+    // In two steps, past a couple of seconds ticks times 1000 overflows 32 bits
+    ms = ((ticks / TIMESTAMP_HZ) * 1000UL) +
+         (((ticks % TIMESTAMP_HZ) * 1000UL) / TIMESTAMP_HZ);
+    if (ms > 99999UL)
+    {
+        ms = 99999UL;
+    }
+
+    for (i = 5; i > 0; i--)
+    {
+        text[i] = ((i < 5) && (ms == 0)) ? ' ' : (char)('0' + (ms % 10));
+        ms /= 10;
+    }
+
+    showChar(text[0], pos1);
+    showChar(text[1], pos2);
+    showChar(text[2], pos3);
+    showChar(text[3], pos4);
+    showChar(text[4], pos5);
+    showChar(text[5], pos6);
 }
 
 #if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
@@ -126,97 +355,197 @@ __attribute__((interrupt(ADC12_VECTOR)))
 #endif
 void ADC12ISR (void)
 {
-    static uint16_t index = 0;
-
-    switch (__even_in_range(ADC12IV,34)){
-        case  0: break;   //Vector  0:  No interrupt
-        case  2: break;   //Vector  2:  ADC overflow
-        case  4: break;   //Vector  4:  ADC timing overflow
-        case  6: break;   //Vector  6:  ADC12IFG0
-        case  8: break;   //Vector  8:  ADC12IFG1
-        case 10: break;   //Vector 10:  ADC12IFG2
-        case 12:          //Vector 12:  ADC12IFG3
-            //Move A0 results, IFG is cleared
-            A0results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_0);
-            //Move A1 results, IFG is cleared
-            A1results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_1);
-            //Move A2 results, IFG is cleared
-            A2results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_2);
-            //Move A3 results, IFG is cleared
-            A3results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_3);
-            //Move A4 results, IFG is cleared
-            A4results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_4);
-            //Move A5 results, IFG is cleared
-            A5results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_5);
-            //Move A6 results, IFG is cleared
-            A6results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_6);
-            //Move A7 results, IFG is cleared
-            A7results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_7);
-            //Move A8 results, IFG is cleared
-            A8results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_8);
-            //Move A9 results, IFG is cleared
-            A9results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_9);
-            //Move A10 results, IFG is cleared
-            A10results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_10);
-            //Move A11 results, IFG is cleared
-            A11results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_11);
-            //Move A12 results, IFG is cleared
-            A12results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_12);
-            //Move A13 results, IFG is cleared
-            A13results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_13);
-            //Move A14 results, IFG is cleared
-            A14results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_14);
-            //Move A15 results, IFG is cleared
-            A15results[index] =
-                ADC12_B_getResults(ADC12_B_BASE,
-                    ADC12_B_MEMORY_15);
-            //Increment results index, modulo; Set BREAKPOINT here
-            index++;
-
-            if (index == 8){
-                (index = 0);
+    switch (__even_in_range(ADC12IV, ADC12IV__ADC12RDYIFG)){
+        case ADC12IV__NONE: break;          // No interrupt
+        case ADC12IV__ADC12OVIFG:           // ADC overflow
+        case ADC12IV__ADC12TOVIFG:          // ADC timing overflow
+            if (burstState == BURST_RUNNING)
+            {
+                // A result the DMA didn't get to in time, a gap
+                burstOverflows++;
+            }
+            else
+            {
+                // A slot was triggered before the last one finished
+                scanOverruns++;
+            }
+            break;
+        case ADC12IV__ADC12HIIFG: break;    // Window comparator high
+        case ADC12IV__ADC12LOIFG: break;    // Window comparator low
+        case ADC12IV__ADC12INIFG: break;    // Window comparator in
+        case ADC12IV__ADC12RDYIFG: break;   // Reference ready
+        case ADC12IV__ADC12IFG31:           // Health reading, see health.c
+            if (Health_Complete())
+            {
+                __bic_SR_register_on_exit(LPM0_bits);
             }
-        case 14: break;   //Vector 14:  ADC12IFG4
-        case 16: break;   //Vector 16:  ADC12IFG5
-        case 18: break;   //Vector 18:  ADC12IFG6
-        case 20: break;   //Vector 20:  ADC12IFG7
-        case 22: break;   //Vector 22:  ADC12IFG8
-        case 24: break;   //Vector 24:  ADC12IFG9
-        case 26: break;   //Vector 26:  ADC12IFG10
-        case 28: break;   //Vector 28:  ADC12IFG11
-        case 30: break;   //Vector 30:  ADC12IFG12
-        case 32: break;   //Vector 32:  ADC12IFG13
-        case 34: break;   //Vector 34:  ADC12IFG14
-        default: break;
+            break;
+        default:                            // ADC12IFG0-15
+            // Only the last buffer of each slot has its interrupt enabled
+            if (Scan_Slot_Complete())
+            {
+                __bic_SR_register_on_exit(LPM0_bits);
+            }
+            break;
+    }
+}
+
+/*
+ * End of a scan slot. Moves the slot's results into the frame, sets up
+ * the ADC for the next slot and runs the frame down the pipeline.
+ * Channels not in this slot keep their last value in scanFrame.
+ * Returns 1 when main() should be woken.
+ */
+static unsigned char Scan_Slot_Complete(void)
+{
+    uint32_t start = Timestamp_Now();
+    uint16_t mask = schedActive->mask[schedSlot];
+    uint8_t classMask = schedActive->classMask[schedSlot];
+    uint16_t slotHz = schedActive->config.slotHz;
+    unsigned char wake = 0;
+    unsigned char swapped;
+    uint16_t nextMask;
+    uint16_t memory = 0;
+    uint16_t channel;
+
+    //Move results, IFG is cleared
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        if (mask & ((uint16_t)1 << channel))
+        {
+            scanFrame.sample[channel] =
+                HWREG16(ADC12_B_BASE + OFS_ADC12MEM0 + (2 * memory));
+            memory++;
+        }
+    }
+    HWREG16(ADC12_B_BASE + OFS_ADC12IFGR0) = 0;
+
+    /*
+     * Control loops first, nothing of variable length ahead of them.
+     * Empty slots too, it keeps track of which trigger each slot is on.
+     */
+    scanFrame.channelMask = mask;
+    Control_Run(&scanFrame);
+
+    /*
+     * Farmed out to sync suite.
+     * Every slot's trigger counts, so before the empty ones drop out.
+     */
+    Sync_Slot_Done(&scanFrame.sync);
+
+    /*
+     * A schedule committed over the link takes over here, between two
+     * slots, so this slot's frame is all old config and the next one
+     * all new. Otherwise reprogram only when the next slot converts
+     * something different. Either way the sequence is re-armed for the
+     * next trigger.
+     */
+    swapped = Sched_Advance();
+    nextMask = schedActive->mask[schedSlot];
+    if (swapped)
+    {
+        // New period first, so no trigger lands mid reprogram
+        if (schedActive->config.slotHz != slotHz)
+        {
+            Retime_Scan_Timer(schedActive->config.slotHz);
+            Health_Set_Rate(schedActive->config.slotHz);
+            Sync_Set_Rate();
+            Control_Restart();
+        }
+        Config_Sample_Hold(schedActive->config.sampleHold[0],
+                           schedActive->config.sampleHold[1]);
+        Config_Mem_Buffers_For_Slot(nextMask);
+        wake = 1;
+    }
+    else if (nextMask != mask)
+    {
+        Config_Mem_Buffers_For_Slot(nextMask);
+    }
+    else
+    {
+        Rearm_Scan_Sequence();
+    }
+    Control_Slot_Armed();
+
+    // Bytes from the host for the command suite
+    if (Link_Receive_Pending())
+    {
+        wake = 1;
+    }
+
+    // Filler conversion in an empty slot, nothing to process
+    if (mask == 0)
+    {
+        if (swapped)
+        {
+            Filter_Reset();
+            Rbe_Reset();
+        }
+        return Scan_Slot_Tail(wake, mask, nextMask, start);
+    }
+
+    scanFrame.sequence = acqCursor.scanCount;
+    scanFrame.flags = 0;
+    scanFrame.classMask = classMask;
+
+    // Raw frame goes to capture before any processing
+    if (Capture_Raw_Frame(&scanFrame))
+    {
+        wake = 1;
+    }
+
+    Scan_Process_Frame(&scanFrame);
+
+    /*
+     * Filter history is at the old rates, from the next frame on, and
+     * the host gets every channel again under the new schedule.
+     */
+    if (swapped)
+    {
+        Filter_Reset();
+        Rbe_Reset();
+    }
+
+    if (firstSamplePending)
+    {
+        firstSamplePending = 0;
+        Persist_Record_First_Sample(Timestamp_Now());
+        wake = 1;
     }
+
+    return Scan_Slot_Tail(wake, mask, nextMask, start);
+}
+
+/*
+ * Last thing in every slot. Ends a duty cycle burst after its last
+ * slot, otherwise takes a health reading if one is due, which needs
+ * to know how long until the next trigger.
+ */
+static unsigned char Scan_Slot_Tail(unsigned char wake, uint16_t mask,
+                                    uint16_t nextMask, uint32_t start)
+{
+    // What the slot took since ADC12ISR started on it, in MCLK cycles
+    uint32_t cycles = ((Timestamp_Now() - start) * SCHED_CYCLES_PER_TICK_Q8) >> 8;
+
+    /*
+     * Farmed out to sched suite, before anything below goes by the
+     * model.
+     */
+    Sched_Record_Cycles(mask, nextMask, cycles);
+
+    /*
+     * Farmed out to duty suite.
+     */
+    if ((dutyState == DUTY_SCANNING) &&
+        Duty_Slot_Done(cycles, Sched_Slot_Adc_Clocks(&schedActive->config, mask)))
+    {
+        return 1;
+    }
+
+    /*
+     * Farmed out to health suite.
+     */
+    Health_Slot_Done();
+
+    return wake;
 }
@@ -0,0 +1,51 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * SRAM budget check for the MSP430FR6989.
+ *
+ * Nothing here ends up in the image. Each subsystem's worst case SRAM
+ * use is summed at compile time and the build fails if the stack would
+ * be left with less than MEM_STACK_MIN_BYTES. Add new subsystems here
+ * when they put buffers in SRAM.
+ *
+ */
+
+#include <stdint.h>
+#include "memory.h"
+#include "scan.h"
+#include "link.h"
+#include "capture.h"
+#include "filter.h"
+#include "control.h"
+#include "burst.h"
+#include "command.h"
+#include "comp.h"
+#include "health.h"
+#include "duty.h"
+#include "sync.h"
+#include "rbe.h"
+#include "sched.h"
+
+/*
+ * Scalars in main, timestamp and persist, plus driverlib and the RTS.
+ */
+#define MEM_MISC_SRAM_BYTES     64
+
+#define MEM_SRAM_USED_BYTES     (SCAN_SRAM_BYTES + \
+                                 LINK_SRAM_BYTES + \
+                                 CAPTURE_SRAM_BYTES + \
+                                 FILTER_SRAM_BYTES + \
+                                 CONTROL_SRAM_BYTES + \
+                                 BURST_SRAM_BYTES + \
+                                 COMMAND_SRAM_BYTES + \
+                                 COMP_SRAM_BYTES + \
+                                 HEALTH_SRAM_BYTES + \
+                                 DUTY_SRAM_BYTES + \
+                                 SYNC_SRAM_BYTES + \
+                                 RBE_SRAM_BYTES + \
+                                 SCHED_SRAM_BYTES + \
+                                 MEM_MISC_SRAM_BYTES)
+
+MEM_BUDGET_CHECK(MEM_SRAM_USED_BYTES <= (MEM_SRAM_BYTES - MEM_STACK_MIN_BYTES),
+                 sram_leaves_too_little_stack);
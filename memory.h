@@ -0,0 +1,73 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Memory placement and SRAM budget for the MSP430FR6989.
+ *
+ * The FR6989 has 2 KB of SRAM at 0x1C00-0x23FF and 128 KB of FRAM.
+ * The rule for this project is:
+ *
+ *  - Bulk buffers (result rings, captures, burst buffers, filter
+ *    tables, logs) go in FRAM with MEM_FRAM(). They land in the
+ *    toolchain's persistent section (.TI.persistent for CCS,
+ *    .persistent for msp430-elf-gcc) which the stock linker files
+ *    already place in FRAM, so no project linker changes are needed.
+ *    Like any persistent variable they need an initializer and are
+ *    only initialized when the device is programmed.
+ *  - Hot state that every ADC12ISR touches (the frame being built,
+ *    filter state, link ring buffer) stays in SRAM, the default.
+ *
+ * FRAM reads above 8 MHz MCLK take wait states, softened by a small
+ * read cache that holds a few consecutive words. Lay bulk buffers out
+ * so the hot path walks them sequentially, a whole row of words at a
+ * time, rather than striding across them.
+ *
+ * Every module with SRAM buffers publishes its worst case as
+ * <MODULE>_SRAM_BYTES; memory.c fails the build if they leave less
+ * than MEM_STACK_MIN_BYTES for the stack. tools/mem_report.py does the
+ * same from the linker map after the build, per object file, from
+ * what the linker actually placed in SRAM.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 5 - MSP430 Optimizing C/C++ Compiler User's Guide (SLAU132)
+ * 6 - MSP430 FRAM Technology - How To and Best Practices (SLAA628)
+ *
+ */
+
+#ifndef AI_SCANNER_MEMORY_H_
+#define AI_SCANNER_MEMORY_H_
+
+#define MEM_SRAM_BYTES          2048
+#define MEM_STACK_MIN_BYTES     512
+
+/*
+ * FRAM wait states needed for a given MCLK, 0 up to 8 MHz.
+ * Recommended operating conditions in Reference 1.
+ */
+#define MEM_FRAM_WAIT_STATES(mclkHz)    (((mclkHz) > 8000000UL) ? 1 : 0)
+
+/*
+ * Place the following definition in FRAM, e.g.
+ *   MEM_FRAM(buffer)
+ *   uint16_t buffer[1024] = {0};
+ * Expands to nothing for the host tools.
+ */
+#if defined(__TI_COMPILER_VERSION__)
+#define MEM_PRAGMA(x)           _Pragma(#x)
+#define MEM_FRAM(sym)           MEM_PRAGMA(PERSISTENT(sym))
+#elif defined(__IAR_SYSTEMS_ICC__)
+#define MEM_FRAM(sym)           __persistent
+#elif defined(__GNUC__) && defined(__MSP430__)
+#define MEM_FRAM(sym)           __attribute__((persistent))
+#else
+#define MEM_FRAM(sym)
+#endif
+
+/*
+ * Compile-time check that works on every compiler in play here.
+ */
+#define MEM_BUDGET_CHECK(cond, name) \
+    typedef char mem_budget_##name[(cond) ? 1 : -1]
+
+#endif /* AI_SCANNER_MEMORY_H_ */
@@ -0,0 +1,143 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * FRAM-persisted acquisition state for warm restarts on MSP430FR6989.
+ *
+ * Variables here live in FRAM and are NOT re-initialized by the C
+ * startup code on reset, only when the device is reprogrammed. After
+ * a watchdog or brownout reset main() can validate them and resume
+ * scanning at the same buffer position without re-running the whole
+ * cold init chain.
+ *
+ * If the MPU is enabled in the project settings, the persistent
+ * section must be left writable.
+ *
+ * The saved schedule and the record checksum are in
+ * persist_settings.c, which the host tools share.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 5 - MSP430 Optimizing C/C++ Compiler User's Guide (SLAU132)
+ *
+ */
+
+#include <driverlib.h>
+#include <stddef.h>
+#include "persist.h"
+#include "memory.h"
+
+MEM_FRAM(acqConfig)
+Acq_Config acqConfig = {0};
+
+MEM_FRAM(acqCursor)
+Acq_Cursor acqCursor = {0};
+
+MEM_FRAM(bootStats)
+Boot_Stats bootStats = {0};
+
+static unsigned char bootType = BOOT_COLD;
+
+/*
+ * Reads (and thereby clears) every pending reset cause and returns
+ * the highest priority one.
+ * Section 1.15 in Reference 3.
+ */
+static uint16_t Persist_Read_Reset_Cause(void)
+{
+    uint16_t cause = SYSRSTIV;
+    uint16_t next = cause;
+
+    while (next != SYSRSTIV_NONE)
+    {
+        next = SYSRSTIV;
+    }
+
+    return cause;
+}
+
+unsigned char Persist_Select_Boot(uint16_t numResults)
+{
+    bootStats.lastResetCause = Persist_Read_Reset_Cause();
+
+    bootType = BOOT_WARM;
+
+    if ((acqConfig.magic != PERSIST_MAGIC) ||
+        (acqConfig.version != PERSIST_VERSION) ||
+        (acqConfig.checksum !=
+         Persist_Checksum(&acqConfig, offsetof(Acq_Config, checksum))))
+    {
+        bootType = BOOT_COLD;
+    }
+
+    if (acqCursor.resultIndex >= numResults)
+    {
+        bootType = BOOT_COLD;
+    }
+
+    /*
+     * Something in the warm path keeps resetting us before the
+     * first sample arrives, so take the long way round instead.
+     */
+    if (bootStats.warmTries >= PERSIST_MAX_WARM_TRIES)
+    {
+        bootType = BOOT_COLD;
+    }
+
+    if (bootType == BOOT_WARM)
+    {
+        bootStats.warmTries++;
+    }
+    else
+    {
+        /*
+         * Invalidate until the cold init chain completes, so a reset
+         * half way through cold boot doesn't resume a stale config.
+         */
+        acqConfig.magic = 0;
+        acqCursor.resultIndex = 0;
+        acqCursor.scanCount = 0;
+        bootStats.warmTries = 0;
+    }
+
+    return bootType;
+}
+
+void Persist_Save_Config(unsigned char conf, unsigned char mode)
+{
+    Acq_Config config = {0};
+    config.magic = PERSIST_MAGIC;
+    config.version = PERSIST_VERSION;
+    config.conf = conf;
+    config.mode = mode;
+    config.checksum = Persist_Checksum(&config, offsetof(Acq_Config, checksum));
+
+    // Magic goes last, the copy in FRAM only becomes valid once complete
+    acqConfig.magic = 0;
+    acqConfig.version = config.version;
+    acqConfig.conf = config.conf;
+    acqConfig.mode = config.mode;
+    acqConfig.checksum = config.checksum;
+    acqConfig.magic = config.magic;
+}
+
+void Persist_Record_First_Sample(uint32_t ticks)
+{
+    if (bootType == BOOT_WARM)
+    {
+        bootStats.lastWarmBootTicks = ticks;
+        bootStats.warmBoots++;
+    }
+    else
+    {
+        bootStats.lastColdBootTicks = ticks;
+        bootStats.coldBoots++;
+    }
+    bootStats.warmTries = 0;
+}
+
+unsigned char Persist_Boot_Type()
+{
+    return bootType;
+}
@@ -0,0 +1,94 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * FRAM-persisted acquisition state for warm restarts on MSP430FR6989.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 5 - MSP430 Optimizing C/C++ Compiler User's Guide (SLAU132)
+ *
+ */
+
+#ifndef AI_SCANNER_PERSIST_H_
+#define AI_SCANNER_PERSIST_H_
+
+#include <stdint.h>
+#include "sched.h"
+
+#define PERSIST_MAGIC           0x5044  /* "PD" */
+#define PERSIST_VERSION         1
+#define PERSIST_SETTINGS_MAGIC  0x5053  /* "PS" */
+#define PERSIST_SETTINGS_VERSION 1
+
+/*
+ * Give up on warm boots after this many resets in a row that never
+ * reached the first sample, and fall back to a full cold boot.
+ */
+#define PERSIST_MAX_WARM_TRIES  3
+
+#define BOOT_COLD               0
+#define BOOT_WARM               1
+
+/*
+ * Active acquisition configuration. Only valid when magic, version
+ * and checksum all match. The checksum must stay the last member.
+ */
+typedef struct
+{
+    uint16_t magic;
+    uint16_t version;
+    unsigned char conf;
+    unsigned char mode;
+    uint16_t checksum;
+} Acq_Config;
+
+/*
+ * Scan schedule saved by a COMMIT over the link, used at boot in place
+ * of schedDefaultConfig. Same validity rules as Acq_Config.
+ */
+typedef struct
+{
+    uint16_t magic;
+    uint16_t version;
+    Sched_Config sched;
+    uint16_t checksum;
+} Acq_Settings;
+
+/*
+ * Ring-buffer and log cursors, written by the ADC ISR as it goes.
+ */
+typedef struct
+{
+    uint16_t resultIndex;
+    uint32_t scanCount;
+} Acq_Cursor;
+
+/*
+ * Time-to-first-sample bookkeeping, in Timestamp ticks since reset.
+ */
+typedef struct
+{
+    uint32_t lastColdBootTicks;
+    uint32_t lastWarmBootTicks;
+    uint16_t coldBoots;
+    uint16_t warmBoots;
+    uint16_t warmTries;
+    uint16_t lastResetCause;
+} Boot_Stats;
+
+extern Acq_Config acqConfig;
+extern Acq_Settings acqSettings;
+extern Acq_Cursor acqCursor;
+extern Boot_Stats bootStats;
+
+uint16_t Persist_Checksum(const void *record, uint16_t length);
+unsigned char Persist_Select_Boot(uint16_t numResults);
+void Persist_Save_Config(unsigned char conf, unsigned char mode);
+void Persist_Save_Settings(const Sched_Config *sched);
+const Sched_Config *Persist_Load_Settings(const Sched_Config *fallback);
+void Persist_Record_First_Sample(uint32_t ticks);
+unsigned char Persist_Boot_Type(void);
+
+#endif /* AI_SCANNER_PERSIST_H_ */
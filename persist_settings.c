@@ -0,0 +1,69 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * FRAM-persisted scan schedule, saved by a COMMIT over the link and
+ * loaded at boot, and the record checksum shared with persist.c.
+ *
+ * Portable, shared with the host tools, so host/schedsim.c can check
+ * that a saved schedule loads back.
+ *
+ */
+
+#include <stddef.h>
+#include "persist.h"
+#include "memory.h"
+
+MEM_FRAM(acqSettings)
+Acq_Settings acqSettings = {0};
+
+/*
+ * Fletcher-16 over every byte of a record that precedes its checksum.
+ */
+uint16_t Persist_Checksum(const void *record, uint16_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)record;
+    uint16_t sum1 = 0;
+    uint16_t sum2 = 0;
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        sum1 = (sum1 + bytes[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+
+    return (sum2 << 8) | sum1;
+}
+
+void Persist_Save_Settings(const Sched_Config *sched)
+{
+    Acq_Settings settings = {0};
+    settings.magic = PERSIST_SETTINGS_MAGIC;
+    settings.version = PERSIST_SETTINGS_VERSION;
+    settings.sched = *sched;
+    settings.checksum = Persist_Checksum(&settings, offsetof(Acq_Settings, checksum));
+
+    // Magic goes last, like the config
+    acqSettings.magic = 0;
+    acqSettings.version = settings.version;
+    acqSettings.sched = settings.sched;
+    acqSettings.checksum = settings.checksum;
+    acqSettings.magic = settings.magic;
+}
+
+/*
+ * The saved schedule if there is a good one, fallback otherwise.
+ */
+const Sched_Config *Persist_Load_Settings(const Sched_Config *fallback)
+{
+    if ((acqSettings.magic != PERSIST_SETTINGS_MAGIC) ||
+        (acqSettings.version != PERSIST_SETTINGS_VERSION) ||
+        (acqSettings.checksum !=
+         Persist_Checksum(&acqSettings, offsetof(Acq_Settings, checksum))))
+    {
+        return fallback;
+    }
+
+    return &acqSettings.sched;
+}
@@ -0,0 +1,113 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Fixed-point PID controller.
+ *
+ * Runs on integers only, so a loop update is a handful of 16 x 16
+ * multiplies on the MSP430 hardware multiplier. The derivative acts
+ * on the measurement, not the error, so setpoint steps don't kick the
+ * output.
+ *
+ * Anti-windup is by conditional integration: while the output is
+ * pinned at a limit the integral stops accumulating in that direction,
+ * so it comes off the limit as soon as the error changes sign.
+ *
+ * Bumpless transfer: Pid_Set_Auto() seeds the integral so the first
+ * automatic update, on the same input, repeats the last manual
+ * output. Call it again after changing gains or setpoint on a running
+ * loop to retune without a bump.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#include "pid.h"
+
+static int32_t Pid_Clamp(int32_t value, int32_t low, int32_t high)
+{
+    if (value < low)
+    {
+        return low;
+    }
+    if (value > high)
+    {
+        return high;
+    }
+    return value;
+}
+
+/*
+ * One loop update. input and setpoint are ADC LSB, the result is in
+ * output counts between outMin and outMax. In manual mode the manual
+ * output is held and only the input is tracked.
+ */
+uint16_t Pid_Update(const Pid_Config *config, Pid_State *state, uint16_t input)
+{
+    int32_t low = (int32_t)config->outMin << PID_SHIFT;
+    int32_t high = (int32_t)config->outMax << PID_SHIFT;
+    int32_t error = (int32_t)config->setpoint - input;
+    int32_t step;
+    int32_t integral;
+    int32_t output;
+
+    if (state->mode != PID_AUTO)
+    {
+        state->lastInput = input;
+        return state->output;
+    }
+
+    step = config->ki * error;
+    integral = state->integral + step;
+    output = (config->kp * error) + integral -
+             (config->kd * ((int32_t)input - state->lastInput));
+
+    state->saturated = 0;
+    if (output > high)
+    {
+        output = high;
+        state->saturated = 1;
+        if (step > 0)
+        {
+            integral = state->integral;
+        }
+    }
+    else if (output < low)
+    {
+        output = low;
+        state->saturated = 1;
+        if (step < 0)
+        {
+            integral = state->integral;
+        }
+    }
+
+    // Wide enough for any bumpless seed, and keeps the sum in range
+    state->integral = Pid_Clamp(integral, low - (high - low),
+                                high + (high - low));
+    state->lastInput = input;
+    state->output = (uint16_t)((output + (1 << (PID_SHIFT - 1))) >> PID_SHIFT);
+
+    return state->output;
+}
+
+void Pid_Set_Manual(Pid_State *state, uint16_t output)
+{
+    state->mode = PID_MANUAL;
+    state->output = output;
+}
+
+/*
+ * Switches to automatic, picking up from the current output.
+ */
+void Pid_Set_Auto(const Pid_Config *config, Pid_State *state, uint16_t input)
+{
+    int32_t error = (int32_t)config->setpoint - input;
+
+    // Less this update's integral step too, so the next output is unchanged
+    state->integral = ((int32_t)state->output << PID_SHIFT) -
+                      (config->kp * error) - (config->ki * error);
+    state->lastInput = input;
+    state->saturated = 0;
+    state->mode = PID_AUTO;
+}
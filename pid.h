@@ -0,0 +1,50 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Fixed-point PID controller.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#ifndef AI_SCANNER_PID_H_
+#define AI_SCANNER_PID_H_
+
+#include <stdint.h>
+
+/*
+ * Gains are Q8, in output counts per ADC LSB: kp = 256 moves the output
+ * one count per LSB of error. ki and kd are per run of the loop, so
+ * they scale with the rate of the loop's input channel. Negative gains
+ * make a reverse acting loop.
+ */
+#define PID_SHIFT   8
+
+#define PID_MANUAL  0
+#define PID_AUTO    1
+
+typedef struct
+{
+    uint16_t setpoint;
+    int16_t kp;
+    int16_t ki;
+    int16_t kd;
+    uint16_t outMin;
+    uint16_t outMax;
+} Pid_Config;
+
+typedef struct
+{
+    int32_t integral;
+    uint16_t lastInput;
+    uint16_t output;
+    uint8_t mode;
+    uint8_t saturated;
+} Pid_State;
+
+uint16_t Pid_Update(const Pid_Config *config, Pid_State *state, uint16_t input);
+void Pid_Set_Manual(Pid_State *state, uint16_t output);
+void Pid_Set_Auto(const Pid_Config *config, Pid_State *state, uint16_t input);
+
+#endif /* AI_SCANNER_PID_H_ */
@@ -0,0 +1,135 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Report by exception, a stage of the scan pipeline.
+ *
+ * Runs after the store stage, so the results ring still gets every
+ * sample, and ahead of the emit stage. Each converted channel is
+ * compared with the value last reported for it; the ones that moved
+ * past their deadband, are due a heartbeat or were never reported go
+ * in changedMask and the frame is sent as a WIRE_TYPE_RBE_SCAN with
+ * only those. A frame with nothing to report isn't sent at all.
+ *
+ * A value only counts as reported once the link has taken the record,
+ * see Rbe_Commit(). If the link is full the channels stay due and go
+ * with the next frame, so the host never falls out of the deadband
+ * for good. Rbe_Reset() starts every channel over, whenever the scan
+ * restarts or the schedule changes.
+ *
+ * The host keeps the last value of every channel and applies each
+ * record to it, which gives back the full state to within each
+ * channel's deadband, see host/replay.c. A channel quiet for longer
+ * than its heartbeat means the link lost something.
+ *
+ * Frames tagged by the sync suite still go out whole, the host merges
+ * those by count.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#include "rbe.h"
+#include "memory.h"
+
+/*
+ * Off until set up for a site. Lives in FRAM so the setting survives
+ * resets.
+ */
+MEM_FRAM(rbeConfig)
+Rbe_Config rbeConfig = { 0, {{0}} };
+
+Rbe_State rbeState;
+
+/*
+ * Every channel is reported with its next conversion. Call with
+ * ADC12ISR not running, or from it.
+ */
+void Rbe_Reset()
+{
+    uint16_t channel;
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        rbeState.age[channel] = 0;
+    }
+    rbeState.primed = 0;
+}
+
+void Rbe_Stage(Scan_Frame *frame)
+{
+    uint16_t pending = frame->channelMask;
+    uint16_t changed = 0;
+    uint16_t bit = 1;
+    uint16_t channel;
+
+    // Switched back on, the host's copy is from before
+    if (!rbeConfig.enabled)
+    {
+        rbeState.primed = 0;
+        return;
+    }
+    if (frame->sync.flags)
+    {
+        return;
+    }
+
+    rbeState.frames++;
+
+    for (channel = 0; pending != 0; channel++, pending >>= 1, bit <<= 1)
+    {
+        const Rbe_Channel_Config *config = &rbeConfig.channel[channel];
+        uint16_t sample = frame->sample[channel];
+        uint16_t last = rbeState.last[channel];
+        uint16_t moved;
+
+        if (!(pending & 1))
+        {
+            continue;
+        }
+
+        rbeState.samples++;
+        moved = (sample > last) ? (sample - last) : (last - sample);
+        rbeState.age[channel]++;
+
+        if ((moved > config->deadband) || !(rbeState.primed & bit) ||
+            (config->heartbeat && (rbeState.age[channel] >= config->heartbeat)))
+        {
+            changed |= bit;
+        }
+    }
+
+    frame->changedMask = changed;
+
+    if (changed)
+    {
+        frame->flags |= SCAN_FRAME_RBE;
+    }
+    else
+    {
+        frame->flags |= SCAN_FRAME_DROP;
+    }
+}
+
+/*
+ * From the emit stage once the link has taken the frame's
+ * WIRE_TYPE_RBE_SCAN, so the host now holds its changed channels.
+ */
+void Rbe_Commit(const Scan_Frame *frame)
+{
+    uint16_t pending = frame->changedMask;
+    uint16_t channel;
+
+    for (channel = 0; pending != 0; channel++, pending >>= 1)
+    {
+        if (!(pending & 1))
+        {
+            continue;
+        }
+        rbeState.last[channel] = frame->sample[channel];
+        rbeState.age[channel] = 0;
+        rbeState.reported++;
+    }
+
+    rbeState.primed |= frame->changedMask;
+}
@@ -0,0 +1,65 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Report by exception, a stage of the scan pipeline.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#ifndef AI_SCANNER_RBE_H_
+#define AI_SCANNER_RBE_H_
+
+#include <stdint.h>
+#include "scan.h"
+
+/*
+ * A channel is reported when it has moved more than deadband LSB from
+ * the value last reported for it, or when heartbeat of its own
+ * conversions have gone by without a report. deadband 0 reports any
+ * change, heartbeat 0 never forces one.
+ */
+typedef struct
+{
+    uint16_t deadband;
+    uint16_t heartbeat;
+} Rbe_Channel_Config;
+
+/*
+ * enabled 0 sends every converted channel of every frame, as without
+ * the rbe suite.
+ */
+typedef struct
+{
+    uint8_t enabled;
+    Rbe_Channel_Config channel[SCAN_CHANNELS];
+} Rbe_Config;
+
+/*
+ * What the host holds for each channel, plus the counts that say how
+ * much the link was spared.
+ */
+typedef struct
+{
+    uint16_t last[SCAN_CHANNELS];
+    uint16_t age[SCAN_CHANNELS];    /* conversions since the last report */
+    uint16_t primed;                /* channels reported at least once   */
+    uint32_t frames;
+    uint32_t samples;               /* converted channels compared       */
+    uint32_t reported;
+} Rbe_State;
+
+// Ahead of the samples in a WIRE_TYPE_RBE_SCAN record
+#define RBE_HEADER_BYTES    6
+
+#define RBE_SRAM_BYTES      (sizeof(Rbe_State))
+
+extern Rbe_Config rbeConfig;
+extern Rbe_State rbeState;
+
+void Rbe_Reset(void);
+void Rbe_Stage(Scan_Frame *frame);
+void Rbe_Commit(const Scan_Frame *frame);
+
+#endif /* AI_SCANNER_RBE_H_ */
@@ -0,0 +1,141 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Scan frame processing pipeline, downstream of ADC12ISR.
+ *
+ * ADC12ISR gathers one frame per completed sequence and hands it to
+ * Scan_Process_Frame(), which runs it through scanStages[] in order.
+ * New processing goes in as another stage in that table so the host
+ * replay driver picks it up, and times it, without any changes.
+ *
+ */
+
+#include "scan.h"
+#include "persist.h"
+#include "memory.h"
+#include "link.h"
+#include "wire.h"
+#include "filter.h"
+#include "comp.h"
+#include "rbe.h"
+
+MEM_FRAM(AIresults)
+volatile uint16_t AIresults[Num_of_Results][SCAN_CHANNELS] = {{0}};
+
+// Frames the link had no room for
+volatile uint16_t scanEmitDrops = 0;
+
+/*
+ * Stores the frame as the next row of the result ring and advances the
+ * FRAM-persisted cursor.
+ */
+static void Scan_Store_Stage(Scan_Frame *frame)
+{
+    uint16_t index = acqCursor.resultIndex;
+    volatile uint16_t *row = AIresults[index];
+    uint16_t channel;
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        row[channel] = frame->sample[channel];
+    }
+
+    //Increment results index, modulo; Set BREAKPOINT here
+    index++;
+
+    if (index == Num_of_Results){
+        (index = 0);
+    }
+
+    // Cursors live in FRAM so a warm boot resumes from here
+    acqCursor.resultIndex = index;
+    acqCursor.scanCount++;
+}
+
+/*
+ * Sends the frame on the link as a rate-class tagged WIRE_TYPE_SCAN
+ * record carrying only the channels converted in this slot. Frames
+ * tagged by the sync suite go as WIRE_TYPE_SYNC_SCAN, the same record
+ * behind the tag, and frames the rbe stage passed as a
+ * WIRE_TYPE_RBE_SCAN with just the channels that changed.
+ */
+static void Scan_Emit_Stage(Scan_Frame *frame)
+{
+    uint8_t payload[SCAN_SYNC_BYTES + 7 + (2 * SCAN_CHANNELS)];
+    uint8_t type = WIRE_TYPE_SCAN;
+    uint16_t mask = frame->channelMask;
+    uint8_t length = 0;
+    uint16_t channel;
+
+    if (frame->flags & SCAN_FRAME_RBE)
+    {
+        mask = frame->changedMask;
+        Wire_Put_U32(&payload[0], frame->sequence);
+        Wire_Put_U16(&payload[4], mask);
+        type = WIRE_TYPE_RBE_SCAN;
+        length = RBE_HEADER_BYTES;
+    }
+    else
+    {
+        if (frame->sync.flags)
+        {
+            payload[0] = frame->sync.node;
+            payload[1] = frame->sync.flags;
+            Wire_Put_U32(&payload[2], frame->sync.count);
+            Wire_Put_U16(&payload[6], (uint16_t)frame->sync.skew);
+            type = WIRE_TYPE_SYNC_SCAN;
+            length = SCAN_SYNC_BYTES;
+        }
+
+        Wire_Put_U32(&payload[length], frame->sequence);
+        Wire_Put_U16(&payload[length + 4], mask);
+        payload[length + 6] = frame->classMask;
+        length += 7;
+    }
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        if (mask & ((uint16_t)1 << channel))
+        {
+            Wire_Put_U16(&payload[length], frame->sample[channel]);
+            length += 2;
+        }
+    }
+
+    if (!Link_Send(type, payload, length))
+    {
+        scanEmitDrops++;
+    }
+    else if (type == WIRE_TYPE_RBE_SCAN)
+    {
+        Rbe_Commit(frame);
+    }
+}
+
+const Scan_Stage scanStages[] =
+{
+    { "comp", Comp_Stage },
+#if FILTER_ANY
+    { "filter", Filter_Stage },
+#endif
+    { "store", Scan_Store_Stage },
+    { "rbe", Rbe_Stage },
+    { "emit", Scan_Emit_Stage },
+};
+
+const uint16_t scanStageCount = sizeof(scanStages) / sizeof(scanStages[0]);
+
+void Scan_Process_Frame(Scan_Frame *frame)
+{
+    uint16_t stage;
+
+    for (stage = 0; stage < scanStageCount; stage++)
+    {
+        if (frame->flags & SCAN_FRAME_DROP)
+        {
+            break;
+        }
+        scanStages[stage].run(frame);
+    }
+}
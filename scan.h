@@ -0,0 +1,77 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Scan frame processing pipeline, downstream of ADC12ISR.
+ *
+ * Nothing in here touches hardware, so the same code builds for the
+ * MSP430FR6989 and for the host replay driver in host/replay.c.
+ *
+ */
+
+#ifndef AI_SCANNER_SCAN_H_
+#define AI_SCANNER_SCAN_H_
+
+#include <stdint.h>
+#include "synclock.h"
+
+#define SCAN_CHANNELS   16
+#define Num_of_Results  8
+
+/*
+ * Frame flags. A stage sets SCAN_FRAME_DROP to stop the rest of the
+ * pipeline from seeing the frame. SCAN_FRAME_RBE has it sent with
+ * only the channels in changedMask, see rbe.h.
+ */
+#define SCAN_FRAME_DROP 0x0001
+#define SCAN_FRAME_RBE  0x0002
+
+/*
+ * channelMask marks the channels converted in this frame's scan slot,
+ * classMask the rate classes they belong to. The other samples hold
+ * their last value. sync is the shared slot count between boards,
+ * flags 0 without the sync suite, see synclock.h. changedMask is set
+ * by the rbe stage, along with SCAN_FRAME_RBE.
+ */
+typedef struct
+{
+    uint32_t sequence;
+    uint16_t flags;
+    uint16_t channelMask;
+    uint16_t changedMask;
+    uint8_t classMask;
+    uint16_t sample[SCAN_CHANNELS];
+    Synclock_Tag sync;
+} Scan_Frame;
+
+// Ahead of the WIRE_TYPE_SCAN payload in a WIRE_TYPE_SYNC_SCAN record
+#define SCAN_SYNC_BYTES 8
+
+typedef void (*Scan_Stage_Fn)(Scan_Frame *frame);
+
+typedef struct
+{
+    const char *name;
+    Scan_Stage_Fn run;
+} Scan_Stage;
+
+// The frame ADC12ISR builds, in SRAM
+#define SCAN_SRAM_BYTES (sizeof(Scan_Frame))
+
+extern const Scan_Stage scanStages[];
+extern const uint16_t scanStageCount;
+
+/*
+ * Results ring, one row of SCAN_CHANNELS per scan so each store is a
+ * single sequential run of FRAM words. Lives in FRAM.
+ */
+extern volatile uint16_t AIresults[Num_of_Results][SCAN_CHANNELS];
+
+extern volatile uint16_t scanEmitDrops;
+
+// Slots triggered before the last one finished, counted by ADC12ISR
+extern volatile uint16_t scanOverruns;
+
+void Scan_Process_Frame(Scan_Frame *frame);
+
+#endif /* AI_SCANNER_SCAN_H_ */
@@ -0,0 +1,413 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Multi-rate scan schedule.
+ *
+ * Instead of converting all sixteen channels on every scan, each
+ * channel gets a rate class and the timer-paced ADC sequence only
+ * carries the channels due in that slot. The table of which channels
+ * go in which slot is worked out once, here, and ADC12ISR just steps
+ * through it, reprogramming the memory map between slots when the
+ * next slot differs from the last.
+ *
+ * Slow channels are given phases that spread them evenly across the
+ * hyperperiod, so no single slot ends up carrying all of them and
+ * the worst case slot stays short.
+ *
+ * The config can change at run time. The new table is built into the
+ * spare of two FRAM tables while ADC12ISR keeps stepping through the
+ * active one, then Sched_Advance() swaps them at the end of a slot and
+ * starts the new table from its first slot. No slot ever mixes the
+ * two configs.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#include <string.h>
+#include "sched.h"
+#include "memory.h"
+
+/*
+ * Out of the box every channel is in class 0 and scanned every slot,
+ * the same as the original fixed A0-A15 sequence. For example, to
+ * scan A0-A3 at 1 kHz and A4-A15 at ~1 Hz use slotHz = 1000 and put
+ * A4-A15 in class 3 (divider 1024).
+ */
+const Sched_Config schedDefaultConfig =
+{
+    100,
+    { 1, 8, 64, 1024 },
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { 2, 0 }    /* 16 clocks for buffers 0-7, 4 for 8-15 */
+};
+
+MEM_FRAM(schedTables)
+Sched_Table schedTables[2] = {0};
+
+Sched_Table *schedActive = &schedTables[0];
+Sched_Table * volatile schedPending = 0;
+uint16_t schedSlot = 0;
+
+Sched_Isr_Measured schedIsrMeasured;
+
+/*
+ * ADC12SHT0x/ADC12SHT1x code to sample window in ADC12CLK cycles.
+ * ADC12CTL0 register description in Reference 3.
+ */
+static const uint16_t schedSampleClocks[SCHED_MAX_SAMPLE + 1] =
+{
+    4, 8, 16, 32, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1024, 1024, 1024
+};
+
+uint16_t Sched_Channel_Count(uint16_t mask)
+{
+    uint16_t count = 0;
+
+    while (mask)
+    {
+        mask &= mask - 1;
+        count++;
+    }
+
+    return count;
+}
+
+/*
+ * Busiest slot among phase, phase + divider, phase + 2 * divider...
+ */
+static uint16_t Sched_Phase_Load(const Sched_Table *table, uint16_t phase,
+                                 uint16_t divider)
+{
+    uint16_t load = 0;
+    uint16_t slot;
+
+    for (slot = phase; slot < table->slots; slot += divider)
+    {
+        uint16_t count = Sched_Channel_Count(table->mask[slot]);
+
+        if (count > load)
+        {
+            load = count;
+        }
+    }
+
+    return load;
+}
+
+/*
+ * Builds the slot table for config. Returns SCHED_OK or an error, in
+ * which case the table is left invalid. Rebuilding for the config the
+ * table already holds is free, so a warm boot doesn't pay for it.
+ */
+uint16_t Sched_Build(const Sched_Config *config, Sched_Table *table)
+{
+    uint16_t channel;
+    uint16_t slot;
+    uint16_t pass;
+    uint16_t used = 0;
+    uint16_t hyperperiod = 1;
+
+    if (table->valid &&
+        (memcmp(&table->config, config, sizeof(Sched_Config)) == 0))
+    {
+        return SCHED_OK;
+    }
+    table->valid = 0;
+
+    if (config->slotHz == 0)
+    {
+        return SCHED_BAD_RATE;
+    }
+    if ((config->sampleHold[0] > SCHED_MAX_SAMPLE) ||
+        (config->sampleHold[1] > SCHED_MAX_SAMPLE))
+    {
+        return SCHED_BAD_SAMPLE;
+    }
+
+    for (channel = 0; channel < SCAN_CHANNELS; channel++)
+    {
+        uint8_t rateClass = config->channelClass[channel];
+        uint16_t divider;
+
+        if (rateClass == SCHED_CLASS_OFF)
+        {
+            continue;
+        }
+        if (rateClass >= SCHED_CLASSES)
+        {
+            return SCHED_BAD_CLASS;
+        }
+
+        divider = config->divider[rateClass];
+        if ((divider == 0) || (divider > SCHED_MAX_SLOTS) ||
+            (divider & (divider - 1)))
+        {
+            return SCHED_BAD_DIVIDER;
+        }
+        if (divider > hyperperiod)
+        {
+            hyperperiod = divider;
+        }
+        used++;
+    }
+
+    if (used == 0)
+    {
+        return SCHED_NO_CHANNELS;
+    }
+
+    table->slots = hyperperiod;
+    for (slot = 0; slot < hyperperiod; slot++)
+    {
+        table->mask[slot] = 0;
+        table->classMask[slot] = 0;
+    }
+
+    /*
+     * Place channels fastest class first, each at the phase whose
+     * busiest slot is least busy. Dividers are powers of 2 so every
+     * phase repeats cleanly within the hyperperiod.
+     */
+    for (pass = 1; pass <= hyperperiod; pass <<= 1)
+    {
+        for (channel = 0; channel < SCAN_CHANNELS; channel++)
+        {
+            uint8_t rateClass = config->channelClass[channel];
+            uint16_t bestPhase = 0;
+            uint16_t bestLoad = 0xFFFF;
+            uint16_t phase;
+
+            if ((rateClass == SCHED_CLASS_OFF) ||
+                (config->divider[rateClass] != pass))
+            {
+                continue;
+            }
+
+            for (phase = 0; phase < pass; phase++)
+            {
+                uint16_t load = Sched_Phase_Load(table, phase, pass);
+
+                if (load < bestLoad)
+                {
+                    bestLoad = load;
+                    bestPhase = phase;
+                }
+            }
+
+            for (slot = bestPhase; slot < hyperperiod; slot += pass)
+            {
+                table->mask[slot] |= (uint16_t)1 << channel;
+                table->classMask[slot] |= (uint8_t)(1 << rateClass);
+            }
+        }
+    }
+
+    table->maxPerSlot = 0;
+    for (slot = 0; slot < hyperperiod; slot++)
+    {
+        uint16_t count = Sched_Channel_Count(table->mask[slot]);
+
+        if (count > table->maxPerSlot)
+        {
+            table->maxPerSlot = count;
+        }
+    }
+
+    table->config = *config;
+    table->valid = 1;
+
+    return SCHED_OK;
+}
+
+/*
+ * Makes config the active schedule at boot, reusing whichever table
+ * already holds it, so a warm boot after a run time change doesn't
+ * rebuild either.
+ */
+uint16_t Sched_Load(const Sched_Config *config)
+{
+    uint16_t i;
+
+    schedPending = 0;
+    schedSlot = 0;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (schedTables[i].valid &&
+            (memcmp(&schedTables[i].config, config, sizeof(Sched_Config)) == 0))
+        {
+            schedActive = &schedTables[i];
+            return SCHED_OK;
+        }
+    }
+
+    schedActive = &schedTables[0];
+    return Sched_Build(config, schedActive);
+}
+
+/*
+ * The table ADC12ISR isn't using, free to build into.
+ */
+Sched_Table *Sched_Spare(void)
+{
+    return (schedActive == &schedTables[0]) ? &schedTables[1] : &schedTables[0];
+}
+
+/*
+ * Hands a built table over to ADC12ISR. It takes over after the slot
+ * in progress.
+ */
+void Sched_Queue(Sched_Table *table)
+{
+    schedPending = table;
+}
+
+/*
+ * Steps schedSlot on to the next slot. A queued table takes over here,
+ * from its own first slot. Returns 1 when it did, and the caller must
+ * then reprogram the ADC in full. Called from ADC12ISR.
+ */
+unsigned char Sched_Advance(void)
+{
+    Sched_Table *pending = schedPending;
+
+    if (pending != 0)
+    {
+        schedActive = pending;
+        schedPending = 0;
+        schedSlot = 0;
+        return 1;
+    }
+
+    schedSlot++;
+    if (schedSlot == schedActive->slots)
+    {
+        schedSlot = 0;
+    }
+    return 0;
+}
+
+uint16_t Sched_Sample_Hold_Clocks(uint8_t code)
+{
+    return schedSampleClocks[code & SCHED_MAX_SAMPLE];
+}
+
+static uint32_t Sched_Model_Cycles(uint16_t mask, uint16_t nextMask)
+{
+    uint32_t cycles = SCHED_ISR_BASE_CYCLES +
+        ((uint32_t)Sched_Channel_Count(mask) * SCHED_ISR_CHANNEL_CYCLES);
+
+    if (nextMask != mask)
+    {
+        cycles += (uint32_t)Sched_Channel_Count(nextMask) * SCHED_REPROGRAM_CYCLES;
+    }
+
+    return cycles;
+}
+
+/*
+ * MCLK cycles ADC12ISR spends on a slot converting mask, setting up
+ * for one converting nextMask. Never less than the board has measured.
+ */
+uint32_t Sched_Slot_Cycles(uint16_t mask, uint16_t nextMask)
+{
+    return Sched_Model_Cycles(mask, nextMask) + schedIsrMeasured.excess;
+}
+
+/*
+ * From ADC12ISR with what the slot just took, in cycles at
+ * SCHED_MCLK_HZ.
+ */
+void Sched_Record_Cycles(uint16_t mask, uint16_t nextMask, uint32_t cycles)
+{
+    uint32_t model = Sched_Model_Cycles(mask, nextMask);
+
+    if (cycles > schedIsrMeasured.worst)
+    {
+        schedIsrMeasured.worst = cycles;
+        schedIsrMeasured.worstChannels = Sched_Channel_Count(mask);
+    }
+    if (cycles > model + schedIsrMeasured.excess)
+    {
+        schedIsrMeasured.excess = (cycles - model > 0xFFFF) ? 0xFFFF
+                                                            : (uint16_t)(cycles - model);
+    }
+}
+
+/*
+ * ADC clocks a slot converting mask keeps ADC12_B busy for, sample
+ * windows included. An empty slot still converts one filler channel.
+ */
+uint32_t Sched_Slot_Adc_Clocks(const Sched_Config *config, uint16_t mask)
+{
+    uint16_t count = Sched_Channel_Count(mask);
+    uint16_t conversions = count ? count : 1;
+    uint32_t clocks = 0;
+    uint16_t memory;
+
+    for (memory = 0; memory < conversions; memory++)
+    {
+        clocks += SCHED_CONVERT_CLOCKS +
+            Sched_Sample_Hold_Clocks(config->sampleHold[(memory < 8) ? 0 : 1]);
+    }
+
+    return clocks;
+}
+
+/*
+ * Time from the trigger of a slot converting mask until ADC12ISR has
+ * the ADC ready for one converting nextMask.
+ */
+uint32_t Sched_Slot_Ns(const Sched_Config *config, uint16_t mask,
+                       uint16_t nextMask, uint32_t mclkHz)
+{
+    uint32_t clocks = Sched_Slot_Adc_Clocks(config, mask);
+    uint32_t cycles = Sched_Slot_Cycles(mask, nextMask);
+
+    // Both in ns without overflowing 32 bits
+    return (clocks * 100000UL) / (SCHED_ADC_CLOCK_HZ / 10000UL) +
+           (cycles * 1000000UL) / (mclkHz / 1000UL);
+}
+
+/*
+ * Longest slot of the table, including the wrap from the last slot
+ * back to the first.
+ */
+uint32_t Sched_Worst_Slot_Ns(const Sched_Table *table, uint32_t mclkHz)
+{
+    uint32_t worst = 0;
+    uint16_t slot;
+
+    for (slot = 0; slot < table->slots; slot++)
+    {
+        uint16_t next = (uint16_t)((slot + 1 == table->slots) ? 0 : slot + 1);
+        uint32_t busy = Sched_Slot_Ns(&table->config, table->mask[slot],
+                                      table->mask[next], mclkHz);
+
+        if (busy > worst)
+        {
+            worst = busy;
+        }
+    }
+
+    return worst;
+}
+
+/*
+ * Fastest slot rate the table's busiest slot allows.
+ */
+uint16_t Sched_Max_Slot_Hz(const Sched_Table *table, uint32_t mclkHz)
+{
+    uint32_t worst = Sched_Worst_Slot_Ns(table, mclkHz);
+    uint32_t hz;
+
+    if (worst == 0)
+    {
+        return 0xFFFF;
+    }
+    hz = 1000000000UL / worst;
+
+    return (hz > 0xFFFFUL) ? 0xFFFF : (uint16_t)hz;
+}
@@ -0,0 +1,137 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Multi-rate scan schedule.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#ifndef AI_SCANNER_SCHED_H_
+#define AI_SCANNER_SCHED_H_
+
+#include <stdint.h>
+#include "scan.h"
+#include "clock.h"
+
+#define SCHED_CLASSES       4
+#define SCHED_MAX_SLOTS     1024
+
+#define SCHED_OK            0
+#define SCHED_BAD_DIVIDER   1
+#define SCHED_BAD_CLASS     2
+#define SCHED_NO_CHANNELS   3
+#define SCHED_BAD_RATE      4
+#define SCHED_BAD_SAMPLE    5
+
+/*
+ * Every slot the timer triggers one ADC sequence. A channel in rate
+ * class c is converted every divider[c] slots, i.e. at
+ * slotHz / divider[c]. Dividers must be powers of 2 up to
+ * SCHED_MAX_SLOTS. Channels set to SCHED_CLASS_OFF are never scanned.
+ *
+ * sampleHold is the ADC12SHT0x and ADC12SHT1x code, 0 to 15, for the
+ * sample window of memory buffers 0-7 and 8-15 respectively, see
+ * Sched_Sample_Hold_Clocks().
+ */
+#define SCHED_CLASS_OFF     0xFF
+#define SCHED_MAX_SAMPLE    15
+
+typedef struct
+{
+    uint16_t slotHz;
+    uint16_t divider[SCHED_CLASSES];
+    uint8_t channelClass[SCAN_CHANNELS];
+    uint8_t sampleHold[2];
+} Sched_Config;
+
+/*
+ * Precomputed schedule, one entry per slot of the hyperperiod (the
+ * largest divider in use). mask has a bit per channel converted in
+ * that slot, classMask a bit per rate class represented.
+ */
+typedef struct
+{
+    Sched_Config config;
+    uint16_t valid;
+    uint16_t slots;
+    uint16_t maxPerSlot;
+    uint16_t mask[SCHED_MAX_SLOTS];
+    uint8_t classMask[SCHED_MAX_SLOTS];
+} Sched_Table;
+
+/*
+ * Timing model behind the achievable slot rate, the same one
+ * host/schedsim.c checks against. ADC12_B runs on MODOSC, budgeted at
+ * its 4.0 MHz minimum rather than the typical 4.8 MHz (MODOSC in
+ * Reference 1), and a 12-bit conversion takes 14 clocks after the
+ * sample window.
+ *
+ * ADC12ISR costs are MCLK cycles at the clock profile's CLOCK_CPU_HZ,
+ * counted over what the default pipeline runs, no filter or rbe. Per
+ * frame that is mostly the fixed part of the slot (control, sync and
+ * schedule bookkeeping, the timing below) and encoding and queueing
+ * the 13 bytes of every WIRE_TYPE_SCAN record; per channel, its two
+ * bytes through Wire_Encode() and the TX ring at about 20 cycles each,
+ * plus comp, store and emit. Swapping in a new table costs a full
+ * reprogram plus SCHED_SWAP_CYCLES.
+ *
+ * ADC12ISR also times itself on the board. Sched_Slot_Cycles() adds
+ * the most it has run past these figures, and WIRE_TYPE_SCHED_CONFIG
+ * reports the worst slot measured, see Sched_Record_Cycles().
+ */
+#define SCHED_ADC_CLOCK_HZ          4000000UL
+#define SCHED_CONVERT_CLOCKS        14
+#define SCHED_MCLK_HZ               CLOCK_CPU_HZ
+#define SCHED_ISR_BASE_CYCLES       1300
+#define SCHED_ISR_CHANNEL_CYCLES    120
+#define SCHED_REPROGRAM_CYCLES      30
+#define SCHED_SWAP_CYCLES           200
+
+// Model cycles per timestamp tick, in Q8 so ADC12ISR doesn't divide
+#define SCHED_CYCLES_PER_TICK_Q8    ((SCHED_MCLK_HZ * 256UL) / CLOCK_TIMESTAMP_HZ)
+
+/*
+ * What ADC12ISR measured on this board since reset, in the model's
+ * cycles. excess is the most any slot ran past Sched_Slot_Cycles()'s
+ * own figures.
+ */
+typedef struct
+{
+    uint32_t worst;
+    uint16_t worstChannels;
+    uint16_t excess;
+} Sched_Isr_Measured;
+
+// Measurements ADC12ISR updates every slot, in SRAM
+#define SCHED_SRAM_BYTES            (sizeof(Sched_Isr_Measured))
+
+/*
+ * Two tables in FRAM. ADC12ISR steps through schedActive; a new
+ * config is built into the other one and handed over with
+ * Sched_Queue(), which takes effect between two slots.
+ */
+extern const Sched_Config schedDefaultConfig;
+extern Sched_Table schedTables[2];
+extern Sched_Table *schedActive;
+extern Sched_Table * volatile schedPending;
+extern uint16_t schedSlot;
+extern Sched_Isr_Measured schedIsrMeasured;
+
+uint16_t Sched_Build(const Sched_Config *config, Sched_Table *table);
+uint16_t Sched_Load(const Sched_Config *config);
+Sched_Table *Sched_Spare(void);
+void Sched_Queue(Sched_Table *table);
+unsigned char Sched_Advance(void);
+uint16_t Sched_Channel_Count(uint16_t mask);
+uint16_t Sched_Sample_Hold_Clocks(uint8_t code);
+uint32_t Sched_Slot_Cycles(uint16_t mask, uint16_t nextMask);
+void Sched_Record_Cycles(uint16_t mask, uint16_t nextMask, uint32_t cycles);
+uint32_t Sched_Slot_Adc_Clocks(const Sched_Config *config, uint16_t mask);
+uint32_t Sched_Slot_Ns(const Sched_Config *config, uint16_t mask,
+                       uint16_t nextMask, uint32_t mclkHz);
+uint32_t Sched_Worst_Slot_Ns(const Sched_Table *table, uint32_t mclkHz);
+uint16_t Sched_Max_Slot_Hz(const Sched_Table *table, uint32_t mclkHz);
+
+#endif /* AI_SCANNER_SCHED_H_ */
@@ -0,0 +1,263 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Synchronized sampling across boards sharing a sync line.
+ *
+ * One board is the master. Its Timer_A0 CCR0 interrupt comes with
+ * every slot trigger and raises the sync line, and CCR2 drops it
+ * again after the width synclock.c planned for that slot, which is
+ * how the shared slot count gets across. The slaves take an interrupt
+ * on each edge of the line. On a rising edge they read their own
+ * Timer_A0 first thing, hand it to synclock.c and, as it says, move
+ * CCR0 so their next trigger lands just ahead of the master's, or
+ * have their own CCR0 interrupt do it once a late trigger has gone.
+ * The falling edge gives the pulse width.
+ *
+ * Every frame is tagged in ADC12ISR, empty slots too, with the count
+ * of the trigger it came from and on a slave the skew measured from
+ * the edge. scan.c sends tagged frames as WIRE_TYPE_SYNC_SCAN, which
+ * host/syncsim.c merges across boards by count.
+ *
+ * All boards have to run the same slotHz, and sync doesn't work in
+ * duty cycled mode, where the scan and the timestamp stop.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#include <driverlib.h>
+#include "sync.h"
+#include "memory.h"
+#include "timestamp.h"
+
+/*
+ * Off until set up for a site. Lives in FRAM so the setting survives
+ * resets.
+ */
+MEM_FRAM(syncConfig)
+Sync_Config syncConfig = { SYNC_OFF, 0 };
+
+Synclock_Slave syncSlave;
+
+static Synclock_Master syncMaster;
+static unsigned char syncStarted = 0;
+static volatile uint16_t syncNextCcr0 = 0;
+
+/*
+ * Timer_A0 ticks per slot, CCR0 + 1, as the scan timer runs now.
+ */
+static uint16_t Sync_Period(void)
+{
+    return HWREG16(TIMER_A0_BASE + OFS_TAxCCR0) + 1;
+}
+
+static uint32_t Sync_Slot_Stamps(uint16_t period)
+{
+    return (((uint32_t)period * TIMESTAMP_HZ) + (ADC_TIMER_HZ / 2)) / ADC_TIMER_HZ;
+}
+
+void Init_Sync()
+{
+    if (syncConfig.role == SYNC_MASTER)
+    {
+        GPIO_setOutputLowOnPin(SYNC_GPIO_PORT, SYNC_GPIO_PIN);
+        GPIO_setAsOutputPin(SYNC_GPIO_PORT, SYNC_GPIO_PIN);
+    }
+    else if (syncConfig.role == SYNC_SLAVE)
+    {
+        /*
+         * Pulled down, so a board without the line sees no edges
+         * rather than noise. Rising edge first.
+         */
+        GPIO_setAsInputPinWithPullDownResistor(SYNC_GPIO_PORT, SYNC_GPIO_PIN);
+        GPIO_selectInterruptEdge(SYNC_GPIO_PORT, SYNC_GPIO_PIN,
+            GPIO_LOW_TO_HIGH_TRANSITION);
+        GPIO_clearInterrupt(SYNC_GPIO_PORT, SYNC_GPIO_PIN);
+        GPIO_enableInterrupt(SYNC_GPIO_PORT, SYNC_GPIO_PIN);
+    }
+}
+
+/*
+ * Right after Init_Scan_Timer(), whenever the scan starts. The count
+ * carries on from where it was, the slaves pick it up again after the
+ * gap.
+ */
+void Sync_Start()
+{
+    uint16_t period = Sync_Period();
+
+    if (syncConfig.role == SYNC_MASTER)
+    {
+        if (!syncStarted)
+        {
+            Synclock_Master_Init(&syncMaster, period);
+        }
+        else
+        {
+            Synclock_Master_Rate(&syncMaster, period);
+        }
+
+        // A stop mid pulse leaves the line up
+        SYNC_OUT &= ~SYNC_GPIO_PIN;
+        HWREG16(TIMER_A0_BASE + OFS_TAxCCTL2) = 0;
+        HWREG16(TIMER_A0_BASE + OFS_TAxCCTL0) = CCIE;
+    }
+    else if (syncConfig.role == SYNC_SLAVE)
+    {
+        if (!syncStarted)
+        {
+            Synclock_Slave_Init(&syncSlave, period, Sync_Slot_Stamps(period),
+                                SYNC_LATENCY_TICKS, SYNC_LEAD_TICKS,
+                                SYNC_GUARD_TICKS);
+        }
+        else
+        {
+            Synclock_Slave_Rate(&syncSlave, period, Sync_Slot_Stamps(period));
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    syncStarted = 1;
+}
+
+/*
+ * From ADC12ISR after Retime_Scan_Timer(). A slave's period estimate
+ * starts over, the master's next pulse widths scale with the period.
+ */
+void Sync_Set_Rate()
+{
+    Sync_Start();
+}
+
+/*
+ * End of every scan slot, from ADC12ISR before anything looks at the
+ * frame.
+ */
+void Sync_Slot_Done(Synclock_Tag *tag)
+{
+    if (syncConfig.role == SYNC_MASTER)
+    {
+        Synclock_Master_Slot(&syncMaster, tag);
+    }
+    else if (syncConfig.role == SYNC_SLAVE)
+    {
+        Synclock_Slave_Slot(&syncSlave, tag);
+    }
+    else
+    {
+        tag->flags = 0;
+        return;
+    }
+
+    tag->node = syncConfig.node;
+}
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(TIMER0_A0_VECTOR)))
+#endif
+void TIMER0_A0_ISR (void)
+{
+    // A slave's trigger after a late edge, now the period after it can move
+    if (syncConfig.role == SYNC_SLAVE)
+    {
+        HWREG16(TIMER_A0_BASE + OFS_TAxCCR0) = syncNextCcr0;
+        HWREG16(TIMER_A0_BASE + OFS_TAxCCR1) = syncNextCcr0 / 2;
+        HWREG16(TIMER_A0_BASE + OFS_TAxCCTL0) = 0;
+        return;
+    }
+
+    // Master, at every slot trigger. The pulse first, then the bookkeeping.
+    if (syncMaster.width)
+    {
+        SYNC_OUT |= SYNC_GPIO_PIN;
+        HWREG16(TIMER_A0_BASE + OFS_TAxCCR2) = syncMaster.width;
+        HWREG16(TIMER_A0_BASE + OFS_TAxCCTL2) = CCIE;
+    }
+
+    Synclock_Master_Trigger(&syncMaster);
+}
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=TIMER0_A1_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(TIMER0_A1_VECTOR)))
+#endif
+void TIMER0_A1_ISR (void)
+{
+    switch (__even_in_range(TA0IV, TA0IV_TAIFG)){
+        case TA0IV_TACCR2:
+            // End of the master's pulse
+            SYNC_OUT &= ~SYNC_GPIO_PIN;
+            HWREG16(TIMER_A0_BASE + OFS_TAxCCTL2) = 0;
+            break;
+        default: break;
+    }
+}
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=PORT2_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(PORT2_VECTOR)))
+#endif
+void PORT2_ISR (void)
+{
+    uint16_t ticks = HWREG16(TIMER_A0_BASE + OFS_TAxR);
+    uint16_t period;
+    Synclock_Action action;
+
+    switch (__even_in_range(P2IV, P2IV_P2IFG7)){
+        case SYNC_IV_PIN:
+            period = Sync_Period();
+
+            // Edge select flips every edge, so it says which one this was
+            if (SYNC_IES & SYNC_GPIO_PIN)
+            {
+                SYNC_IES &= ~SYNC_GPIO_PIN;
+                Synclock_Fall(&syncSlave, ticks, period);
+                break;
+            }
+            SYNC_IES |= SYNC_GPIO_PIN;
+
+            /*
+             * From here CCIFG of CCR0 is the trigger still to come, if
+             * there is one. Unless the timer got there since the read,
+             * then a retime meant for after it comes a slot late.
+             */
+            HWREG16(TIMER_A0_BASE + OFS_TAxCCTL0) &= ~CCIFG;
+
+            /*
+             * The slot's frame is still to be tagged while its
+             * conversions or ADC12ISR are pending.
+             */
+            action = Synclock_Rise(&syncSlave, ticks, period, Timestamp_Now(),
+                (HWREG16(ADC12_B_BASE + OFS_ADC12CTL1) & ADC12BUSY) ||
+                (HWREG16(ADC12_B_BASE + OFS_ADC12IFGR0) &
+                 HWREG16(ADC12_B_BASE + OFS_ADC12IER0)));
+            if (action.retime == SYNCLOCK_RETIME_NOW)
+            {
+                // TA0.1 still rises at CCR0, the timer runs on
+                HWREG16(TIMER_A0_BASE + OFS_TAxCCR0) = action.ccr0;
+                HWREG16(TIMER_A0_BASE + OFS_TAxCCR1) = action.ccr0 / 2;
+            }
+            else if (action.retime == SYNCLOCK_RETIME_NEXT)
+            {
+                // TIMER0_A0_ISR at the trigger, straight away if it has been
+                syncNextCcr0 = action.ccr0;
+                HWREG16(TIMER_A0_BASE + OFS_TAxCCTL0) |= CCIE;
+            }
+            break;
+        default: break;
+    }
+}
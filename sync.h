@@ -0,0 +1,82 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Synchronized sampling across boards sharing a sync line.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#ifndef AI_SCANNER_SYNC_H_
+#define AI_SCANNER_SYNC_H_
+
+#include <stdint.h>
+#include "adc.h"
+#include "sched.h"
+#include "synclock.h"
+
+#define SYNC_OFF            0
+#define SYNC_MASTER         1
+#define SYNC_SLAVE          2
+
+/*
+ * role SYNC_OFF scans free running, as without the sync suite. node
+ * is sent with every frame so the host can tell boards apart.
+ */
+typedef struct
+{
+    uint8_t role;
+    uint8_t node;
+} Sync_Config;
+
+/*
+ * The sync line, P2.0 on every board: driven by the master, an input
+ * with an interrupt on each edge on the slaves. Any port 2 pin will
+ * do, it only needs PORT2_VECTOR.
+ */
+#define SYNC_GPIO_PORT      GPIO_PORT_P2
+#define SYNC_GPIO_PIN       GPIO_PIN0
+#define SYNC_OUT            P2OUT
+#define SYNC_IN             P2IN
+#define SYNC_IES            P2IES
+#define SYNC_IV_PIN         P2IV_P2IFG0
+
+/*
+ * Interrupt entry up to the pin write on the master and up to the
+ * timer read on the slave, from the MSP430 interrupt latency of 6
+ * cycles plus the handlers' first instructions.
+ */
+#define SYNC_MASTER_CYCLES  20
+#define SYNC_SLAVE_CYCLES   30
+
+// Timer_A0 ticks from the master's trigger to the slave's timer read
+#define SYNC_LATENCY_TICKS  ((uint16_t)( \
+    (((uint32_t)(SYNC_MASTER_CYCLES + SYNC_SLAVE_CYCLES) * ADC_TIMER_HZ) + \
+     (SCHED_MCLK_HZ / 2)) / SCHED_MCLK_HZ))
+
+/*
+ * From the slave's timer read to its CCR0 write, Synclock_Rise() in
+ * between. CCR0 only moves if the timer is still this far short of it.
+ */
+#define SYNC_RISE_CYCLES    400
+#define SYNC_GUARD_TICKS    ((uint16_t)((((uint32_t)SYNC_RISE_CYCLES * ADC_TIMER_HZ) + \
+                                         SCHED_MCLK_HZ - 1) / SCHED_MCLK_HZ))
+
+// Slaves trigger this far ahead of the master, so a late edge isn't a slot late
+#define SYNC_LEAD_TICKS     1
+
+#define SYNC_SRAM_BYTES     (sizeof(Synclock_Slave) + sizeof(Synclock_Master) + 8)
+
+extern Sync_Config syncConfig;
+extern Synclock_Slave syncSlave;
+
+void Init_Sync(void);
+void Sync_Start(void);
+void Sync_Set_Rate(void);
+void Sync_Slot_Done(Synclock_Tag *tag);
+
+#endif /* AI_SCANNER_SYNC_H_ */
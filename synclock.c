@@ -0,0 +1,407 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Slot synchronization between boards over a shared sync line: the
+ * pulse code the master sends and the lock a slave keeps on it.
+ *
+ * The master raises the line at its slot trigger for the width
+ * Synclock_Master_Trigger() planned. A slave reads its own scan timer
+ * on each rising edge. That tells it how far its trigger was from the
+ * master's, which is the skew each of its frames carries, and, from
+ * one edge to the next, how long the master's period is in its own
+ * ticks. It then moves CCR0 so its next trigger lands lead ticks
+ * ahead of the master's next one, so skew can't build up over more
+ * than a slot or two whatever the two clocks do. When its trigger for
+ * this slot is still to come, that trigger is left be and CCR0 only
+ * moves once it has gone. The timer itself is never stopped or
+ * cleared, so no ticks go missing while the edge interrupt works it
+ * out.
+ *
+ * Pulse spacing on a free-running timestamp gives the slave the
+ * superframe position, the falling edges the bits of the count.
+ * Timer ticks and slot periods in here are all Timer_A0's, with the
+ * period in ticks per slot, CCR0 + 1.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#include "synclock.h"
+
+uint32_t Synclock_Advance(uint32_t count, uint32_t slots)
+{
+    uint32_t room = SYNCLOCK_COUNT_WRAP - count;
+
+    return (slots < room) ? (count + slots) : (slots - room);
+}
+
+/*
+ * Pulse width for the slot at position in the superframe starting at
+ * base, 0 for none.
+ */
+static uint16_t Synclock_Width(uint32_t base, uint8_t position, uint16_t period)
+{
+    if (position == 0)
+    {
+        return 0;
+    }
+
+    return ((base >> (position - 1)) & 1) ? (uint16_t)(period / 2) :
+                                            (uint16_t)(period / 4);
+}
+
+void Synclock_Master_Init(Synclock_Master *master, uint16_t period)
+{
+    master->base = 0;
+    master->position = 0;
+    master->pulsed = 0;
+    master->period = period;
+    master->width = Synclock_Width(0, 0, period);
+    master->last = 0;
+}
+
+void Synclock_Master_Rate(Synclock_Master *master, uint16_t period)
+{
+    master->period = period;
+    master->width = Synclock_Width(master->base, master->position, period);
+}
+
+/*
+ * At each trigger, once the line is up if master->width said so:
+ * moves on to the next trigger's pulse. Counted here rather than per
+ * frame, so a slot the ADC missed doesn't put the count behind the
+ * pulses.
+ */
+void Synclock_Master_Trigger(Synclock_Master *master)
+{
+    master->last = Synclock_Advance(master->base, master->position);
+    master->pulsed = master->width != 0;
+
+    if (++master->position == SYNCLOCK_SUPER_SLOTS)
+    {
+        master->position = 0;
+        master->base = Synclock_Advance(master->base, SYNCLOCK_SUPER_SLOTS);
+    }
+    master->width = Synclock_Width(master->base, master->position,
+                                   master->period);
+}
+
+/*
+ * From the end of the master's slot: tags its frame with the last
+ * trigger's count.
+ */
+void Synclock_Master_Slot(Synclock_Master *master, Synclock_Tag *tag)
+{
+    tag->count = master->last;
+    tag->skew = 0;
+    tag->flags = SYNCLOCK_ON | SYNCLOCK_VALID | SYNCLOCK_MASTER |
+                 (master->pulsed ? SYNCLOCK_EDGE : 0);
+}
+
+void Synclock_Slave_Init(Synclock_Slave *slave, uint16_t period,
+                         uint32_t slotStamps, uint16_t latency, uint16_t lead,
+                         uint16_t guard)
+{
+    uint8_t *bytes = (uint8_t *)slave;
+    uint16_t i;
+
+    for (i = 0; i < sizeof(*slave); i++)
+    {
+        bytes[i] = 0;
+    }
+
+    slave->latency = latency;
+    slave->lead = lead;
+    slave->guard = guard;
+    Synclock_Slave_Rate(slave, period, slotStamps);
+}
+
+/*
+ * After the slave's own slot rate changes, which should be to the
+ * master's new one. The period estimate starts over from nominal.
+ */
+void Synclock_Slave_Rate(Synclock_Slave *slave, uint16_t period,
+                         uint32_t slotStamps)
+{
+    slave->nominal = period;
+    slave->estimate = (uint32_t)period << SYNCLOCK_PERIOD_SHIFT;
+    slave->slotStamps = slotStamps ? slotStamps : 1;
+    slave->wrapTicks = 0;
+}
+
+/*
+ * Master slots between two pulses, rounded, 3 for anything longer.
+ * Compares rather than divides, it runs in the edge interrupt.
+ */
+static uint8_t Synclock_Slots(uint32_t stamps, uint32_t slotStamps)
+{
+    uint32_t half = slotStamps / 2;
+
+    if (stamps < half)
+    {
+        return 0;
+    }
+    if (stamps < (slotStamps + half))
+    {
+        return 1;
+    }
+    if (stamps < ((2 * slotStamps) + half))
+    {
+        return 2;
+    }
+    return 3;
+}
+
+/*
+ * Superframe position of a pulse that arrived slots master periods
+ * after the last, and the count once the bits of a whole superframe
+ * are in.
+ */
+static void Synclock_Position(Synclock_Slave *slave, uint8_t slots)
+{
+    if (slave->aligned)
+    {
+        if ((slots == 1) && (slave->position < (SYNCLOCK_SUPER_SLOTS - 1)))
+        {
+            slave->position++;
+            return;
+        }
+
+        if ((slots == 2) && (slave->position == (SYNCLOCK_SUPER_SLOTS - 1)))
+        {
+            // Marker skipped, the bits read are the last superframe's base
+            if (slave->seen == 0xFFFFFFFFUL)
+            {
+                slave->valid = slave->decoded && (slave->base == slave->bits);
+                if (slave->decoded && !slave->valid)
+                {
+                    slave->slips++;
+                }
+                slave->decoded = 1;
+                slave->base = slave->bits;
+            }
+            else
+            {
+                slave->valid = 0;
+            }
+
+            if (slave->decoded)
+            {
+                slave->base = Synclock_Advance(slave->base, SYNCLOCK_SUPER_SLOTS);
+            }
+            slave->position = 1;
+            slave->bits = 0;
+            slave->seen = 0;
+            return;
+        }
+
+        // Off the code, a lost or extra pulse
+        slave->aligned = 0;
+        slave->valid = 0;
+    }
+
+    // A one slot gap is taken for a marker until the count says otherwise
+    if (slots == 2)
+    {
+        slave->aligned = 1;
+        slave->decoded = 0;
+        slave->position = 1;
+        slave->bits = 0;
+        slave->seen = 0;
+    }
+}
+
+/*
+ * The master's period in own ticks, from the timer at this edge and
+ * the last, with however many wraps in between comes out nearest the
+ * estimate.
+ */
+static void Synclock_Measure(Synclock_Slave *slave, uint16_t ticks,
+                             uint16_t period)
+{
+    uint32_t expected = slave->estimate >> SYNCLOCK_PERIOD_SHIFT;
+    uint32_t measured = (uint32_t)slave->wrapTicks - slave->lastTicks + ticks;
+    uint32_t unwrapped;
+    uint8_t wraps;
+
+    for (wraps = 0; (wraps < 4) && ((measured + (period / 2)) < expected); wraps++)
+    {
+        measured += period;
+    }
+
+    if (ticks > slave->lastTicks)
+    {
+        unwrapped = (uint32_t)ticks - slave->lastTicks;
+        if (((unwrapped > expected) ? (unwrapped - expected) : (expected - unwrapped)) <
+            ((measured > expected) ? (measured - expected) : (expected - measured)))
+        {
+            measured = unwrapped;
+        }
+    }
+
+    // Anything past the pull range is a glitch, not the master
+    if ((measured > ((uint32_t)slave->nominal + (slave->nominal >> SYNCLOCK_PULL_SHIFT))) ||
+        (measured < ((uint32_t)slave->nominal - (slave->nominal >> SYNCLOCK_PULL_SHIFT))))
+    {
+        return;
+    }
+
+    measured <<= SYNCLOCK_PERIOD_SHIFT;
+    if (measured >= slave->estimate)
+    {
+        slave->estimate += (measured - slave->estimate) >> SYNCLOCK_PERIOD_GAIN;
+    }
+    else
+    {
+        slave->estimate -= (slave->estimate - measured) >> SYNCLOCK_PERIOD_GAIN;
+    }
+}
+
+/*
+ * Rising edge, with the slave's timer count and period, CCR0 + 1, at
+ * the moment it was read, a timestamp, and whether the frame of the
+ * slave's last trigger is still to be tagged (its conversions or
+ * ADC12ISR still pending).
+ */
+Synclock_Action Synclock_Rise(Synclock_Slave *slave, uint16_t ticks,
+                              uint16_t period, uint32_t stamp,
+                              unsigned char untagged)
+{
+    Synclock_Action action;
+    uint8_t slots = 0;
+    uint32_t edge;
+    uint32_t target;
+    uint32_t ccr0;
+    unsigned char lead = ticks <= (period / 2);
+
+    if (slave->started)
+    {
+        slots = Synclock_Slots(stamp - slave->lastStamp, slave->slotStamps);
+    }
+    slave->started = 1;
+    slave->lastStamp = stamp;
+    slave->edges++;
+
+    Synclock_Position(slave, slots);
+
+    if ((slots == 1) && slave->wrapTicks)
+    {
+        Synclock_Measure(slave, ticks, period);
+    }
+
+    /*
+     * The trigger fires as the timer reaches CCR0, one tick before it
+     * wraps. Both ends' latency puts the reading after the master's.
+     * Led, the slave's trigger is the one just gone, lagged, the one
+     * still to come.
+     */
+    slave->skew = (int16_t)((int32_t)slave->latency - 1 - ticks +
+                            (lead ? 0 : period));
+    slave->fresh = 1;
+
+    // Count of the frame this pulse belongs to
+    if (slave->aligned && slave->decoded)
+    {
+        edge = Synclock_Advance(slave->base, slave->position);
+        slave->next = (lead && !untagged) ? Synclock_Advance(edge, 1) : edge;
+    }
+
+    // Ticks from now to the trigger that should go lead ticks ahead of the master's next
+    target = ((slave->estimate + (1U << (SYNCLOCK_PERIOD_SHIFT - 1))) >>
+              SYNCLOCK_PERIOD_SHIFT) - slave->latency - slave->lead;
+
+    if (lead)
+    {
+        ccr0 = ticks + target;
+        action.retime = SYNCLOCK_RETIME_NOW;
+
+        // Not so close the timer gets there first
+        if (ccr0 <= ((uint32_t)ticks + slave->guard))
+        {
+            ccr0 = (uint32_t)ticks + slave->guard + 1;
+        }
+    }
+    else
+    {
+        // The late trigger stays, the period after it comes out short
+        ccr0 = ((uint32_t)ticks + target > period) ? ((uint32_t)ticks + target - period) : 0;
+        action.retime = SYNCLOCK_RETIME_NEXT;
+
+        if (ccr0 <= slave->guard)
+        {
+            ccr0 = slave->guard + 1;
+        }
+    }
+
+    if (ccr0 >= 0xFFFFUL)
+    {
+        action.retime = SYNCLOCK_RETIME_NONE;
+    }
+    action.ccr0 = (uint16_t)ccr0;
+
+    slave->lastTicks = ticks;
+    slave->wrapTicks = (action.retime == SYNCLOCK_RETIME_NOW) ? (uint16_t)(ccr0 + 1) : period;
+    slave->riseTicks = ticks;
+    return action;
+}
+
+/*
+ * Falling edge: the pulse's width is a bit of the count.
+ */
+void Synclock_Fall(Synclock_Slave *slave, uint16_t ticks, uint16_t period)
+{
+    uint16_t width = (ticks >= slave->riseTicks) ?
+                     (uint16_t)(ticks - slave->riseTicks) :
+                     (uint16_t)(ticks + period - slave->riseTicks);
+    uint32_t bit;
+
+    if (!slave->aligned || (slave->position == 0) ||
+        (slave->position >= SYNCLOCK_SUPER_SLOTS))
+    {
+        return;
+    }
+
+    bit = (uint32_t)1 << (slave->position - 1);
+    slave->seen |= bit;
+    if (((uint32_t)width * 8) > ((uint32_t)period * 3))
+    {
+        slave->bits |= bit;
+    }
+    else
+    {
+        slave->bits &= ~bit;
+    }
+}
+
+/*
+ * From the end of the slave's slot: tags its frame.
+ */
+void Synclock_Slave_Slot(Synclock_Slave *slave, Synclock_Tag *tag)
+{
+    // Without a pulse, the count only holds for the marker slot
+    unsigned char heard = slave->fresh ||
+        ((slave->silent == 0) && (slave->position == (SYNCLOCK_SUPER_SLOTS - 1)));
+
+    tag->count = slave->next;
+    tag->flags = SYNCLOCK_ON | (slave->fresh ? SYNCLOCK_EDGE : 0) |
+                 ((slave->valid && heard) ? SYNCLOCK_VALID : 0);
+    tag->skew = slave->fresh ? slave->skew : SYNCLOCK_NO_SKEW;
+    slave->next = Synclock_Advance(slave->next, 1);
+
+    if (slave->fresh)
+    {
+        slave->fresh = 0;
+        slave->silent = 0;
+        return;
+    }
+
+    if (++slave->silent == SYNCLOCK_LOST_SLOTS)
+    {
+        // The master has stopped, or the line is gone
+        slave->aligned = 0;
+        slave->valid = 0;
+        slave->wrapTicks = 0;
+        slave->losses++;
+    }
+}
@@ -0,0 +1,150 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Slot synchronization between boards over a shared sync line: the
+ * pulse code the master sends and the lock a slave keeps on it.
+ *
+ * Portable, shared with the host tools. sync.c is the hardware side.
+ *
+ */
+
+#ifndef AI_SCANNER_SYNCLOCK_H_
+#define AI_SCANNER_SYNCLOCK_H_
+
+#include <stdint.h>
+
+/*
+ * The master counts its scan slots and raises the line at every slot
+ * trigger but one in SYNCLOCK_SUPER_SLOTS. The missing pulse marks the
+ * start of a superframe. The widths of the other pulses carry the
+ * count of that first slot, LSB first: a quarter of a slot period for
+ * 0, half for 1. A slave that joins at any time knows the count after
+ * at most two superframes.
+ */
+#define SYNCLOCK_SUPER_SLOTS    33
+#define SYNCLOCK_COUNT_BITS     32
+
+// Counts wrap at a multiple of the superframe, so the code stays aligned
+#define SYNCLOCK_COUNT_WRAP     (SYNCLOCK_SUPER_SLOTS * \
+                                 (0xFFFFFFFFUL / SYNCLOCK_SUPER_SLOTS))
+
+/*
+ * Tag flags. EDGE, a pulse arrived for this slot and skew is measured;
+ * marker slots never have one. VALID, the count has been decoded and
+ * confirmed by the superframe after, and the slave hasn't lost the
+ * line since. The master's own frames carry both.
+ */
+#define SYNCLOCK_ON             0x01
+#define SYNCLOCK_EDGE           0x02
+#define SYNCLOCK_VALID          0x04
+#define SYNCLOCK_MASTER         0x08
+
+// Skew of a frame without an edge
+#define SYNCLOCK_NO_SKEW        ((int16_t)0x7FFF)
+
+// Pull range of the slave's period, 1/8 of the nominal
+#define SYNCLOCK_PULL_SHIFT     3
+
+// Period estimate fraction bits, and how hard each edge pulls on it
+#define SYNCLOCK_PERIOD_SHIFT   4
+#define SYNCLOCK_PERIOD_GAIN    2
+
+// Missed slots before a slave counts the line as lost
+#define SYNCLOCK_LOST_SLOTS     3
+
+/*
+ * A frame's tag: the shared slot count, and for a slave how far its
+ * trigger was from the master's in timer ticks, positive when late.
+ */
+typedef struct
+{
+    uint32_t count;
+    int16_t skew;
+    uint8_t flags;
+    uint8_t node;
+} Synclock_Tag;
+
+/*
+ * Master side. The next trigger's pulse is planned ahead, so the
+ * interrupt at the trigger only has to raise the line.
+ */
+typedef struct
+{
+    uint32_t base;      /* count of the next trigger's marker slot */
+    uint8_t position;   /* of the next trigger, 0..32              */
+    uint8_t pulsed;     /* the last trigger had a pulse            */
+    uint16_t period;    /* timer ticks                             */
+    uint16_t width;     /* of the next trigger's pulse, 0 for none */
+    uint32_t last;      /* count of the last trigger               */
+} Synclock_Master;
+
+/*
+ * Slave side. Ticks are the slave's scan timer's, timestamps are any
+ * free-running clock that counts through the gaps between pulses.
+ */
+typedef struct
+{
+    uint16_t nominal;       /* own slot period, ticks                   */
+    uint32_t estimate;      /* master's period in own ticks, fractional */
+    uint16_t latency;       /* both ends' ISR latency, ticks            */
+    uint16_t lead;          /* how early to trigger, ticks              */
+    uint16_t guard;         /* from the timer read to the CCR0 write    */
+    uint32_t slotStamps;    /* master's period in timestamp ticks       */
+    uint32_t lastStamp;
+    uint16_t lastTicks;     /* timer at the last rising edge            */
+    uint16_t wrapTicks;     /* and its period from then on              */
+    uint16_t riseTicks;
+    uint8_t started;
+    uint8_t aligned;        /* superframe position known                */
+    uint8_t decoded;        /* base count known                         */
+    uint8_t valid;
+    uint8_t position;       /* of the last pulse, 1..32                 */
+    uint8_t fresh;          /* a pulse since the last slot was tagged   */
+    uint8_t silent;         /* slots tagged since the last pulse        */
+    uint32_t bits;
+    uint32_t seen;          /* which of bits have arrived               */
+    uint32_t base;          /* count of this superframe's marker slot   */
+    uint32_t next;          /* count the next tagged frame gets         */
+    int16_t skew;
+    uint16_t edges;
+    uint16_t slips;         /* decodes that disagreed with the count    */
+    uint16_t losses;
+} Synclock_Slave;
+
+/*
+ * What a slave's timer has to do on a rising edge: write ccr0 to CCR0
+ * and half of it to CCR1, right away for SYNCLOCK_RETIME_NOW, or for
+ * SYNCLOCK_RETIME_NEXT from the CCR0 interrupt of the trigger still to
+ * come. The timer keeps counting, so it doesn't matter how long the
+ * write takes, up to the guard ticks.
+ */
+#define SYNCLOCK_RETIME_NONE    0
+#define SYNCLOCK_RETIME_NOW     1
+#define SYNCLOCK_RETIME_NEXT    2
+
+typedef struct
+{
+    uint8_t retime;
+    uint16_t ccr0;
+} Synclock_Action;
+
+uint32_t Synclock_Advance(uint32_t count, uint32_t slots);
+
+void Synclock_Master_Init(Synclock_Master *master, uint16_t period);
+void Synclock_Master_Rate(Synclock_Master *master, uint16_t period);
+void Synclock_Master_Trigger(Synclock_Master *master);
+void Synclock_Master_Slot(Synclock_Master *master, Synclock_Tag *tag);
+
+void Synclock_Slave_Init(Synclock_Slave *slave, uint16_t period,
+                         uint32_t slotStamps, uint16_t latency, uint16_t lead,
+                         uint16_t guard);
+void Synclock_Slave_Rate(Synclock_Slave *slave, uint16_t period,
+                         uint32_t slotStamps);
+Synclock_Action Synclock_Rise(Synclock_Slave *slave, uint16_t ticks,
+                              uint16_t period, uint32_t stamp,
+                              unsigned char untagged);
+void Synclock_Fall(Synclock_Slave *slave, uint16_t ticks, uint16_t period);
+void Synclock_Slave_Slot(Synclock_Slave *slave, Synclock_Tag *tag);
+
+#endif /* AI_SCANNER_SYNCLOCK_H_ */
@@ -0,0 +1,93 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Free-running 32-bit timestamp on Timer_A3 of the MSP430FR6989.
+ *
+ * The low 16 bits are the TA3R counter, the high 16 bits are counted
+ * by the TA3 overflow interrupt. Used for boot timing and any other
+ * latency measurements that need more than 16 bits of range.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#include <driverlib.h>
+#include "timestamp.h"
+
+static volatile uint16_t timestampOverflows = 0;
+
+void Init_Timestamp()
+{
+    /*
+     * Base address of Timer_A3
+     * SMCLK divided down to TIMESTAMP_HZ
+     * Interrupt on overflow to extend the counter
+     * Clear and start immediately
+     */
+    Timer_A_initContinuousModeParam param = {0};
+    param.clockSource = TIMER_A_CLOCKSOURCE_SMCLK;
+    param.clockSourceDivider = CLOCK_TIMER_A_TIMESTAMP;
+    param.timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_ENABLE;
+    param.timerClear = TIMER_A_DO_CLEAR;
+    param.startTimer = true;
+    Timer_A_initContinuousMode(TIMER_A3_BASE, &param);
+}
+
+uint32_t Timestamp_Now()
+{
+    uint16_t state = __get_interrupt_state();
+    uint16_t high;
+    uint16_t low;
+
+    __disable_interrupt();
+    high = timestampOverflows;
+    low = Timer_A_getCounterValue(TIMER_A3_BASE);
+
+    /*
+     * The counter may have wrapped after interrupts were disabled.
+     * If the overflow is still pending and the low word is small,
+     * the overflow belongs to this reading.
+     */
+    if ((Timer_A_getInterruptStatus(TIMER_A3_BASE) == TIMER_A_INTERRUPT_PENDING) &&
+        (low < 0x8000))
+    {
+        high++;
+    }
+    __set_interrupt_state(state);
+
+    return ((uint32_t)high << 16) | low;
+}
+
+/*
+ * Holds the count, for the duty suite's LPM3: Timer_A3 would otherwise
+ * keep SMCLK requested while the board sleeps. Time asleep is lost.
+ */
+void Timestamp_Pause()
+{
+    Timer_A_stop(TIMER_A3_BASE);
+}
+
+void Timestamp_Resume()
+{
+    Timer_A_startCounter(TIMER_A3_BASE, TIMER_A_CONTINUOUS_MODE);
+}
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=TIMER3_A1_VECTOR
+__interrupt
+#elif defined(__GNUC__)
+__attribute__((interrupt(TIMER3_A1_VECTOR)))
+#endif
+void TIMER3_A1_ISR (void)
+{
+    switch (__even_in_range(TA3IV, TA3IV_TAIFG)){
+        case TA3IV_TAIFG:
+            timestampOverflows++;
+            break;
+        default: break;
+    }
+}
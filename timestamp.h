@@ -0,0 +1,32 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Free-running 32-bit timestamp on Timer_A3 of the MSP430FR6989.
+ *
+ * References:
+ * 1 - MSP430FR698x(1), MSP430FR598x(1) Mixed-Signal Microcontrollers datasheet (Rev. D)
+ * 3 - MSP430x5xx and MSP430x6xx Family User's Guide (Rev. Q)
+ * 4 - msp430_driverlib_2_91_13_01
+ *
+ */
+
+#ifndef AI_SCANNER_TIMESTAMP_H_
+#define AI_SCANNER_TIMESTAMP_H_
+
+#include <stdint.h>
+#include "clock.h"
+
+/*
+ * Timer_A3 counts SMCLK / CLOCK_TIMESTAMP_DIVIDER: 125 kHz, one tick
+ * every 8 us, at 1 and 8 MHz and 250 kHz at 16 MHz, where the timer's
+ * input dividers top out at 64.
+ */
+#define TIMESTAMP_HZ    CLOCK_TIMESTAMP_HZ
+
+void Init_Timestamp(void);
+uint32_t Timestamp_Now(void);
+void Timestamp_Pause(void);
+void Timestamp_Resume(void);
+
+#endif /* AI_SCANNER_TIMESTAMP_H_ */
@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+#
+# LICENSE: Apache 2.0
+# Reference: github.com/zthurman/pocdaq
+#
+# SRAM/FRAM budget report from a linker map, per subsystem.
+#
+# Reads the .map written by the CCS (TI) linker or by msp430-elf-ld,
+# sums every input section by the object file it came from, and sorts
+# it into SRAM or FRAM by address. SRAM use and the stack headroom come
+# from the output sections the linker placed in SRAM (.data, .bss,
+# .TI.noinit and the like), not from the <MODULE>_SRAM_BYTES budgets;
+# those are only a cross-check, and objects using SRAM without one are
+# listed. Exits non-zero when the SRAM left over for the stack is below
+# the threshold, or when a section lies outside every known region, so
+# it can run as a post build step and fail the build:
+#
+#   python3 ${PROJECT_ROOT}/tools/mem_report.py ${BuildArtifactFileBaseName}.map
+#
+# The default threshold is MEM_STACK_MIN_BYTES from memory.h.
+
+import argparse
+import os
+import re
+import sys
+from collections import defaultdict
+
+# MSP430FR6989, Reference 1
+SRAM = (0x1C00, 0x2400)
+FRAM = ((0x1800, 0x1A00), (0x4400, 0x24000))
+
+# Sections that never load, debug info and the like, at address 0
+UNLOADED = re.compile(r'^\.(debug|comment|stab|gnu|MSP430\.attributes|mspabi|TI\.section)')
+
+# Objects whose SRAM memory.c budgets as MEM_MISC_SRAM_BYTES
+MISC = ('main', 'timestamp', 'persist', 'rts/driverlib')
+
+TI_INPUT = re.compile(
+    r'^\s+([0-9a-fA-F]{8})\s+([0-9a-fA-F]{8})\s+(?:(\S+)\s*:\s*)?(\S+\.obj)\s*(\(.*\))?')
+GNU_INPUT = re.compile(
+    r'^\s*(\.\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+\.o(?:bj)?\)?)\s*$')
+
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+
+
+def default_threshold():
+    header = os.path.join(ROOT, 'memory.h')
+    try:
+        with open(header) as f:
+            match = re.search(r'#define\s+MEM_STACK_MIN_BYTES\s+(\d+)', f.read())
+            if match:
+                return int(match.group(1))
+    except OSError:
+        pass
+    return 512
+
+
+def budgets():
+    """Lower case prefixes of every <MODULE>_SRAM_BYTES in the headers."""
+    names = set()
+    for name in os.listdir(ROOT):
+        if not name.endswith('.h'):
+            continue
+        try:
+            with open(os.path.join(ROOT, name)) as f:
+                names.update(m.lower() for m in
+                             re.findall(r'#define\s+([A-Z]+)_SRAM_BYTES\b', f.read()))
+        except OSError:
+            pass
+    names.discard('mem')
+    return names
+
+
+def budgeted(name, prefixes):
+    return name in MISC or any(name.startswith(p) for p in prefixes)
+
+
+def region(address):
+    if SRAM[0] <= address < SRAM[1]:
+        return 'sram'
+    for start, end in FRAM:
+        if start <= address < end:
+            return 'fram'
+    return None
+
+
+def subsystem(obj, library):
+    if library or '.a(' in obj or '.lib' in obj:
+        return 'rts/driverlib'
+    name = os.path.basename(obj)
+    return re.sub(r'(\.c)?\.(o|obj)$', '', name)
+
+
+def parse(path):
+    usage = defaultdict(lambda: {'sram': 0, 'fram': 0})
+    outputs = {}
+    strays = []
+    stack = 0
+    output = None
+    pending = None
+    active = False
+    ti = False
+
+    with open(path, errors='replace') as f:
+        for line in f:
+            if 'SECTION ALLOCATION MAP' in line:
+                active, ti = True, True
+                continue
+            if 'Linker script and memory map' in line:
+                active, ti = True, False
+                continue
+            if ti and ('SEGMENT ATTRIBUTE MAP' in line or 'GLOBAL SYMBOLS' in line):
+                active = False
+            if not active:
+                continue
+
+            # Output sections start in column 0, input sections are
+            # indented. msp430-elf-ld puts a long name on a line of its own
+            fields = line.split()
+            placed = None
+            if line.startswith('.'):
+                output, pending = fields[0], None
+                if len(fields) >= (4 if ti else 3):
+                    placed = fields[2:4] if ti else fields[1:3]
+                elif not ti and len(fields) == 1:
+                    pending = output
+            elif pending and len(fields) >= 2 and fields[0].startswith('0x'):
+                placed, pending = fields[0:2], None
+            if placed:
+                try:
+                    origin, length = int(placed[0], 16), int(placed[1], 16)
+                except ValueError:
+                    origin, length = None, 0
+                if output == '.stack':
+                    stack = length
+                elif length and not UNLOADED.match(output):
+                    outputs[output] = (origin, length)
+                    if region(origin) is None:
+                        strays.append((output, origin, length, None))
+
+            if ti:
+                match = TI_INPUT.match(line)
+                if not match:
+                    continue
+                address, size = int(match.group(1), 16), int(match.group(2), 16)
+                library, obj = match.group(3), match.group(4)
+            else:
+                match = GNU_INPUT.match(line)
+                if not match:
+                    continue
+                address, size = int(match.group(2), 16), int(match.group(3), 16)
+                library, obj = None, match.group(4)
+
+            if size == 0 or output == '.stack' or UNLOADED.match(output or ''):
+                continue
+            where = region(address)
+            if where is None:
+                strays.append((output, address, size, obj))
+                continue
+            usage[subsystem(obj, library)][where] += size
+
+    return usage, outputs, strays, stack
+
+
+def main():
+    parser = argparse.ArgumentParser(description='SRAM/FRAM budget report from a linker map.')
+    parser.add_argument('map', help='linker .map file')
+    parser.add_argument('--min-stack', type=int, default=default_threshold(),
+                        help='fail when less SRAM than this is left for the stack')
+    args = parser.parse_args()
+
+    usage, outputs, strays, stack = parse(args.map)
+    if not usage:
+        print('mem_report: no sections found in %s' % args.map)
+        return 2
+
+    if strays:
+        # An output section's own line only when none of its inputs said
+        named = set(output for output, address, size, obj in strays if obj)
+        strays = [stray for stray in strays if stray[3] or stray[0] not in named]
+        for output, address, size, obj in strays:
+            print('mem_report: %s%s, %d bytes at 0x%05X, is outside SRAM and FRAM'
+                  % (output, (' from %s' % obj) if obj else '', size, address))
+        print('mem_report: FAIL, sections outside every known region')
+        return 3
+
+    sram = {name: length for name, (origin, length) in outputs.items()
+            if region(origin) == 'sram'}
+    sram_total = sum(sram.values())
+    fram_total = sum(u['fram'] for u in usage.values())
+    headroom = (SRAM[1] - SRAM[0]) - sram_total
+    prefixes = budgets()
+
+    print('%-16s %8s %8s' % ('subsystem', 'SRAM', 'FRAM'))
+    for name in sorted(usage, key=lambda n: (-usage[n]['sram'], n)):
+        print('%-16s %8d %8d%s' % (name, usage[name]['sram'], usage[name]['fram'],
+              '  no SRAM budget' if usage[name]['sram'] and
+              not budgeted(name, prefixes) else ''))
+    print('%-16s %8d %8d' % ('total', sum(u['sram'] for u in usage.values()),
+                             fram_total))
+    print()
+    for name in sorted(sram, key=lambda n: -sram[n]):
+        print('%-16s %8d' % (name, sram[name]))
+    print('%-16s %8d' % ('SRAM sections', sram_total))
+    print()
+    print('SRAM left for the stack: %d bytes (linker reserves %d, need %d)'
+          % (headroom, stack, args.min_stack))
+
+    if headroom < args.min_stack:
+        print('mem_report: FAIL, SRAM stack headroom below %d bytes' % args.min_stack)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -19,29 +19,29 @@
 //#pragma vector = ADC12_VECTOR                                                   // ADC
 #pragma vector = AES256_VECTOR                                                  // AES256
 #pragma vector = COMP_E_VECTOR                                                  // Comparator E
-#pragma vector = DMA_VECTOR                                                     // DMA
+//#pragma vector = DMA_VECTOR                                                     // DMA
 #pragma vector = ESCAN_IF_VECTOR                                                // Extended Scan IF
 #pragma vector = LCD_C_VECTOR                                                   // LCD C
-#pragma vector = PORT1_VECTOR                                                   // Port 1
-#pragma vector = PORT2_VECTOR                                                   // Port 2
+//#pragma vector = PORT1_VECTOR                                                   // Port 1
+//#pragma vector = PORT2_VECTOR                                                   // Port 2
 #pragma vector = PORT3_VECTOR                                                   // Port 3
 #pragma vector = PORT4_VECTOR                                                   // Port 4
 #pragma vector = RESET_VECTOR                                                   // Reset
 #pragma vector = RTC_VECTOR                                                     // RTC
 #pragma vector = SYSNMI_VECTOR                                                  // System Non-maskable
-#pragma vector = TIMER0_A0_VECTOR                                               // Timer0_A5 CC0
-#pragma vector = TIMER0_A1_VECTOR                                               // Timer0_A5 CC1-4, TA
+//#pragma vector = TIMER0_A0_VECTOR                                               // Timer0_A5 CC0
+//#pragma vector = TIMER0_A1_VECTOR                                               // Timer0_A5 CC1-4, TA
 #pragma vector = TIMER0_B0_VECTOR                                               // Timer0_B3 CC0
 #pragma vector = TIMER0_B1_VECTOR                                               // Timer0_B3 CC1-2, TB
-#pragma vector = TIMER1_A0_VECTOR                                               // Timer1_A3 CC0
+//#pragma vector = TIMER1_A0_VECTOR                                               // Timer1_A3 CC0
 #pragma vector = TIMER1_A1_VECTOR                                               // Timer1_A3 CC1-2, TA1
 #pragma vector = TIMER2_A0_VECTOR                                               // Timer2_A3 CC0
 #pragma vector = TIMER2_A1_VECTOR                                               // Timer2_A3 CC1, TA
 #pragma vector = TIMER3_A0_VECTOR                                               // Timer3_A2 CC0
-#pragma vector = TIMER3_A1_VECTOR                                               // Timer3_A2 CC1, TA
+//#pragma vector = TIMER3_A1_VECTOR                                               // Timer3_A2 CC1, TA
 #pragma vector = UNMI_VECTOR                                                    // User Non-maskable
 #pragma vector = USCI_A0_VECTOR                                                 // USCI A0 Receive/Transmit
-#pragma vector = USCI_A1_VECTOR                                                 // USCI A1 Receive/Transmit
+//#pragma vector = USCI_A1_VECTOR                                                 // USCI A1 Receive/Transmit
 #pragma vector = USCI_B0_VECTOR                                                 // USCI B0 Receive/Transmit
 #pragma vector = USCI_B1_VECTOR                                                 // USCI B1 Receive/Transmit
 //#pragma vector = WDT_VECTOR                                                     // Watchdog Timer
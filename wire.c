@@ -0,0 +1,172 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Record framing for the data link.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#include "wire.h"
+
+#define WIRE_STATE_SYNC0    0
+#define WIRE_STATE_SYNC1    1
+#define WIRE_STATE_TYPE     2
+#define WIRE_STATE_LENGTH   3
+#define WIRE_STATE_PAYLOAD  4
+#define WIRE_STATE_CHECK0   5
+#define WIRE_STATE_CHECK1   6
+
+/*
+ * Both sums come in below 255, so one subtraction does for % 255.
+ * The MSP430 has no hardware divider and ADC12ISR runs this over every
+ * byte it sends.
+ */
+static uint16_t Wire_Fletcher(uint16_t checksum, uint8_t byte)
+{
+    uint16_t sum1 = (checksum & 0xFF) + byte;
+    uint16_t sum2 = checksum >> 8;
+
+    if (sum1 >= 255)
+    {
+        sum1 -= 255;
+    }
+    sum2 += sum1;
+    if (sum2 >= 255)
+    {
+        sum2 -= 255;
+    }
+
+    return (sum2 << 8) | sum1;
+}
+
+/*
+ * Encodes one record into out, which must hold length + WIRE_OVERHEAD
+ * bytes. Returns the number of bytes written.
+ */
+uint16_t Wire_Encode(uint8_t *out, uint8_t type,
+                     const uint8_t *payload, uint8_t length)
+{
+    uint16_t checksum = 0;
+    uint16_t i;
+
+    out[0] = WIRE_SYNC0;
+    out[1] = WIRE_SYNC1;
+    out[2] = type;
+    out[3] = length;
+    checksum = Wire_Fletcher(checksum, type);
+    checksum = Wire_Fletcher(checksum, length);
+
+    for (i = 0; i < length; i++)
+    {
+        out[4 + i] = payload[i];
+        checksum = Wire_Fletcher(checksum, payload[i]);
+    }
+
+    Wire_Put_U16(&out[4 + length], checksum);
+
+    return length + WIRE_OVERHEAD;
+}
+
+void Wire_Decoder_Reset(Wire_Decoder *decoder)
+{
+    decoder->state = WIRE_STATE_SYNC0;
+}
+
+/*
+ * Feeds one byte to the decoder. Returns 1 when a complete record with
+ * a good checksum is available in decoder->type/length/payload, -1 on a
+ * checksum or length error, 0 otherwise. Resynchronizes on its own.
+ */
+int Wire_Decode_Byte(Wire_Decoder *decoder, uint8_t byte)
+{
+    switch (decoder->state)
+    {
+        case WIRE_STATE_SYNC0:
+            if (byte == WIRE_SYNC0)
+            {
+                decoder->state = WIRE_STATE_SYNC1;
+            }
+            break;
+        case WIRE_STATE_SYNC1:
+            if (byte == WIRE_SYNC1)
+            {
+                decoder->state = WIRE_STATE_TYPE;
+            }
+            else if (byte != WIRE_SYNC0)
+            {
+                decoder->state = WIRE_STATE_SYNC0;
+            }
+            break;
+        case WIRE_STATE_TYPE:
+            decoder->type = byte;
+            decoder->checksum = Wire_Fletcher(0, byte);
+            decoder->state = WIRE_STATE_LENGTH;
+            break;
+        case WIRE_STATE_LENGTH:
+            if (byte > WIRE_MAX_PAYLOAD)
+            {
+                decoder->state = WIRE_STATE_SYNC0;
+                return -1;
+            }
+            decoder->length = byte;
+            decoder->count = 0;
+            decoder->checksum = Wire_Fletcher(decoder->checksum, byte);
+            decoder->state = (byte == 0) ? WIRE_STATE_CHECK0 : WIRE_STATE_PAYLOAD;
+            break;
+        case WIRE_STATE_PAYLOAD:
+            decoder->payload[decoder->count++] = byte;
+            decoder->checksum = Wire_Fletcher(decoder->checksum, byte);
+            if (decoder->count == decoder->length)
+            {
+                decoder->state = WIRE_STATE_CHECK0;
+            }
+            break;
+        case WIRE_STATE_CHECK0:
+            if (byte != (decoder->checksum & 0xFF))
+            {
+                decoder->state = WIRE_STATE_SYNC0;
+                return -1;
+            }
+            decoder->state = WIRE_STATE_CHECK1;
+            break;
+        case WIRE_STATE_CHECK1:
+            decoder->state = WIRE_STATE_SYNC0;
+            if (byte != (decoder->checksum >> 8))
+            {
+                return -1;
+            }
+            return 1;
+        default:
+            decoder->state = WIRE_STATE_SYNC0;
+            break;
+    }
+
+    return 0;
+}
+
+void Wire_Put_U16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+void Wire_Put_U32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+uint16_t Wire_Get_U16(const uint8_t *in)
+{
+    return (uint16_t)in[0] | ((uint16_t)in[1] << 8);
+}
+
+uint32_t Wire_Get_U32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) |
+           ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
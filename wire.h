@@ -0,0 +1,116 @@
+/**
+ * LICENSE: Apache 2.0
+ * Reference: github.com/zthurman/pocdaq
+ *
+ * Record framing for the data link.
+ *
+ * Every record on the wire is:
+ *
+ *   0xA5 0x5A | type | length | payload[length] | fletcher-16 (LE)
+ *
+ * The checksum covers type, length and payload. All multi-byte payload
+ * fields are little endian. A capture file is simply the byte stream
+ * read off the link, so the host side parses both with the same
+ * decoder.
+ *
+ * Portable, shared with the host tools.
+ *
+ */
+
+#ifndef AI_SCANNER_WIRE_H_
+#define AI_SCANNER_WIRE_H_
+
+#include <stdint.h>
+
+#define WIRE_SYNC0          0xA5
+#define WIRE_SYNC1          0x5A
+#define WIRE_OVERHEAD       6
+#define WIRE_MAX_PAYLOAD    64
+
+/*
+ * Record types.
+ */
+#define WIRE_TYPE_RAW_SCAN      0x01    /* u32 sequence, u16 channel mask,
+                                           u8 class mask, u16 sample[16]     */
+#define WIRE_TYPE_CAPTURE_START 0x02    /* u16 frames, u8 channels             */
+#define WIRE_TYPE_CAPTURE_END   0x03    /* u16 frames sent                     */
+#define WIRE_TYPE_SCAN          0x04    /* u32 sequence, u16 channel mask,
+                                           u8 class mask, u16 sample per
+                                           channel in the mask               */
+#define WIRE_TYPE_CONTROL       0x05    /* u8 loop, u8 flags (bit 0 auto,
+                                           bit 1 saturated), u16 output,
+                                           u16 latency min, max, mean,
+                                           u16 overruns, u32 runs,
+                                           u16 last input                    */
+#define WIRE_TYPE_BURST_START   0x06    /* u8 channel, u16 samples,
+                                           u16 overflows, u32 start ticks,
+                                           u32 elapsed ticks, u32 rate Hz    */
+#define WIRE_TYPE_BURST_DATA    0x07    /* u16 offset, u16 sample[<= 28]     */
+#define WIRE_TYPE_BURST_END     0x08    /* u16 samples sent                  */
+#define WIRE_TYPE_COMMAND_ACK   0x09    /* u8 transaction, u8 command type,
+                                           u8 status, u8 detail,
+                                           u16 achievable slot Hz            */
+#define WIRE_TYPE_SCHED_CONFIG  0x0A    /* u8 transaction, u8 flags (bit 0
+                                           saved to FRAM, bit 1 query),
+                                           u16 slot Hz, u16 divider[4],
+                                           u8 sample hold[2], u8 class[16],
+                                           u16 slots, u16 busiest slot
+                                           channels, u32 worst slot ns,
+                                           u16 achievable slot Hz,
+                                           u32 class rate mHz[4], measured
+                                           ADC12ISR: u32 worst slot cycles,
+                                           u16 its channels, u16 cycles
+                                           past the model                    */
+#define WIRE_TYPE_HEALTH        0x0B    /* i16 temperature 0.01 degC,
+                                           u16 AVcc mV, u16 raw temperature,
+                                           u16 raw AVcc/2, u16 compensated
+                                           channel mask, u16 deferrals,
+                                           u16 scan overruns, u16 emit drops,
+                                           u16 triggers lost to a reading    */
+#define WIRE_TYPE_DUTY          0x0C    /* last duty cycle: u16 scans,
+                                           u32 awake us, u32 CPU us,
+                                           u32 ADC us, u32 sleep us,
+                                           u32 cycle nJ, u32 nJ per scan,
+                                           u32 average nA; CPU us has the
+                                           link TX ISR and ADC us all of
+                                           it from the model, not measured   */
+#define WIRE_TYPE_SYNC_SCAN     0x0D    /* u8 node, u8 sync flags, u32 sync
+                                           count, i16 skew ticks, then a
+                                           WIRE_TYPE_SCAN payload            */
+#define WIRE_TYPE_RBE_SCAN      0x0E    /* u32 sequence, u16 changed channel
+                                           mask, u16 sample per channel in
+                                           the mask                          */
+
+/*
+ * Commands, host to node. Each one is answered with a
+ * WIRE_TYPE_COMMAND_ACK, see command.h.
+ */
+#define WIRE_TYPE_CMD_BEGIN     0x40    /* u8 transaction                    */
+#define WIRE_TYPE_CMD_SET       0x41    /* u8 transaction, then u8 key,
+                                           u16 value per setting, up to 21   */
+#define WIRE_TYPE_CMD_COMMIT    0x42    /* u8 transaction, u8 flags (bit 0
+                                           save to FRAM)                     */
+#define WIRE_TYPE_CMD_ABORT     0x43    /* u8 transaction                    */
+#define WIRE_TYPE_CMD_QUERY     0x44    /* none                              */
+
+typedef struct
+{
+    uint8_t state;
+    uint8_t type;
+    uint8_t length;
+    uint8_t count;
+    uint16_t checksum;
+    uint8_t payload[WIRE_MAX_PAYLOAD];
+} Wire_Decoder;
+
+uint16_t Wire_Encode(uint8_t *out, uint8_t type,
+                     const uint8_t *payload, uint8_t length);
+void Wire_Decoder_Reset(Wire_Decoder *decoder);
+int Wire_Decode_Byte(Wire_Decoder *decoder, uint8_t byte);
+
+void Wire_Put_U16(uint8_t *out, uint16_t value);
+void Wire_Put_U32(uint8_t *out, uint32_t value);
+uint16_t Wire_Get_U16(const uint8_t *in);
+uint32_t Wire_Get_U32(const uint8_t *in);
+
+#endif /* AI_SCANNER_WIRE_H_ */